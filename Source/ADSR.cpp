@@ -74,7 +74,15 @@ void ADSR::setSampleRate(float newSampleRate) {
     sampleRate = newSampleRate;
 }
 
+ADSR::State ADSR::getState() {
+    return state;
+}
+
 void ADSR::reset() {
     state = State::Idle;
     envelopeLevel = 0.0f;
 }
+
+bool ADSR::isActive() {
+    return state != State::Idle;
+}
@@ -34,6 +34,8 @@ public:
     void setReleaseTime(float releaseTimeSeconds);
     void setSampleRate(float newSampleRate);
     void reset();
+    bool isActive();
+    State getState();
 
 private:
     State state;
@@ -0,0 +1,175 @@
+/*
+  ==============================================================================
+
+    Analyzer.cpp
+    Created: 22 Oct 2026 10:41:03am
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#include "Analyzer.h"
+
+Analyzer::Analyzer(AudioTap& tap)
+    : tap(tap), incoming(AudioTap::capacity, 0.0f), history(fftSize, 0.0f), window(fftSize, 0.0f),
+    fftData(2 * fftSize, 0.0f), spectrum(fftSize / 2, -100.0f) {
+    for (int i = 0; i < fftSize; ++i) {
+        window[i] = 0.5f - 0.5f * std::cos(juce::MathConstants<float>::twoPi * static_cast<float>(i) / static_cast<float>(fftSize - 1));
+    }
+}
+
+Analyzer::~Analyzer() {
+    stopTimer();
+    tap.setEnabled(false);
+}
+
+void Analyzer::visibilityChanged() {
+    // Закрытая страница не должна стоить аудиопотоку ничего
+    tap.setEnabled(isVisible());
+    if (isVisible()) {
+        startTimerHz(frameRate);
+    }
+    else {
+        stopTimer();
+    }
+}
+
+juce::Rectangle<float> Analyzer::getScopeArea() {
+    auto bounds = getLocalBounds().toFloat().reduced(10.0f);
+    return bounds.removeFromLeft(bounds.getWidth() * 0.5f - 5.0f);
+}
+
+juce::Rectangle<float> Analyzer::getSpectrumArea() {
+    auto bounds = getLocalBounds().toFloat().reduced(10.0f);
+    return bounds.removeFromRight(bounds.getWidth() * 0.5f - 5.0f);
+}
+
+void Analyzer::timerCallback() {
+    int numRead = tap.pull(incoming.data(), static_cast<int>(incoming.size()));
+    if (numRead == 0) {
+        return;
+    }
+
+    if (numRead >= fftSize) {
+        std::copy(incoming.begin() + (numRead - fftSize), incoming.begin() + numRead, history.begin());
+    }
+    else {
+        std::move(history.begin() + numRead, history.end(), history.begin());
+        std::copy(incoming.begin(), incoming.begin() + numRead, history.end() - numRead);
+    }
+
+    // Перерисовываем только два окна, промежутки и фон страницы не трогаем
+    updateScope(getScopeArea());
+    updateSpectrum(getSpectrumArea());
+    repaint(getScopeArea().getSmallestIntegerContainer());
+    repaint(getSpectrumArea().getSmallestIntegerContainer());
+}
+
+void Analyzer::updateScope(juce::Rectangle<float> area) {
+    // Синхронизация по переходу через ноль вверх, чтобы периодический сигнал стоял на месте
+    int start = fftSize - scopeLength;
+    for (int i = start; i > start - scopeLength && i > 0; --i) {
+        if (history[i - 1] < 0.0f && history[i] >= 0.0f) {
+            start = i;
+            break;
+        }
+    }
+
+    scopePath.clear();
+    scopePath.preallocateSpace(3 * scopeLength);
+    float halfHeight = area.getHeight() * 0.5f;
+    for (int i = 0; i < scopeLength; ++i) {
+        float x = area.getX() + area.getWidth() * static_cast<float>(i) / static_cast<float>(scopeLength - 1);
+        float y = area.getCentreY() - juce::jlimit(-1.0f, 1.0f, history[start + i]) * halfHeight;
+        if (i == 0) {
+            scopePath.startNewSubPath(x, y);
+        }
+        else {
+            scopePath.lineTo(x, y);
+        }
+    }
+}
+
+void Analyzer::updateSpectrum(juce::Rectangle<float> area) {
+    juce::FloatVectorOperations::multiply(fftData.data(), history.data(), window.data(), fftSize);
+    std::fill(fftData.begin() + fftSize, fftData.end(), 0.0f);
+    fft.performFrequencyOnlyForwardTransform(fftData.data());
+
+    // Окно Ханна съедает половину амплитуды, синус полной шкалы даёт 0 дБ
+    const float gain = 4.0f / static_cast<float>(fftSize);
+    for (int bin = 0; bin < fftSize / 2; ++bin) {
+        float decibels = 20.0f * std::log10(juce::jmax(1.0e-5f, fftData[bin] * gain));
+        // пики держатся и спадают плавно, как у обычного анализатора
+        spectrum[bin] = juce::jmax(decibels, spectrum[bin] - 1.5f);
+    }
+
+    spectrumPath.clear();
+    int numPoints = juce::jmax(2, static_cast<int>(area.getWidth()));
+    spectrumPath.preallocateSpace(3 * numPoints);
+    double binsPerHz = fftSize / tap.getSampleRate();
+    for (int i = 0; i < numPoints; ++i) {
+        float proportion = static_cast<float>(i) / static_cast<float>(numPoints - 1);
+        double frequency = 20.0 * std::pow(1000.0, proportion);
+        double position = juce::jlimit(0.0, fftSize / 2 - 1.001, frequency * binsPerHz);
+        int bin = static_cast<int>(position);
+        float fraction = static_cast<float>(position - bin);
+        float level = spectrum[bin] + fraction * (spectrum[bin + 1] - spectrum[bin]);
+
+        float x = area.getX() + area.getWidth() * proportion;
+        float y = juce::jmap(juce::jlimit(-90.0f, 0.0f, level), -90.0f, 0.0f, area.getBottom(), area.getY());
+        if (i == 0) {
+            spectrumPath.startNewSubPath(x, y);
+        }
+        else {
+            spectrumPath.lineTo(x, y);
+        }
+    }
+}
+
+void Analyzer::resized() {
+    grid = juce::Image();
+}
+
+// Фон, сетка и подписи не меняются от кадра к кадру, поэтому живут в картинке
+void Analyzer::renderGrid(float scale) {
+    grid = juce::Image(juce::Image::ARGB, juce::jmax(1, juce::roundToInt(getWidth() * scale)),
+        juce::jmax(1, juce::roundToInt(getHeight() * scale)), true);
+    juce::Graphics g(grid);
+    g.addTransform(juce::AffineTransform::scale(scale));
+
+    auto scopeArea = getScopeArea();
+    auto spectrumArea = getSpectrumArea();
+
+    g.setColour(juce::Colours::black);
+    g.fillRect(scopeArea);
+    g.fillRect(spectrumArea);
+
+    g.setColour(juce::Colours::darkgrey);
+    g.drawHorizontalLine(static_cast<int>(scopeArea.getCentreY()), scopeArea.getX(), scopeArea.getRight());
+    for (float decibels = -80.0f; decibels < 0.0f; decibels += 20.0f) {
+        float y = juce::jmap(decibels, -90.0f, 0.0f, spectrumArea.getBottom(), spectrumArea.getY());
+        g.drawHorizontalLine(static_cast<int>(y), spectrumArea.getX(), spectrumArea.getRight());
+    }
+    for (float frequency : { 100.0f, 1000.0f, 10000.0f }) {
+        float x = spectrumArea.getX() + spectrumArea.getWidth() * std::log(frequency / 20.0f) / std::log(1000.0f);
+        g.drawVerticalLine(static_cast<int>(x), spectrumArea.getY(), spectrumArea.getBottom());
+    }
+
+    g.setColour(juce::Colours::lightgrey);
+    g.drawText("Scope", scopeArea.reduced(5.0f), juce::Justification::topLeft);
+    g.drawText("Spectrum", spectrumArea.reduced(5.0f), juce::Justification::topLeft);
+}
+
+void Analyzer::paint(juce::Graphics& g) {
+    float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    if (!grid.isValid() || grid.getWidth() != juce::roundToInt(getWidth() * scale)
+        || grid.getHeight() != juce::roundToInt(getHeight() * scale)) {
+        renderGrid(scale);
+    }
+    g.drawImage(grid, getLocalBounds().toFloat());
+
+    g.setColour(juce::Colours::lightgreen);
+    g.strokePath(scopePath, juce::PathStrokeType(1.5f));
+    g.setColour(juce::Colours::lightblue);
+    g.strokePath(spectrumPath, juce::PathStrokeType(1.5f));
+}
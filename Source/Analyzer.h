@@ -0,0 +1,52 @@
+/*
+  ==============================================================================
+
+    Analyzer.h
+    Created: 22 Oct 2026 10:41:03am
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+#include "AudioTap.h"
+
+// Осциллограф и спектр выхода. Всё считается на потоке сообщений по таймеру
+// с ограниченной частотой кадров; отвод включается, только пока страница видна.
+class Analyzer : public juce::Component, private juce::Timer {
+public:
+    static constexpr int fftOrder = 11;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int scopeLength = 512;
+    static constexpr int frameRate = 30;
+
+    Analyzer(AudioTap& tap);
+    ~Analyzer() override;
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+    void visibilityChanged() override;
+
+private:
+    AudioTap& tap;
+    juce::dsp::FFT fft{ fftOrder };
+
+    std::vector<float> incoming;
+    std::vector<float> history;
+    std::vector<float> window;
+    std::vector<float> fftData;
+    std::vector<float> spectrum;
+
+    juce::Path scopePath;
+    juce::Path spectrumPath;
+    juce::Image grid;
+
+    void timerCallback() override;
+    void updateScope(juce::Rectangle<float> area);
+    void updateSpectrum(juce::Rectangle<float> area);
+    void renderGrid(float scale);
+    juce::Rectangle<float> getScopeArea();
+    juce::Rectangle<float> getSpectrumArea();
+};
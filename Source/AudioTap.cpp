@@ -0,0 +1,73 @@
+/*
+  ==============================================================================
+
+    AudioTap.cpp
+    Created: 22 Oct 2026 10:14:55am
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#include "AudioTap.h"
+
+AudioTap::AudioTap()
+    : ring(capacity, 0.0f) {}
+
+void AudioTap::setEnabled(bool shouldBeEnabled) {
+    if (shouldBeEnabled && !enabled.load()) {
+        // писатель сейчас молчит, так что старые данные можно сбросить безопасно
+        fifo.reset();
+    }
+    enabled.store(shouldBeEnabled);
+}
+
+bool AudioTap::isEnabled() {
+    return enabled.load();
+}
+
+void AudioTap::setSampleRate(double newSampleRate) {
+    sampleRate.store(newSampleRate);
+}
+
+double AudioTap::getSampleRate() {
+    return sampleRate.load();
+}
+
+void AudioTap::push(const juce::AudioBuffer<float>& buffer) {
+    if (!enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    // Если читатель отстал, лишнее просто отбрасывается - ждать его нельзя
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(buffer.getNumSamples(), start1, size1, start2, size2);
+
+    int numChannels = juce::jmin(2, buffer.getNumChannels());
+    float gain = numChannels > 1 ? 0.5f : 1.0f;
+    auto writeRegion = [&](int start, int size, int offset) {
+        juce::FloatVectorOperations::copyWithMultiply(ring.data() + start, buffer.getReadPointer(0, offset), gain, size);
+        if (numChannels > 1) {
+            juce::FloatVectorOperations::addWithMultiply(ring.data() + start, buffer.getReadPointer(1, offset), gain, size);
+        }
+    };
+    if (size1 > 0) {
+        writeRegion(start1, size1, 0);
+    }
+    if (size2 > 0) {
+        writeRegion(start2, size2, size1);
+    }
+    fifo.finishedWrite(size1 + size2);
+}
+
+int AudioTap::pull(float* destination, int maxSamples) {
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(maxSamples, start1, size1, start2, size2);
+    if (size1 > 0) {
+        juce::FloatVectorOperations::copy(destination, ring.data() + start1, size1);
+    }
+    if (size2 > 0) {
+        juce::FloatVectorOperations::copy(destination + size1, ring.data() + start2, size2);
+    }
+    fifo.finishedRead(size1 + size2);
+    return size1 + size2;
+}
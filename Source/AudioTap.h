@@ -0,0 +1,37 @@
+/*
+  ==============================================================================
+
+    AudioTap.h
+    Created: 22 Oct 2026 10:14:55am
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <vector>
+
+// Отвод выхода для визуализации: аудиопоток пишет моно-сумму в кольцо AbstractFifo,
+// интерфейс забирает её по таймеру. Пока отвод выключен, push сразу выходит.
+class AudioTap {
+public:
+    static constexpr int capacity = 1 << 14;
+
+    AudioTap();
+
+    void setEnabled(bool shouldBeEnabled);
+    bool isEnabled();
+    void setSampleRate(double newSampleRate);
+    double getSampleRate();
+
+    void push(const juce::AudioBuffer<float>& buffer);
+    int pull(float* destination, int maxSamples);
+
+private:
+    juce::AbstractFifo fifo{ capacity };
+    std::vector<float> ring;
+    std::atomic<bool> enabled{ false };
+    std::atomic<double> sampleRate{ 48000.0 };
+};
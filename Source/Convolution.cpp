@@ -0,0 +1,408 @@
+/*
+  ==============================================================================
+
+    Convolution.cpp
+    Created: 18 Oct 2026 2:41:17pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#include "Convolution.h"
+
+ConvolutionStage::ConvolutionStage(const std::vector<float>& impulse, int begin, int end, int partitionOrder, int blockSize)
+    : partitionSize(1 << partitionOrder), fftSize(2 << partitionOrder), numBins((1 << partitionOrder) + 1),
+    blockSize(blockSize), outputSlotOffset(begin >> partitionOrder) {
+    jassert(begin % partitionSize == 0 && begin >= partitionSize);
+
+    int length = std::max(0, std::min(end, static_cast<int>(impulse.size())) - begin);
+    numPartitions = (length + partitionSize - 1) / partitionSize;
+
+    // Кадр j нужен на выходе к моменту j * P + begin, а готов вход к (j + 1) * P,
+    // поэтому запас в (begin - P) сэмплов позволяет размазать умножения по блокам.
+    numSteps = std::max(1, std::min(partitionSize / blockSize, (begin - partitionSize) / blockSize + 1));
+    partitionsPerStep = (numPartitions + numSteps - 1) / std::max(1, numSteps);
+
+    if (numPartitions == 0) {
+        return;
+    }
+
+    fft = std::make_unique<juce::dsp::FFT>(partitionOrder + 1);
+    fftBuffer.resize(2 * fftSize, 0.0f);
+    partitions.resize(numPartitions * 2 * numBins, 0.0f);
+    frequencyDelayLine.resize(numPartitions * 2 * numBins, 0.0f);
+    accumulator.resize(2 * numBins, 0.0f);
+    window.resize(fftSize, 0.0f);
+    output.resize(2 * partitionSize, 0.0f);
+
+    for (int k = 0; k < numPartitions; ++k) {
+        std::fill(fftBuffer.begin(), fftBuffer.end(), 0.0f);
+        int start = begin + k * partitionSize;
+        int count = std::min(partitionSize, begin + length - start);
+        std::copy(impulse.begin() + start, impulse.begin() + start + count, fftBuffer.begin());
+        fft->performRealOnlyForwardTransform(fftBuffer.data(), true);
+        std::copy(fftBuffer.begin(), fftBuffer.begin() + 2 * numBins, partitions.begin() + k * 2 * numBins);
+    }
+}
+
+void ConvolutionStage::pushBlock(const float* input) {
+    if (numPartitions == 0) {
+        return;
+    }
+    std::copy(input, input + blockSize, window.begin() + partitionSize + fill);
+    fill += blockSize;
+
+    if (step >= 0) {
+        runStep();
+    }
+    if (fill == partitionSize) {
+        fill = 0;
+        startFrame();
+    }
+}
+
+float ConvolutionStage::nextSample() {
+    if (numPartitions == 0) {
+        return 0.0f;
+    }
+    float sample = output[readPos];
+    if (++readPos == 2 * partitionSize) {
+        readPos = 0;
+    }
+    return sample;
+}
+
+void ConvolutionStage::reset() {
+    std::fill(window.begin(), window.end(), 0.0f);
+    std::fill(frequencyDelayLine.begin(), frequencyDelayLine.end(), 0.0f);
+    std::fill(accumulator.begin(), accumulator.end(), 0.0f);
+    std::fill(output.begin(), output.end(), 0.0f);
+    fill = 0;
+    step = -1;
+    fdlHead = 0;
+    frameIndex = 0;
+    readPos = 0;
+}
+
+void ConvolutionStage::startFrame() {
+    fdlHead = (fdlHead == 0 ? numPartitions : fdlHead) - 1;
+
+    std::copy(window.begin(), window.end(), fftBuffer.begin());
+    std::fill(fftBuffer.begin() + fftSize, fftBuffer.end(), 0.0f);
+    fft->performRealOnlyForwardTransform(fftBuffer.data(), true);
+    std::copy(fftBuffer.begin(), fftBuffer.begin() + 2 * numBins, frequencyDelayLine.begin() + fdlHead * 2 * numBins);
+
+    // overlap-save: вторая половина окна становится первой для следующего кадра
+    std::copy(window.begin() + partitionSize, window.end(), window.begin());
+
+    std::fill(accumulator.begin(), accumulator.end(), 0.0f);
+    step = 0;
+    runStep();
+}
+
+void ConvolutionStage::runStep() {
+    int first = step * partitionsPerStep;
+    int last = std::min(numPartitions, first + partitionsPerStep);
+    float* acc = accumulator.data();
+
+    for (int k = first; k < last; ++k) {
+        int slot = (fdlHead + k) % numPartitions;
+        const float* x = frequencyDelayLine.data() + slot * 2 * numBins;
+        const float* h = partitions.data() + k * 2 * numBins;
+        for (int b = 0; b < 2 * numBins; b += 2) {
+            acc[b] += x[b] * h[b] - x[b + 1] * h[b + 1];
+            acc[b + 1] += x[b] * h[b + 1] + x[b + 1] * h[b];
+        }
+    }
+
+    if (++step < numSteps) {
+        return;
+    }
+    step = -1;
+
+    std::copy(accumulator.begin(), accumulator.end(), fftBuffer.begin());
+    std::fill(fftBuffer.begin() + 2 * numBins, fftBuffer.end(), 0.0f);
+    fft->performRealOnlyInverseTransform(fftBuffer.data());
+
+    int slot = ((frameIndex + outputSlotOffset) & 1) * partitionSize;
+    std::copy(fftBuffer.begin() + partitionSize, fftBuffer.begin() + fftSize, output.begin() + slot);
+    frameIndex ^= 1;
+}
+
+ConvolutionEngine::ConvolutionEngine(const std::vector<float>& impulse)
+    : head(blockSize, 0.0f), history(2 * blockSize, 0.0f), block(blockSize, 0.0f),
+    early(impulse, blockSize, 2 << tailOrder, blockOrder, blockSize),
+    late(impulse, 2 << tailOrder, static_cast<int>(impulse.size()), tailOrder, blockSize) {
+    // голова хранится развёрнутой, чтобы свёртка шла по непрерывному куску истории
+    for (int i = 0; i < blockSize && i < static_cast<int>(impulse.size()); ++i) {
+        head[blockSize - 1 - i] = impulse[i];
+    }
+}
+
+float ConvolutionEngine::processSample(float input) {
+    history[historyPos] = input;
+    history[historyPos + blockSize] = input;
+    historyPos = (historyPos + 1) % blockSize;
+
+    const float* recent = history.data() + historyPos;
+    float sample = 0.0f;
+    for (int i = 0; i < blockSize; ++i) {
+        sample += head[i] * recent[i];
+    }
+    sample += early.nextSample() + late.nextSample();
+
+    block[blockPos] = input;
+    if (++blockPos == blockSize) {
+        blockPos = 0;
+        early.pushBlock(block.data());
+        late.pushBlock(block.data());
+    }
+    return sample;
+}
+
+void ConvolutionEngine::reset() {
+    std::fill(history.begin(), history.end(), 0.0f);
+    std::fill(block.begin(), block.end(), 0.0f);
+    historyPos = 0;
+    blockPos = 0;
+    early.reset();
+    late.reset();
+}
+
+Convolution::Convolution(float mix, float size, float sampleRate)
+    : mix(mix), size(size), sampleRate(sampleRate), requestedSampleRate(sampleRate) {
+    loader->add(*this);
+    setSize(size);
+}
+
+Convolution::~Convolution() {
+    // После remove загрузчик уже не отдаст этому экземпляру новый движок
+    loader->remove(*this);
+    delete pending.exchange(nullptr);
+    delete retired.exchange(nullptr);
+}
+
+void Convolution::prepare(double newSampleRate) {
+    if (engine != nullptr) {
+        engine->reset();
+    }
+    if (static_cast<float>(newSampleRate) != sampleRate) {
+        sampleRate = static_cast<float>(newSampleRate);
+        loader->requestReload(*this);
+    }
+}
+
+bool Convolution::isReady() {
+    if (builtGeneration.load() != requestedGeneration.load()) {
+        return false;
+    }
+    // Готовый движок ещё ждёт, пока загрузчик заберёт прошлый, - processBlock его пока не возьмёт
+    if (pending.load() != nullptr) {
+        if (retired.load() != nullptr) {
+            loader->notify();
+            return false;
+        }
+        return true;
+    }
+    return engine != nullptr;
+}
+
+void Convolution::processBlock(juce::AudioBuffer<float>& buffer) {
+    // Новый движок подхватываем, только когда фоновый поток уже забрал предыдущий на удаление
+    if (retired.load() == nullptr) {
+        if (auto* next = pending.exchange(nullptr)) {
+            retired.store(engine.release());
+            engine.reset(next);
+            loader->notify();
+        }
+    }
+    if (engine == nullptr) {
+        return;
+    }
+
+    float* channelData = buffer.getWritePointer(0);
+    for (int i = 0; i < buffer.getNumSamples(); ++i) {
+        float wet = engine->processSample(channelData[i]);
+        channelData[i] = channelData[i] * (1.0f - mix) + wet * mix;
+    }
+
+    for (int channel = 1; channel < buffer.getNumChannels(); ++channel) {
+        std::copy(channelData, channelData + buffer.getNumSamples(), buffer.getWritePointer(channel));
+    }
+}
+
+void Convolution::setSize(float newSize) {
+    size = newSize;
+    pendingSize.store(newSize);
+    ++requestedGeneration;
+    sizeRequested.store(true);
+    loader->notify();
+}
+
+void Convolution::loadImpulseResponse(const juce::File& file) {
+    loader->requestFile(*this, file);
+}
+
+ConvolutionLoader::ConvolutionLoader()
+    : juce::Thread("Convolution IR loader") {
+    startThread(juce::Thread::Priority::background);
+}
+
+ConvolutionLoader::~ConvolutionLoader() {
+    stopThread(2000);
+}
+
+void ConvolutionLoader::add(Convolution& convolution) {
+    const juce::ScopedLock sl(lock);
+    clients.push_back(&convolution);
+}
+
+void ConvolutionLoader::remove(Convolution& convolution) {
+    const juce::ScopedLock sl(lock);
+    clients.erase(std::remove(clients.begin(), clients.end(), &convolution), clients.end());
+}
+
+void ConvolutionLoader::requestFile(Convolution& convolution, const juce::File& file) {
+    {
+        const juce::ScopedLock sl(lock);
+        // Файл, заказанный позже размера, важнее него
+        convolution.sizeRequested.store(false);
+        convolution.requestedFile = file;
+        convolution.requestedSampleRate = convolution.sampleRate;
+        convolution.hasRequest = true;
+        ++convolution.requestedGeneration;
+    }
+    notify();
+}
+
+void ConvolutionLoader::requestReload(Convolution& convolution) {
+    // Та же ИХ, что загружена последней, но на новой частоте
+    {
+        const juce::ScopedLock sl(lock);
+        convolution.requestedSampleRate = convolution.sampleRate;
+        convolution.hasRequest = true;
+        ++convolution.requestedGeneration;
+    }
+    notify();
+}
+
+void ConvolutionLoader::run() {
+    while (!threadShouldExit()) {
+        Convolution* client = nullptr;
+        int generation = 0;
+        float size = 0.0f;
+        float sampleRate = 0.0f;
+        juce::File file;
+        {
+            const juce::ScopedLock sl(lock);
+            for (auto* convolution : clients) {
+                delete convolution->retired.exchange(nullptr);
+                if (convolution->sizeRequested.exchange(false)) {
+                    convolution->requestedSize = convolution->pendingSize.load();
+                    convolution->requestedFile = juce::File();
+                    convolution->hasRequest = true;
+                }
+                if (client == nullptr && convolution->hasRequest) {
+                    client = convolution;
+                    size = convolution->requestedSize;
+                    sampleRate = convolution->requestedSampleRate;
+                    file = convolution->requestedFile;
+                    generation = convolution->requestedGeneration.load();
+                    convolution->hasRequest = false;
+                }
+            }
+        }
+
+        if (client == nullptr) {
+            wait(-1);
+            continue;
+        }
+
+        // Строится без lock: заявки и удаление экземпляров в это время не ждут
+        auto impulse = file.existsAsFile() ? readImpulseFile(file, sampleRate) : makeSyntheticImpulse(size, sampleRate);
+        if (impulse.empty()) {
+            // Файл не прочитался - остаётся прежний движок, ждать больше нечего
+            const juce::ScopedLock sl(lock);
+            if (std::find(clients.begin(), clients.end(), client) != clients.end()) {
+                client->builtGeneration.store(generation);
+            }
+            continue;
+        }
+
+        double energy = 0.0;
+        for (float h : impulse) {
+            energy += h * h;
+        }
+        if (energy > 0.0) {
+            float gain = static_cast<float>(1.0 / std::sqrt(energy));
+            for (float& h : impulse) {
+                h *= gain;
+            }
+        }
+
+        auto next = std::make_unique<ConvolutionEngine>(impulse);
+        const juce::ScopedLock sl(lock);
+        if (std::find(clients.begin(), clients.end(), client) != clients.end()) {
+            // Если аудиопоток ещё не забрал прошлый движок, он просто заменяется новым
+            delete client->pending.exchange(next.release());
+            client->builtGeneration.store(generation);
+        }
+    }
+}
+
+std::vector<float> ConvolutionLoader::makeSyntheticImpulse(float size, float sampleRate) {
+    float decaySeconds = 0.2f + 9.8f * juce::jlimit(0.0f, 1.0f, size);
+    int length = static_cast<int>(decaySeconds * sampleRate);
+    std::vector<float> impulse(length);
+
+    juce::Random random(0x5f3759df);
+    float decayPerSample = std::log(0.001f) / static_cast<float>(length);
+    float lowpass = 0.0f;
+    for (int i = 0; i < length; ++i) {
+        // хвост постепенно темнеет, как у настоящего зала
+        float damping = 0.2f + 0.75f * static_cast<float>(i) / static_cast<float>(length);
+        float noise = random.nextFloat() * 2.0f - 1.0f;
+        lowpass = noise * (1.0f - damping) + lowpass * damping;
+        impulse[i] = lowpass * std::exp(decayPerSample * static_cast<float>(i));
+    }
+    return impulse;
+}
+
+std::vector<float> ConvolutionLoader::readImpulseFile(const juce::File& file, float sampleRate) {
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+    if (reader == nullptr || reader->lengthInSamples <= 0) {
+        return {};
+    }
+
+    int maxLength = static_cast<int>(10.0 * reader->sampleRate);
+    int sourceLength = static_cast<int>(std::min<juce::int64>(reader->lengthInSamples, maxLength));
+    juce::AudioBuffer<float> source(static_cast<int>(reader->numChannels), sourceLength);
+    reader->read(&source, 0, sourceLength, 0, true, true);
+
+    // ИХ моно: каналы файла усредняются
+    std::vector<float> mono(sourceLength, 0.0f);
+    for (int channel = 0; channel < source.getNumChannels(); ++channel) {
+        const float* data = source.getReadPointer(channel);
+        for (int i = 0; i < sourceLength; ++i) {
+            mono[i] += data[i] / static_cast<float>(source.getNumChannels());
+        }
+    }
+
+    double ratio = reader->sampleRate / sampleRate;
+    if (std::abs(ratio - 1.0) < 1.0e-6) {
+        return mono;
+    }
+
+    int length = static_cast<int>(sourceLength / ratio);
+    std::vector<float> impulse(length);
+    for (int i = 0; i < length; ++i) {
+        double position = i * ratio;
+        int index = static_cast<int>(position);
+        float frac = static_cast<float>(position - index);
+        float next = index + 1 < sourceLength ? mono[index + 1] : 0.0f;
+        impulse[i] = mono[index] + frac * (next - mono[index]);
+    }
+    return impulse;
+}
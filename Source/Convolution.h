@@ -0,0 +1,145 @@
+/*
+  ==============================================================================
+
+    Convolution.h
+    Created: 18 Oct 2026 2:41:17pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Одна ступень равномерно разбитой свёртки (overlap-save) с частотной линией задержки.
+// Ступень покрывает отводы ИХ [begin, end). Если begin даёт запас по времени,
+// работа над кадром растягивается на несколько вызовов pushBlock.
+class ConvolutionStage {
+public:
+    ConvolutionStage(const std::vector<float>& impulse, int begin, int end, int partitionOrder, int blockSize);
+
+    void pushBlock(const float* input);
+    float nextSample();
+    void reset();
+    bool isEmpty() const { return numPartitions == 0; }
+
+private:
+    int partitionSize;
+    int fftSize;
+    int numBins;
+    int numPartitions;
+    int numSteps;
+    int partitionsPerStep;
+    int blockSize;
+    int outputSlotOffset;
+
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::vector<float> partitions;
+    std::vector<float> frequencyDelayLine;
+    std::vector<float> window;
+    std::vector<float> fftBuffer;
+    std::vector<float> accumulator;
+    std::vector<float> output;
+
+    int fill = 0;
+    int step = -1;
+    int fdlHead = 0;
+    int frameIndex = 0;
+    int readPos = 0;
+
+    void startFrame();
+    void runStep();
+};
+
+// Готовый к работе движок для одной ИХ: прямая свёртка головы + две FFT-ступени.
+// Собирается целиком в фоновом потоке и передаётся аудиопотоку готовым.
+class ConvolutionEngine {
+public:
+    static constexpr int blockOrder = 6;
+    static constexpr int blockSize = 1 << blockOrder;
+    static constexpr int tailOrder = 10;
+
+    ConvolutionEngine(const std::vector<float>& impulse);
+
+    float processSample(float input);
+    // Очищает хвост, ИХ остаётся
+    void reset();
+
+private:
+    std::vector<float> head;
+    std::vector<float> history;
+    int historyPos = 0;
+
+    std::vector<float> block;
+    int blockPos = 0;
+
+    ConvolutionStage early;
+    ConvolutionStage late;
+};
+
+class Convolution;
+
+// Один фоновый поток на процесс строит движки для всех экземпляров Convolution.
+// Держится через juce::SharedResourcePointer и спит, пока его не разбудят.
+class ConvolutionLoader : public juce::Thread {
+public:
+    ConvolutionLoader();
+    ~ConvolutionLoader() override;
+
+    void add(Convolution& convolution);
+    void remove(Convolution& convolution);
+    void requestFile(Convolution& convolution, const juce::File& file);
+    void requestReload(Convolution& convolution);
+    void run() override;
+
+private:
+    juce::CriticalSection lock;
+    std::vector<Convolution*> clients;
+
+    static std::vector<float> makeSyntheticImpulse(float size, float sampleRate);
+    static std::vector<float> readImpulseFile(const juce::File& file, float sampleRate);
+};
+
+class Convolution {
+public:
+    float mix;
+    float size;
+    float sampleRate;
+
+    Convolution(float mix = 0.5f, float size = 0.3f, float sampleRate = 48000.0f);
+    ~Convolution();
+
+    // При смене частоты ИХ строится заново: длина хвоста и пересэмплирование файла зависят от неё.
+    // Хвост прошлого звука стирается в любом случае. Вызывать, пока processBlock не идёт.
+    void prepare(double newSampleRate);
+    // true, когда последняя заявка построена и следующий processBlock уже играет с ней
+    bool isReady();
+    void processBlock(juce::AudioBuffer<float>& buffer);
+    // Безопасно из аудиопотока: размер уходит загрузчику через атомики, без его lock
+    void setSize(float newSize);
+    void loadImpulseResponse(const juce::File& file);
+
+private:
+    friend class ConvolutionLoader;
+
+    // Заявка для загрузчика, под его lock
+    bool hasRequest = false;
+    float requestedSize = 0.0f;
+    float requestedSampleRate = 48000.0f;
+    juce::File requestedFile;
+    // Размер синтетической ИХ, заказанный без lock; загрузчик переносит его в заявку сам
+    std::atomic<float> pendingSize{ 0.0f };
+    std::atomic<bool> sizeRequested{ false };
+    std::atomic<int> requestedGeneration{ 0 };
+    std::atomic<int> builtGeneration{ 0 };
+
+    std::unique_ptr<ConvolutionEngine> engine;
+    std::atomic<ConvolutionEngine*> pending{ nullptr };
+    std::atomic<ConvolutionEngine*> retired{ nullptr };
+    juce::SharedResourcePointer<ConvolutionLoader> loader;
+
+    JUCE_DECLARE_NON_COPYABLE(Convolution)
+};
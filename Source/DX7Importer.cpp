@@ -0,0 +1,393 @@
+/*
+  ==============================================================================
+
+    DX7Importer.cpp
+    Created: 21 Oct 2026 11:26:40am
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#include "DX7Importer.h"
+#include "Oscillator.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <unordered_set>
+
+namespace {
+    // Связи алгоритмов DX7: пары "модулятор-носитель" в номерах операторов.
+    // Обратная связь отдельно, в feedbackLoops.
+    const char* const algorithms[32] = {
+        "65 54 43 21", "65 54 43 21", "65 54 32 21", "65 54 32 21",
+        "65 43 21", "65 43 21", "65 53 43 21", "65 53 43 21",
+        "65 53 43 21", "32 21 64 54", "32 21 64 54", "21 63 53 43",
+        "21 63 53 43", "64 54 43 21", "64 54 43 21", "21 43 31 65 51",
+        "21 43 31 65 51", "21 31 65 54 41", "32 21 64 65", "31 32 64 54",
+        "31 32 64 65", "21 63 64 65", "32 64 65", "63 64 65",
+        "64 65", "32 54 64", "32 54 64", "21 54 43",
+        "43 65", "54 43", "65", ""
+    };
+
+    // Петля обратной связи каждого алгоритма; в 4 и 6 она охватывает несколько операторов
+    const char* const feedbackLoops[32] = {
+        "66", "22", "66", "46", "66", "56", "66", "44",
+        "22", "33", "66", "22", "66", "66", "22", "66",
+        "22", "33", "66", "33", "33", "66", "66", "66",
+        "66", "66", "33", "55", "66", "55", "66", "66"
+    };
+
+    // Категории по словам в имени; духовые раньше басов из-за "bassoon"
+    const char* const categoryKeywords[][2] = {
+        { "bassoon", "Winds" }, { "flute", "Winds" }, { "oboe", "Winds" }, { "clari", "Winds" }, { "reed", "Winds" },
+        { "bass", "Bass" },
+        { "piano", "Keys" }, { "pno", "Keys" }, { "rhodes", "Keys" }, { "e.p", "Keys" }, { "wurli", "Keys" },
+        { "clav", "Keys" }, { "harpsi", "Keys" },
+        { "organ", "Organ" }, { "orgn", "Organ" },
+        { "brass", "Brass" }, { "horn", "Brass" }, { "trump", "Brass" }, { "tromb", "Brass" }, { "sax", "Brass" },
+        { "string", "Strings" }, { "strng", "Strings" }, { "violin", "Strings" }, { "cello", "Strings" },
+        { "bell", "Bells" }, { "chime", "Bells" }, { "glock", "Bells" }, { "vibe", "Bells" }, { "marim", "Bells" },
+        { "xylo", "Bells" },
+        { "guitar", "Plucked" }, { "gtr", "Plucked" }, { "harp", "Plucked" }, { "koto", "Plucked" },
+        { "sitar", "Plucked" }, { "pluck", "Plucked" },
+        { "drum", "Percussion" }, { "perc", "Percussion" }, { "snare", "Percussion" }, { "kick", "Percussion" },
+        { "tom", "Percussion" }, { "cymb", "Percussion" },
+        { "pad", "Pad" }, { "choir", "Pad" }, { "voice", "Pad" }, { "vox", "Pad" },
+        { "lead", "Lead" }, { "solo", "Lead" }, { "synth", "Lead" }
+    };
+
+    constexpr double referenceFrequency = 261.63;   // до первой октавы: глубина FM у нас в герцах, а не индекс
+    constexpr double maxModulationIndex = 13.0;
+    constexpr int maxMessageSize = 6 + DX7Importer::bulkDataSize + 2;
+
+    // Уровень DX7 0..99: около 0.75 дБ на шаг, 99 - полная амплитуда
+    double levelToAmplitude(int level) {
+        return level <= 0 ? 0.0 : std::pow(2.0, (level - 99) / 8.0);
+    }
+
+    // Время полного хода огибающей при скорости 0..99: от ~40 с до ~4 мс
+    double rateToSeconds(int rate) {
+        return 38.0 * std::pow(2.0, -rate / 7.5);
+    }
+
+    float segmentTime(int rate, int fromLevel, int toLevel) {
+        double time = rateToSeconds(rate) * std::abs(toLevel - fromLevel) / 99.0;
+        return static_cast<float>(juce::jlimit(0.005, 20.0, time));
+    }
+
+    void handleMessage(const std::vector<std::uint8_t>& message, std::vector<DX7Voice>& voices) {
+        // F0 43 0n ff ms ls <данные> cs F7, F7 к этому моменту уже отброшен
+        if (message.size() < 6 || message[1] != 0x43 || (message[2] & 0xf0) != 0x00) {
+            return;
+        }
+        const std::uint8_t* data = message.data() + 6;
+        size_t available = message.size() - 6;
+        if (message[3] == 9 && available >= DX7Importer::bulkDataSize) {
+            for (int i = 0; i < 32; ++i) {
+                voices.push_back(DX7Voice::unpackBulk(data + i * DX7Importer::bulkVoiceSize));
+            }
+        }
+        else if (message[3] == 0 && available >= DX7Importer::singleVoiceSize) {
+            voices.push_back(DX7Voice::unpackSingle(data));
+        }
+    }
+}
+
+DX7Voice DX7Voice::unpackBulk(const std::uint8_t* data) {
+    DX7Voice voice;
+    std::memset(&voice, 0, sizeof(DX7Voice));
+    for (int i = 0; i < 6; ++i) {
+        // в дампе операторы идут от OP6 к OP1, по 17 байт
+        const std::uint8_t* op = data + (5 - i) * 17;
+        Operator& dest = voice.ops[i];
+        for (int k = 0; k < 4; ++k) {
+            dest.rates[k] = op[k] & 0x7f;
+            dest.levels[k] = op[4 + k] & 0x7f;
+        }
+        dest.detune = (op[12] >> 3) & 0x0f;
+        dest.outputLevel = op[14] & 0x7f;
+        dest.fixedFrequency = op[15] & 0x01;
+        dest.coarse = (op[15] >> 1) & 0x1f;
+        dest.fine = op[16] & 0x7f;
+    }
+    voice.algorithm = data[110] & 0x1f;
+    voice.feedback = data[111] & 0x07;
+    voice.transpose = data[117] & 0x3f;
+    std::memcpy(voice.name, data + 118, 10);
+    return voice;
+}
+
+DX7Voice DX7Voice::unpackSingle(const std::uint8_t* data) {
+    DX7Voice voice;
+    std::memset(&voice, 0, sizeof(DX7Voice));
+    for (int i = 0; i < 6; ++i) {
+        const std::uint8_t* op = data + (5 - i) * 21;
+        Operator& dest = voice.ops[i];
+        for (int k = 0; k < 4; ++k) {
+            dest.rates[k] = op[k] & 0x7f;
+            dest.levels[k] = op[4 + k] & 0x7f;
+        }
+        dest.outputLevel = op[16] & 0x7f;
+        dest.fixedFrequency = op[17] & 0x01;
+        dest.coarse = op[18] & 0x1f;
+        dest.fine = op[19] & 0x7f;
+        dest.detune = op[20] & 0x0f;
+    }
+    voice.algorithm = data[134] & 0x1f;
+    voice.feedback = data[135] & 0x07;
+    voice.transpose = data[144] & 0x3f;
+    std::memcpy(voice.name, data + 145, 10);
+    return voice;
+}
+
+Patch DX7Importer::convertVoice(const DX7Voice& voice) {
+    Patch patch = Patch::getDefault();
+    PatchParameters& parameters = patch.parameters;
+    parameters.level = 0.7f;
+
+    bool modulates[6][6] = {};
+    bool isCarrier[6] = { true, true, true, true, true, true };
+    const char* edges = algorithms[voice.algorithm & 0x1f];
+    for (const char* c = edges; c[0] != '\0' && c[1] != '\0'; c += (c[2] == ' ' ? 3 : 2)) {
+        int modulator = c[0] - '1';
+        int carrier = c[1] - '1';
+        modulates[modulator][carrier] = true;
+        isCarrier[modulator] = false;
+    }
+
+    // У нас четыре оператора из шести: оставляем те, что сильнее всего слышны.
+    // Вес модулятора - его уровень, умноженный на вес самой важной из его целей;
+    // во всех алгоритмах модулятор старше носителя, так что хватает одного прохода.
+    double amplitude[6];
+    double score[6];
+    for (int i = 0; i < 6; ++i) {
+        amplitude[i] = levelToAmplitude(voice.ops[i].outputLevel);
+        score[i] = 0.0;
+        if (isCarrier[i]) {
+            score[i] = amplitude[i];
+        }
+        for (int target = 0; target < i; ++target) {
+            if (modulates[i][target]) {
+                score[i] = std::max(score[i], amplitude[i] * score[target]);
+            }
+        }
+    }
+    int order[6] = { 0, 1, 2, 3, 4, 5 };
+    std::stable_sort(order, order + 6, [&score](int a, int b) { return score[a] > score[b]; });
+    int chosen[PatchParameters::numOperators];
+    std::copy(order, order + PatchParameters::numOperators, chosen);
+    std::sort(chosen, chosen + PatchParameters::numOperators);
+
+    double ratios[PatchParameters::numOperators];
+    int numCarriers = 0;
+    for (int k = 0; k < PatchParameters::numOperators; ++k) {
+        numCarriers += isCarrier[chosen[k]] ? 1 : 0;
+    }
+
+    for (int k = 0; k < PatchParameters::numOperators; ++k) {
+        const DX7Voice::Operator& op = voice.ops[chosen[k]];
+        OperatorParameters& dest = parameters.operators[k];
+
+        // Фиксированную частоту движок не умеет - такой оператор идёт с отношением 1
+        double ratio = op.fixedFrequency ? 1.0 : (op.coarse == 0 ? 0.5 : op.coarse) * (1.0 + op.fine / 100.0);
+        ratios[k] = ratio;
+
+        // Дробные отношения кладём в октаву + расстройку в центах, она не ограничена ±50
+        double cents = 1200.0 * std::log2(ratio) + (op.detune - 7) + 100.0 * (voice.transpose - 24);
+        int octave = juce::jlimit(-4, 4, juce::roundToInt(cents / 1200.0));
+        dest.waveType = static_cast<float>(Oscillator::Sine);
+        dest.octave = static_cast<float>(octave);
+        dest.detune = static_cast<float>(cents - 1200.0 * octave);
+        dest.level = isCarrier[chosen[k]] ? static_cast<float>(amplitude[chosen[k]] / std::max(1, numCarriers)) : 0.0f;
+
+        // L4 - уровень покоя, с него начинается атака и к нему идёт затухание
+        const std::uint8_t* rates = op.rates;
+        const std::uint8_t* levels = op.levels;
+        int peak = std::max<int>(1, std::max(levels[0], levels[1]));
+        dest.attack = segmentTime(rates[0], levels[3], levels[0]);
+        dest.decay = juce::jlimit(0.005f, 20.0f, segmentTime(rates[1], levels[0], levels[1]) + segmentTime(rates[2], levels[1], levels[2]));
+        dest.sustain = static_cast<float>(juce::jlimit(0.0, 1.0, levelToAmplitude(levels[2]) / levelToAmplitude(peak)));
+        dest.release = segmentTime(rates[3], levels[2], levels[3]);
+    }
+
+    for (int m = 0; m < PatchParameters::numOperators; ++m) {
+        for (int c = 0; c < PatchParameters::numOperators; ++c) {
+            if (!modulates[chosen[m]][chosen[c]]) {
+                continue;
+            }
+            // Девиация носителя у нас - глубина * его множитель, а нужна индекс * частота модулятора
+            double index = maxModulationIndex * amplitude[chosen[m]];
+            double depth = index * referenceFrequency * ratios[m] / ratios[c];
+            parameters.modulationDepths[m][c] = static_cast<float>(juce::jlimit(0.0, 10000.0, depth));
+            parameters.modulationEnabled[m][c] = depth > 0.0 ? 1.0f : 0.0f;
+        }
+    }
+
+    // Обратная связь 7 - около пи радиан, каждый шаг вниз вдвое меньше.
+    // Переносится, только если оба конца петли попали в четыре оператора.
+    const char* loop = feedbackLoops[voice.algorithm & 0x1f];
+    int* from = std::find(chosen, chosen + PatchParameters::numOperators, loop[0] - '1');
+    int* to = std::find(chosen, chosen + PatchParameters::numOperators, loop[1] - '1');
+    int feedback = voice.feedback & 0x07;
+    if (feedback > 0 && from != chosen + PatchParameters::numOperators && to != chosen + PatchParameters::numOperators) {
+        int m = static_cast<int>(from - chosen);
+        int c = static_cast<int>(to - chosen);
+        double index = juce::MathConstants<double>::pi * std::pow(2.0, feedback - 7);
+        double depth = index * referenceFrequency * ratios[m] / ratios[c];
+        parameters.modulationDepths[m][c] = static_cast<float>(juce::jlimit(0.0, 10000.0, depth));
+        parameters.modulationEnabled[m][c] = 1.0f;
+    }
+    return patch;
+}
+
+PresetBank::Preset DX7Importer::makePreset(const DX7Voice& voice) {
+    char name[11];
+    for (int i = 0; i < 10; ++i) {
+        char c = voice.name[i];
+        name[i] = (c >= 0x20 && c < 0x7f) ? c : ' ';
+    }
+    name[10] = '\0';
+
+    PresetBank::Preset preset;
+    preset.name = juce::String(name).trim();
+    if (preset.name.isEmpty()) {
+        preset.name = "Init Voice";
+    }
+
+    juce::String lowerName = preset.name.toLowerCase();
+    preset.category = "DX7";
+    for (const auto& keyword : categoryKeywords) {
+        if (lowerName.contains(keyword[0])) {
+            preset.category = keyword[1];
+            break;
+        }
+    }
+    preset.tags.add("dx7");
+    preset.patch = convertVoice(voice);
+    return preset;
+}
+
+int DX7Importer::decodeFile(const juce::File& file, std::vector<PresetBank::Preset>& presets) {
+    juce::FileInputStream stream(file);
+    if (stream.failedToOpen()) {
+        return 0;
+    }
+
+    std::vector<DX7Voice> voices;
+    std::vector<std::uint8_t> message;
+    message.reserve(maxMessageSize);
+    bool inMessage = false;
+    std::uint8_t buffer[16384];
+
+    while (!stream.isExhausted()) {
+        int numRead = stream.read(buffer, sizeof(buffer));
+        if (numRead <= 0) {
+            break;
+        }
+        for (int i = 0; i < numRead; ++i) {
+            std::uint8_t byte = buffer[i];
+            if (byte == 0xf0) {
+                message.clear();
+                message.push_back(byte);
+                inMessage = true;
+            }
+            else if (!inMessage || byte >= 0xf8) {
+                // вне сообщения и realtime-байты внутри него пропускаем
+                continue;
+            }
+            else if (byte == 0xf7) {
+                handleMessage(message, voices);
+                inMessage = false;
+            }
+            else if ((byte & 0x80) != 0 || static_cast<int>(message.size()) >= maxMessageSize) {
+                inMessage = false;
+            }
+            else {
+                message.push_back(byte);
+            }
+        }
+    }
+
+    // Голый дамп VMEM без обёртки SysEx
+    if (voices.empty() && file.getSize() == bulkDataSize) {
+        juce::MemoryBlock data;
+        if (file.loadFileAsData(data)) {
+            for (int i = 0; i < 32; ++i) {
+                voices.push_back(DX7Voice::unpackBulk(static_cast<const std::uint8_t*>(data.getData()) + i * bulkVoiceSize));
+            }
+        }
+    }
+
+    for (const auto& voice : voices) {
+        presets.push_back(makePreset(voice));
+    }
+    return static_cast<int>(voices.size());
+}
+
+DX7Importer::Result DX7Importer::importFiles(const juce::Array<juce::File>& sources, std::vector<PresetBank::Preset>& existing,
+    const juce::File& bankFile, int numThreads) {
+    juce::Array<juce::File> files;
+    for (const auto& source : sources) {
+        if (source.isDirectory()) {
+            files.addArray(source.findChildFiles(juce::File::findFiles, true, "*.syx;*.SYX"));
+        }
+        else if (source.existsAsFile()) {
+            files.add(source);
+        }
+    }
+    files.sort();
+
+    Result result;
+    result.numFiles = files.size();
+
+    // Каждый файл разбирается в свой вектор, так что потокам нечего делить
+    std::vector<std::vector<PresetBank::Preset>> decoded(files.size());
+    if (!files.isEmpty()) {
+        juce::ThreadPool pool(numThreads > 0 ? numThreads : juce::SystemStats::getNumCpus());
+        std::atomic<int> remaining{ files.size() };
+        juce::WaitableEvent finished;
+        for (int i = 0; i < files.size(); ++i) {
+            pool.addJob([&, i] {
+                decodeFile(files[i], decoded[i]);
+                if (--remaining == 0) {
+                    finished.signal();
+                }
+            });
+        }
+        finished.wait(-1);
+    }
+
+    // Архивы DX7 полны копий одних и тех же голосов - повторы по имени и патчу отбрасываем
+    std::unordered_set<std::string> seen;
+    auto makeKey = [](const PresetBank::Preset& preset) {
+        std::string key(preset.name.toRawUTF8());
+        key.append(reinterpret_cast<const char*>(&preset.patch), sizeof(Patch));
+        return key;
+    };
+
+    std::vector<PresetBank::Preset> presets;
+    presets.reserve(existing.size());
+    for (auto& preset : existing) {
+        if (seen.insert(makeKey(preset)).second) {
+            presets.push_back(std::move(preset));
+        }
+    }
+    for (auto& fileVoices : decoded) {
+        for (auto& preset : fileVoices) {
+            if (seen.insert(makeKey(preset)).second) {
+                presets.push_back(std::move(preset));
+                ++result.numVoices;
+            }
+            else {
+                ++result.numDuplicates;
+            }
+        }
+    }
+
+    if (!PresetBank::write(bankFile, presets)) {
+        result.numVoices = 0;
+    }
+    return result;
+}
@@ -0,0 +1,64 @@
+/*
+  ==============================================================================
+
+    DX7Importer.h
+    Created: 21 Oct 2026 11:26:40am
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <cstdint>
+#include <vector>
+#include "Patch.h"
+#include "PresetBank.h"
+
+// Голос DX7 в распакованном виде (одинаков для VMEM 32 голоса и VCED одного голоса).
+// Операторы хранятся как на панели: ops[0] - OP1, ops[5] - OP6.
+struct DX7Voice {
+    struct Operator {
+        std::uint8_t rates[4];
+        std::uint8_t levels[4];
+        std::uint8_t outputLevel;
+        std::uint8_t fixedFrequency;
+        std::uint8_t coarse;
+        std::uint8_t fine;
+        std::uint8_t detune;
+    };
+
+    Operator ops[6];
+    std::uint8_t algorithm;
+    std::uint8_t feedback;
+    std::uint8_t transpose;
+    char name[11];
+
+    static DX7Voice unpackBulk(const std::uint8_t* data);      // 128 байт VMEM
+    static DX7Voice unpackSingle(const std::uint8_t* data);    // 155 байт VCED
+};
+
+// Импорт SysEx-банков DX7/TX802. Файл читается потоком, сообщения F0..F7 выделяются
+// по одному, так что склеенные архивы любого размера не грузятся в память целиком.
+class DX7Importer {
+public:
+    static constexpr int bulkVoiceSize = 128;
+    static constexpr int bulkDataSize = 32 * bulkVoiceSize;
+    static constexpr int singleVoiceSize = 155;
+
+    struct Result {
+        int numFiles = 0;
+        int numVoices = 0;
+        int numDuplicates = 0;
+    };
+
+    // Разбирает один файл; голоса добавляются в presets
+    static int decodeFile(const juce::File& file, std::vector<PresetBank::Preset>& presets);
+    static Patch convertVoice(const DX7Voice& voice);
+    static PresetBank::Preset makePreset(const DX7Voice& voice);
+
+    // Разбирает все .syx из списка (каталоги обходятся рекурсивно) в пуле потоков и
+    // записывает банк: сначала existing, затем новые голоса без повторов.
+    static Result importFiles(const juce::Array<juce::File>& sources, std::vector<PresetBank::Preset>& existing,
+        const juce::File& bankFile, int numThreads = 0);
+};
@@ -0,0 +1,49 @@
+/*
+  ==============================================================================
+
+    DspArena.cpp
+    Created: 25 Oct 2026 3:41:06pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#include "DspArena.h"
+
+void DspArena::beginLayout() {
+    release();
+}
+
+void DspArena::allocate() {
+    // Запас на выравнивание начала: malloc гарантирует меньше строки кэша
+    capacity = offset;
+    storage.calloc(capacity + alignment);
+    auto address = reinterpret_cast<juce::pointer_sized_uint>(storage.get());
+    base = storage.get() + (alignment - address % alignment) % alignment;
+    offset = 0;
+}
+
+void DspArena::release() {
+    storage.free();
+    base = nullptr;
+    capacity = 0;
+    offset = 0;
+}
+
+size_t DspArena::getBytesUsed() {
+    return offset;
+}
+
+size_t DspArena::getCapacity() {
+    return capacity;
+}
+
+void* DspArena::take(size_t numBytes) {
+    size_t start = (offset + alignment - 1) / alignment * alignment;
+    offset = start + numBytes;
+    if (base == nullptr) {
+        return nullptr;
+    }
+    jassert(offset <= capacity);
+    return base + start;
+}
@@ -0,0 +1,49 @@
+/*
+  ==============================================================================
+
+    DspArena.h
+    Created: 25 Oct 2026 3:41:06pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <new>
+
+// Одна непрерывная область под состояние DSP экземпляра. Раскладка идёт в два прохода
+// одним и тем же кодом: после beginLayout куски только считаются (адреса - nullptr),
+// после allocate выделяется ровно посчитанное и куски получают настоящие адреса.
+// Каждый кусок начинается со строки кэша. Деструкторы объектов арена не вызывает.
+class DspArena {
+public:
+    static constexpr size_t alignment = 64;
+
+    void beginLayout();
+    void allocate();
+    void release();
+
+    size_t getBytesUsed();
+    size_t getCapacity();
+
+    void* take(size_t numBytes);
+
+    // Обнулённый массив тривиального типа
+    template <typename T>
+    T* allocateArray(size_t count) {
+        return static_cast<T*>(take(count * sizeof(T)));
+    }
+
+    template <typename T>
+    T* create() {
+        void* memory = take(sizeof(T));
+        return memory != nullptr ? new (memory) T() : nullptr;
+    }
+
+private:
+    juce::HeapBlock<char> storage;
+    char* base = nullptr;
+    size_t capacity = 0;
+    size_t offset = 0;
+};
@@ -0,0 +1,185 @@
+/*
+  ==============================================================================
+
+    Ensemble.cpp
+    Created: 18 Oct 2026 8:03:26pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#include "Ensemble.h"
+
+Ensemble::Ensemble(float rate, float depth, float sampleRate)
+    : rate(rate), depth(depth), spread(1.0f), sampleRate(sampleRate), numVoices(maxVoices),
+    delayBuffer(nullptr), delayBufferPos(0), currentRate(-1.0f), currentSpread(1.0f),
+    rotationSin(Vec::expand(0.0f)), rotationCos(Vec::expand(1.0f)) {
+    resetPhases();
+}
+
+void Ensemble::prepare(double newSampleRate, DspArena& arena) {
+    sampleRate = static_cast<float>(newSampleRate);
+    currentRate = -1.0f;
+    delayBuffer = arena.allocateArray<float>(bufferSize);
+    delayBufferPos = 0;
+    resetPhases();
+}
+
+void Ensemble::setVoices(int newNumVoices) {
+    numVoices = juce::jlimit(4, maxVoices, newNumVoices);
+    updateGains();
+}
+
+void Ensemble::setSpread(float newSpread) {
+    spread = juce::jlimit(0.0f, 1.0f, newSpread);
+}
+
+void Ensemble::resetPhases() {
+    // Дорожки [0, maxVoices) - левый канал, [maxVoices, numTaps) - правый.
+    // Голос v стоит на шаге bitReverse(v) сетки из maxVoices точек: первые 4 голоса
+    // сами по себе равномерны, так что число голосов меняется без пересчёта фаз.
+    // Правый канал сдвинут на полшага, умноженные на spread.
+    alignas(Vec::SIMDRegisterSize) std::array<float, numTaps> sinValues{}, cosValues{};
+    float step = juce::MathConstants<float>::twoPi / static_cast<float>(maxVoices);
+    currentSpread = spread;
+
+    for (int voice = 0; voice < maxVoices; ++voice) {
+        int position = ((voice & 1) << 2) | (voice & 2) | ((voice & 4) >> 2);
+        for (int channel = 0; channel < 2; ++channel) {
+            int lane = channel * maxVoices + voice;
+            float phase = step * (static_cast<float>(position) + 0.5f * currentSpread * static_cast<float>(channel));
+            sinValues[lane] = std::sin(phase);
+            cosValues[lane] = std::cos(phase);
+        }
+    }
+
+    for (int r = 0; r < numRegisters; ++r) {
+        sinState[r] = Vec::fromRawArray(sinValues.data() + r * numLanes);
+        cosState[r] = Vec::fromRawArray(cosValues.data() + r * numLanes);
+    }
+    updateGains();
+}
+
+void Ensemble::updateGains() {
+    alignas(Vec::SIMDRegisterSize) std::array<float, numTaps> gainValues{};
+    float voiceGain = 1.0f / static_cast<float>(numVoices);
+    for (int voice = 0; voice < numVoices; ++voice) {
+        gainValues[voice] = voiceGain;
+        gainValues[maxVoices + voice] = voiceGain;
+    }
+    for (int r = 0; r < numRegisters; ++r) {
+        gains[r] = Vec::fromRawArray(gainValues.data() + r * numLanes);
+    }
+}
+
+void Ensemble::rotateRight(float angle) {
+    Vec rotateSin = Vec::expand(std::sin(angle));
+    Vec rotateCos = Vec::expand(std::cos(angle));
+    for (int r = numRegisters / 2; r < numRegisters; ++r) {
+        Vec s = sinState[r] * rotateCos + cosState[r] * rotateSin;
+        cosState[r] = cosState[r] * rotateCos - sinState[r] * rotateSin;
+        sinState[r] = s;
+    }
+}
+
+void Ensemble::processBlock(juce::AudioBuffer<float>& buffer) {
+    if (delayBuffer == nullptr) {
+        return;
+    }
+    int numSamples = buffer.getNumSamples();
+
+    if (spread != currentSpread) {
+        // Не больше 0.05 разброса на блок - задержки правого канала едут, а не прыгают
+        float target = currentSpread + juce::jlimit(-0.05f, 0.05f, spread - currentSpread);
+        rotateRight(0.5f * (target - currentSpread) * juce::MathConstants<float>::twoPi / static_cast<float>(maxVoices));
+        currentSpread = target;
+    }
+
+    if (rate != currentRate) {
+        currentRate = rate;
+        float increment = juce::MathConstants<float>::twoPi * (0.1f + 5.0f * rate) / sampleRate;
+        rotationSin = Vec::expand(std::sin(increment));
+        rotationCos = Vec::expand(std::cos(increment));
+    }
+
+    // Задержка гуляет вокруг 12 мс на глубину до 6 мс
+    Vec baseDelay = Vec::expand(0.012f * sampleRate);
+    Vec modulationDepth = Vec::expand(0.006f * sampleRate * depth);
+    Vec half = Vec::expand(0.5f);
+    Vec oneAndHalf = Vec::expand(1.5f);
+    constexpr int mask = bufferSize - 1;
+    constexpr int leftRegisters = numRegisters / 2;
+    // Регистры, где все голоса выключены, не считаются вовсе
+    const int activeRegisters = (numVoices + numLanes - 1) / numLanes;
+
+    float* left = buffer.getWritePointer(0);
+    float* right = buffer.getNumChannels() > 1 ? buffer.getWritePointer(1) : nullptr;
+
+    for (int i = 0; i < numSamples; ++i) {
+        float input = left[i];
+        delayBuffer[delayBufferPos] = input;
+
+        // Фазоры выключенных голосов тоже вращаются: вернувшись, голос встаёт на своё место
+        for (int r = 0; r < numRegisters; ++r) {
+            if (r % leftRegisters < activeRegisters) {
+                Vec delay = baseDelay + modulationDepth * sinState[r];
+                delay.copyToRawArray(delays.data() + r * numLanes);
+            }
+
+            Vec s = sinState[r] * rotationCos + cosState[r] * rotationSin;
+            cosState[r] = cosState[r] * rotationCos - sinState[r] * rotationSin;
+            sinState[r] = s;
+        }
+
+        // Чтение из линии задержки остаётся скалярным, остальное - по дорожкам
+        for (int tap = 0; tap < numTaps; ++tap) {
+            if ((tap / numLanes) % leftRegisters >= activeRegisters) {
+                continue;
+            }
+            int intDelay = static_cast<int>(delays[tap]);
+            int readPos = (delayBufferPos - intDelay) & mask;
+            current[tap] = delayBuffer[readPos];
+            next[tap] = delayBuffer[(readPos - 1) & mask];
+        }
+
+        Vec wetLeft = Vec::expand(0.0f);
+        Vec wetRight = Vec::expand(0.0f);
+        for (int r = 0; r < numRegisters; ++r) {
+            if (r % leftRegisters >= activeRegisters) {
+                continue;
+            }
+            Vec delay = Vec::fromRawArray(delays.data() + r * numLanes);
+            Vec frac = delay - Vec::truncate(delay);
+            Vec a = Vec::fromRawArray(current.data() + r * numLanes);
+            Vec b = Vec::fromRawArray(next.data() + r * numLanes);
+            Vec tapOutput = (a + frac * (b - a)) * gains[r];
+            if (r < leftRegisters) {
+                wetLeft += tapOutput;
+            }
+            else {
+                wetRight += tapOutput;
+            }
+        }
+
+        float wetL = wetLeft.sum();
+        float wetR = wetRight.sum();
+        float mixedL = 0.5f * (wetL + wetR) + 0.5f * currentSpread * (wetL - wetR);
+        float mixedR = 0.5f * (wetL + wetR) - 0.5f * currentSpread * (wetL - wetR);
+
+        left[i] = input * 0.4f + mixedL * 0.6f;
+        if (right != nullptr) {
+            right[i] = input * 0.4f + mixedR * 0.6f;
+        }
+
+        delayBufferPos = (delayBufferPos + 1) & mask;
+
+        // Раз в 256 сэмплов подправляем амплитуду фазоров
+        if ((delayBufferPos & 255) == 0) {
+            for (int r = 0; r < numRegisters; ++r) {
+                Vec gain = oneAndHalf - half * (sinState[r] * sinState[r] + cosState[r] * cosState[r]);
+                sinState[r] *= gain;
+                cosState[r] *= gain;
+            }
+        }
+    }
+}
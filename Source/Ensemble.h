@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+    Ensemble.h
+    Created: 18 Oct 2026 8:03:26pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include "DspArena.h"
+
+// Многоголосый стерео-хорус в духе string machine. Все отводы обоих каналов читают
+// одну общую линию задержки; фазоры LFO и интерполяция считаются сразу в SIMD-дорожках.
+class Ensemble {
+public:
+    using Vec = juce::dsp::SIMDRegister<float>;
+
+    static constexpr int maxVoices = 8;
+    static constexpr int numLanes = static_cast<int>(Vec::SIMDNumElements);
+    static constexpr int numTaps = 2 * maxVoices;
+    static constexpr int numRegisters = numTaps / numLanes;
+    static constexpr int bufferSize = 4096;
+
+    float rate;
+    float depth;
+    float spread;
+    float sampleRate;
+
+    Ensemble(float rate = 0.25f, float depth = 0.5f, float sampleRate = 48000.0f);
+
+    void prepare(double newSampleRate, DspArena& arena);
+    // Меняет только громкости голосов; фазы LFO не трогаются, так что щелчка нет
+    void setVoices(int newNumVoices);
+    // Сдвиг фаз правого канала доезжает до нового значения плавно, за несколько блоков
+    void setSpread(float newSpread);
+    void processBlock(juce::AudioBuffer<float>& buffer);
+
+private:
+    int numVoices;
+    float* delayBuffer;
+    int delayBufferPos;
+
+    std::array<Vec, numRegisters> sinState;
+    std::array<Vec, numRegisters> cosState;
+    std::array<Vec, numRegisters> gains;
+    float currentRate;
+    float currentSpread;
+    Vec rotationSin;
+    Vec rotationCos;
+
+    alignas(Vec::SIMDRegisterSize) std::array<float, numTaps> delays;
+    alignas(Vec::SIMDRegisterSize) std::array<float, numTaps> current;
+    alignas(Vec::SIMDRegisterSize) std::array<float, numTaps> next;
+
+    void resetPhases();
+    void updateGains();
+    void rotateRight(float angle);
+};
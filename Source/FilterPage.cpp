@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    FilterPage.cpp
+    Created: 22 Oct 2026 2:35:12pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#include "FilterPage.h"
+
+FilterPage::FilterPage(SynthFMAudioProcessor& p) : processor(p) {
+    setInterceptsMouseClicks(false, true);
+
+    filterModeSelector.addItem("Off", 1);
+    filterModeSelector.addItem("Low Pass", 2);
+    filterModeSelector.addItem("High Pass", 3);
+    filterModeSelector.addItem("Band Pass", 4);
+    filterModeSelector.addItem("Notch", 5);
+    filterModeSelector.onChange = [this] {
+        processor.setFilterMode(static_cast<VoiceFilterBank::Mode>(filterModeSelector.getSelectedId() - 1));
+    };
+    filterModeSelector.setSelectedId(1, juce::dontSendNotification);
+    addAndMakeVisible(filterModeSelector);
+
+    filterCutoffDial.setSliderStyle(juce::Slider::SliderStyle::RotaryVerticalDrag);
+    filterCutoffDial.setRange(20.0, 20000.0, 1.0);
+    filterCutoffDial.setSkewFactorFromMidPoint(1000.0);
+    filterCutoffDial.setValue(20000.0, juce::dontSendNotification);
+    filterCutoffDial.setTextValueSuffix(" Hz");
+    filterCutoffDial.onValueChange = [this] {
+        processor.setFilterCutoff(filterCutoffDial.getValue());
+    };
+
+    filterResonanceDial.setSliderStyle(juce::Slider::SliderStyle::RotaryVerticalDrag);
+    filterResonanceDial.setRange(0.0, 1.0, 0.01);
+    filterResonanceDial.onValueChange = [this] {
+        processor.setFilterResonance(filterResonanceDial.getValue());
+    };
+
+    filterEnvelopeDial.setSliderStyle(juce::Slider::SliderStyle::RotaryVerticalDrag);
+    filterEnvelopeDial.setRange(-8.0, 8.0, 0.1);
+    filterEnvelopeDial.setTextValueSuffix(" oct");
+    filterEnvelopeDial.onValueChange = [this] {
+        processor.setFilterEnvelopeAmount(filterEnvelopeDial.getValue());
+    };
+
+    juce::Slider* filterDials[] = { &filterCutoffDial, &filterResonanceDial, &filterEnvelopeDial };
+    const char* filterNames[] = { "Cutoff", "Resonance", "Env Amount" };
+    for (int i = 0; i < 3; ++i) {
+        filterDials[i]->setTextBoxStyle(juce::Slider::TextBoxBelow, false, 70, 20);
+        addAndMakeVisible(*filterDials[i]);
+        filterLabels[i].setText(filterNames[i], juce::dontSendNotification);
+        filterLabels[i].setJustificationType(juce::Justification::centred);
+        addAndMakeVisible(filterLabels[i]);
+    }
+
+    const char* envelopeNames[] = { "Attack", "Decay", "Sustain", "Release" };
+    for (int i = 0; i < 4; ++i) {
+        filterEnvelopeSliders[i].setSliderStyle(juce::Slider::SliderStyle::LinearVertical);
+        filterEnvelopeSliders[i].setRange(i == 2 ? 0.0 : 0.01, i == 2 ? 1.0 : 5.0);
+        filterEnvelopeSliders[i].onValueChange = [this, i] {
+            float value = filterEnvelopeSliders[i].getValue();
+            switch (i) {
+            case 0: processor.setFilterAttack(value); break;
+            case 1: processor.setFilterDecay(value); break;
+            case 2: processor.setFilterSustain(value); break;
+            case 3: processor.setFilterRelease(value); break;
+            }
+        };
+        addAndMakeVisible(filterEnvelopeSliders[i]);
+        filterEnvelopeLabels[i].setText(envelopeNames[i], juce::dontSendNotification);
+        addAndMakeVisible(filterEnvelopeLabels[i]);
+    }
+}
+
+void FilterPage::refreshFromPatch(const PatchParameters& parameters) {
+    filterModeSelector.setSelectedId(juce::roundToInt(parameters.filterMode) + 1, juce::dontSendNotification);
+    filterCutoffDial.setValue(parameters.filterCutoff, juce::dontSendNotification);
+    filterResonanceDial.setValue(parameters.filterResonance, juce::dontSendNotification);
+    filterEnvelopeDial.setValue(parameters.filterEnvelopeAmount, juce::dontSendNotification);
+    filterEnvelopeSliders[0].setValue(parameters.filterAttack, juce::dontSendNotification);
+    filterEnvelopeSliders[1].setValue(parameters.filterDecay, juce::dontSendNotification);
+    filterEnvelopeSliders[2].setValue(parameters.filterSustain, juce::dontSendNotification);
+    filterEnvelopeSliders[3].setValue(parameters.filterRelease, juce::dontSendNotification);
+}
+
+void FilterPage::resized()
+{
+    filterModeSelector.setBounds(20, 60, 200, 24);
+    juce::Slider* filterDials[] = { &filterCutoffDial, &filterResonanceDial, &filterEnvelopeDial };
+    for (int i = 0; i < 3; ++i) {
+        int dialX = 20 + i * 130;
+        filterLabels[i].setBounds(dialX, 100, 110, 20);
+        filterDials[i]->setBounds(dialX, 120, 110, 130);
+    }
+    for (int i = 0; i < 4; ++i) {
+        int sliderX = 460 + i * 60;
+        filterEnvelopeLabels[i].setBounds(sliderX - 5, 100, 60, 20);
+        filterEnvelopeSliders[i].setBounds(sliderX, 120, 30, 250);
+    }
+}
@@ -0,0 +1,33 @@
+/*
+  ==============================================================================
+
+    FilterPage.h
+    Created: 22 Oct 2026 2:35:12pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+class FilterPage : public juce::Component {
+public:
+    FilterPage(SynthFMAudioProcessor& processor);
+
+    void resized() override;
+    void refreshFromPatch(const PatchParameters& parameters);
+
+private:
+    SynthFMAudioProcessor& processor;
+    juce::ComboBox filterModeSelector;
+    juce::Slider filterCutoffDial;
+    juce::Slider filterResonanceDial;
+    juce::Slider filterEnvelopeDial;
+    juce::Slider filterEnvelopeSliders[4];
+    juce::Label filterLabels[3];
+    juce::Label filterEnvelopeLabels[4];
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FilterPage)
+};
@@ -12,28 +12,42 @@
 
 void Overdrive::processBlock(juce::AudioBuffer<float>& buffer) {
     updateFilter();
-    float* channelData = buffer.getWritePointer(0);
-    for (int i = 0; i < buffer.getNumSamples(); ++i) {
-        channelData[i] = std::tanh(channelData[i] * drive * 100);
-    }
-
-    filter.processSamples(channelData, buffer.getNumSamples());
+    shaper.processBlock(buffer, drive * 100);
 
-    for (int channel = 1; channel < buffer.getNumChannels(); ++channel) {
-        std::copy(channelData, channelData + buffer.getNumSamples(), buffer.getWritePointer(channel));
+    int numChannels = std::min(buffer.getNumChannels(), Waveshaper::maxChannels);
+    for (int channel = 0; channel < numChannels; ++channel) {
+        filters[channel].processSamples(buffer.getWritePointer(channel), buffer.getNumSamples());
     }
 }
 
 void Overdrive::updateFilter() {
+    if (tone == filterTone) {
+        return;
+    }
+    filterTone = tone;
     float maxCutoff = 5000.0f;
     float minCutoff = 500.0f;
     float cutoff = minCutoff + (maxCutoff - minCutoff) * tone;
-    filter.setCoefficients(juce::IIRCoefficients::makeLowPass(48000.0, cutoff));
+    for (auto& filter : filters) {
+        filter.setCoefficients(juce::IIRCoefficients::makeLowPass(sampleRate, cutoff));
+    }
+}
+
+void Overdrive::setSampleRate(float newSampleRate) {
+    sampleRate = newSampleRate;
+    filterTone = -1.0f;
+    shaper.reset();
+    for (auto& filter : filters) {
+        filter.reset();
+    }
+}
+
+void Reverb::prepare(double sampleRate) {
+    reverb.setSampleRate(sampleRate);
+    reverb.reset();
 }
 
 void Reverb::processBlock(juce::AudioBuffer<float>& buffer) {
-    static juce::Reverb reverb;
-    static juce::Reverb::Parameters params;
     params.roomSize = roomSize;
     params.damping = damping;
     params.wetLevel = 0.8;
@@ -43,8 +57,17 @@ void Reverb::processBlock(juce::AudioBuffer<float>& buffer) {
     reverb.processStereo(buffer.getWritePointer(0), buffer.getWritePointer(1), buffer.getNumSamples());
 }
 
+void Delay::prepare(DspArena& arena) {
+    delayBuffer = arena.allocateArray<float>(maxDelaySamples);
+    delayBufferPos = 0;
+}
+
 void Delay::processBlock(juce::AudioBuffer<float>& buffer) {
-    int delaySamples = static_cast<int>(48000.0 * time);
+    if (delayBuffer == nullptr) {
+        return;
+    }
+    int delaySamples = juce::jlimit(1, static_cast<int>(maxDelaySamples), static_cast<int>(48000.0 * time));
+    delayBufferPos %= delaySamples;
     float feedbackGain = std::min(feedback, 0.95f);
 
     float* channelData0 = buffer.getWritePointer(0);
@@ -63,35 +86,46 @@ void Delay::processBlock(juce::AudioBuffer<float>& buffer) {
 }
 
 
+void Flanger::prepare(DspArena& arena) {
+    delayBuffer = arena.allocateArray<float>(maxDelaySamples);
+    delayBufferPos = 0;
+    lfo.reset();
+}
+
 void Flanger::processBlock(juce::AudioBuffer<float>& buffer) {
+    if (delayBuffer == nullptr) {
+        return;
+    }
     int numSamples = buffer.getNumSamples();
     float sampleRate = 48000.0;
     float depthInSamples = depth * sampleRate / 1000.0;
 
-    int maxDelaySamples = static_cast<int>(depthInSamples);
-    if (delayBuffer.size() < maxDelaySamples) {
-        delayBuffer.resize(maxDelaySamples, 0.0);
-    }
+    int delaySamples = juce::jlimit(1, static_cast<int>(maxDelaySamples), static_cast<int>(depthInSamples));
+    delayBufferPos %= delaySamples;
+    lfo.setFrequency(rate, sampleRate);
+
     auto* channelData = buffer.getWritePointer(0);
-    for (int i = 0; i < numSamples; ++i) {
-        float modulatedDelay = depthInSamples * (0.5f + 0.4f * std::sin(phase));
-        int intDelay = static_cast<int>(modulatedDelay);
-        float fracDelay = modulatedDelay - intDelay;
-            
-        phase += rate * juce::MathConstants<float>::twoPi / sampleRate;
-        if (phase >= juce::MathConstants<float>::twoPi)
-            phase -= juce::MathConstants<float>::twoPi;
+    for (int start = 0; start < numSamples; start += LFO::maxBlockSize) {
+        int blockSize = std::min(LFO::maxBlockSize, numSamples - start);
+        lfo.generate(blockSize);
+        const float* modulation = lfo.getTap(0);
+
+        for (int j = 0; j < blockSize; ++j) {
+            int i = start + j;
+            float modulatedDelay = depthInSamples * (0.5f + 0.4f * modulation[j]);
+            int intDelay = static_cast<int>(modulatedDelay);
 
             float currentSample = channelData[i];
 
-            int readPos = (delayBufferPos - intDelay + maxDelaySamples) % maxDelaySamples;
+            int readPos = (delayBufferPos - intDelay + delaySamples) % delaySamples;
             float delayedSample1 = delayBuffer[readPos];
 
             channelData[i] = currentSample * 0.7 + delayedSample1 * 0.3;
 
             delayBuffer[delayBufferPos] = currentSample;
 
-        delayBufferPos = (delayBufferPos + 1) % maxDelaySamples;
+            delayBufferPos = (delayBufferPos + 1) % delaySamples;
+        }
     }
     for (int channel = 1; channel < buffer.getNumChannels(); ++channel) {
         std::copy(channelData, channelData + buffer.getNumSamples(), buffer.getWritePointer(channel));
@@ -100,43 +134,61 @@ void Flanger::processBlock(juce::AudioBuffer<float>& buffer) {
 
 
 
+void Chorus::prepare(DspArena& arena) {
+    delayBuffer = arena.allocateArray<float>(bufferSize);
+    delayBufferPos = 0;
+    lfo.reset();
+}
+
 void Chorus::processBlock(juce::AudioBuffer<float>& buffer) {
+    if (delayBuffer == nullptr) {
+        return;
+    }
     int numSamples = buffer.getNumSamples();
     float sampleRate = 48000.0;
+    float depthInSamples = depth * sampleRate / 1000;
+
+    lfo.setFrequency(rate, sampleRate);
 
     auto* channelData = buffer.getWritePointer(0);
 
-    for (int i = 0; i < numSamples; ++i) {
-        float pitchModulation1 = 1.0 + 0.001 * std::sin(phase + 0.5);
-        float pitchModulation2 = 1.0 + 0.001 * std::sin(phase - 0.5);
+    for (int start = 0; start < numSamples; start += LFO::maxBlockSize) {
+        int blockSize = std::min(LFO::maxBlockSize, numSamples - start);
+        lfo.generate(blockSize);
+        const float* pitchLfo1 = lfo.getTap(PitchTap1);
+        const float* pitchLfo2 = lfo.getTap(PitchTap2);
+        const float* delayLfo1 = lfo.getTap(DelayTap1);
+        const float* delayLfo2 = lfo.getTap(DelayTap2);
 
-        float modulatedDelay1 = 20 + depth * sampleRate * (0.5f + 0.4f * std::sin(phase)) / 1000 * pitchModulation1;
-        int intDelay1 = static_cast<int>(modulatedDelay1);
-        float fracDelay1 = modulatedDelay1 - intDelay1;
+        for (int j = 0; j < blockSize; ++j) {
+            int i = start + j;
+            float pitchModulation1 = 1.0f + 0.001f * pitchLfo1[j];
+            float pitchModulation2 = 1.0f + 0.001f * pitchLfo2[j];
 
-        float modulatedDelay2 = 20 + depth * sampleRate * (0.5f + 0.4f * std::sin(phase + juce::MathConstants<float>::pi)) / 1000 * pitchModulation2;
-        int intDelay2 = static_cast<int>(modulatedDelay2);
-        float fracDelay2 = modulatedDelay2 - intDelay2;
+            float modulatedDelay1 = 20 + depthInSamples * (0.5f + 0.4f * delayLfo1[j]) * pitchModulation1;
+            int intDelay1 = static_cast<int>(modulatedDelay1);
+            float fracDelay1 = modulatedDelay1 - intDelay1;
 
-        phase += rate * juce::MathConstants<float>::twoPi / sampleRate;
-        if (phase >= juce::MathConstants<float>::twoPi)
-            phase -= juce::MathConstants<float>::twoPi;
+            float modulatedDelay2 = 20 + depthInSamples * (0.5f + 0.4f * delayLfo2[j]) * pitchModulation2;
+            int intDelay2 = static_cast<int>(modulatedDelay2);
+            float fracDelay2 = modulatedDelay2 - intDelay2;
 
-        int readPos1 = (delayBufferPos - intDelay1 + delayBuffer.size()) % delayBuffer.size();
-        float delayedSample1_1 = delayBuffer[readPos1];
-        float delayedSample1_2 = delayBuffer[(readPos1 + 1) % delayBuffer.size()];
-        float interpolatedSample1 = delayedSample1_1 + fracDelay1 * (delayedSample1_2 - delayedSample1_1);
+            int readPos1 = (delayBufferPos - intDelay1 + bufferSize) % bufferSize;
+            float delayedSample1_1 = delayBuffer[readPos1];
+            float delayedSample1_2 = delayBuffer[(readPos1 + 1) % bufferSize];
+            float interpolatedSample1 = delayedSample1_1 + fracDelay1 * (delayedSample1_2 - delayedSample1_1);
 
-        int readPos2 = (delayBufferPos - intDelay2 + delayBuffer.size()) % delayBuffer.size();
-        float delayedSample2_1 = delayBuffer[readPos2];
-        float delayedSample2_2 = delayBuffer[(readPos2 + 1) % delayBuffer.size()];
-        float interpolatedSample2 = delayedSample2_1 + fracDelay2 * (delayedSample2_2 - delayedSample2_1);
+            int readPos2 = (delayBufferPos - intDelay2 + bufferSize) % bufferSize;
+            float delayedSample2_1 = delayBuffer[readPos2];
+            float delayedSample2_2 = delayBuffer[(readPos2 + 1) % bufferSize];
+            float interpolatedSample2 = delayedSample2_1 + fracDelay2 * (delayedSample2_2 - delayedSample2_1);
 
-        channelData[i] = channelData[i] * 0.3 + interpolatedSample1 * 0.3 + interpolatedSample2 * 0.4;
+            channelData[i] = channelData[i] * 0.3 + interpolatedSample1 * 0.3 + interpolatedSample2 * 0.4;
 
-        delayBuffer[delayBufferPos] = channelData[i];
+            delayBuffer[delayBufferPos] = channelData[i];
 
-        delayBufferPos = (delayBufferPos + 1) % delayBuffer.size();
+            delayBufferPos = (delayBufferPos + 1) % bufferSize;
+        }
     }
     for (int channel = 1; channel < buffer.getNumChannels(); ++channel) {
         std::copy(channelData, channelData + buffer.getNumSamples(), buffer.getWritePointer(channel));
@@ -153,6 +205,11 @@ void Filter::updateFilter() {
     lowPassFilter.setCoefficients(lowPassCoeffs);
 }
 
+void Filter::reset() {
+    highPassFilter.reset();
+    lowPassFilter.reset();
+}
+
 void Filter::processBlock(juce::AudioBuffer<float>& buffer) {
     updateFilter();
     float* channelData = buffer.getWritePointer(0);
@@ -168,22 +225,69 @@ void Filter::processBlock(juce::AudioBuffer<float>& buffer) {
 FxBlock::FxBlock(const std::string& name)
     : name(name), isActive(false), parameters(getDefaultParameters(name)) {
     if (name == "Overdrive") {
-        effect = std::make_unique<std::variant<Overdrive, Reverb, Delay, Flanger, Chorus, Filter>>(Overdrive());
+        effect = std::make_unique<EffectVariant>(Overdrive());
     }
     else if (name == "Reverb") {
-        effect = std::make_unique<std::variant<Overdrive, Reverb, Delay, Flanger, Chorus, Filter>>(Reverb());
+        effect = std::make_unique<EffectVariant>(std::in_place_type<Reverb>);
     }
     else if (name == "Delay") {
-        effect = std::make_unique<std::variant<Overdrive, Reverb, Delay, Flanger, Chorus, Filter>>(Delay());
+        effect = std::make_unique<EffectVariant>(Delay());
     }
     else if (name == "Flanger") {
-        effect = std::make_unique<std::variant<Overdrive, Reverb, Delay, Flanger, Chorus, Filter>>(Flanger());
+        effect = std::make_unique<EffectVariant>(Flanger());
     }
     else if (name == "Chorus") {
-        effect = std::make_unique<std::variant<Overdrive, Reverb, Delay, Flanger, Chorus, Filter>>(Chorus());
+        effect = std::make_unique<EffectVariant>(Chorus());
     }
     else if (name == "Filter") {
-        effect = std::make_unique<std::variant<Overdrive, Reverb, Delay, Flanger, Chorus, Filter>>(Filter());
+        effect = std::make_unique<EffectVariant>(Filter());
+    }
+    else if (name == "Convolution") {
+        // Convolution владеет фоновым потоком и не перемещается, поэтому создаётся на месте
+        effect = std::make_unique<EffectVariant>(std::in_place_type<Convolution>);
+    }
+    else if (name == "Ensemble") {
+        effect = std::make_unique<EffectVariant>(Ensemble());
+    }
+}
+
+void FxBlock::prepare(double sampleRate, DspArena& arena) {
+    if (auto* overdrive = std::get_if<Overdrive>(effect.get())) {
+        overdrive->setSampleRate(static_cast<float>(sampleRate));
+    }
+    else if (auto* reverb = std::get_if<Reverb>(effect.get())) {
+        reverb->prepare(sampleRate);
+    }
+    else if (auto* filter = std::get_if<Filter>(effect.get())) {
+        filter->reset();
+    }
+    else if (auto* delay = std::get_if<Delay>(effect.get())) {
+        delay->prepare(arena);
+    }
+    else if (auto* flanger = std::get_if<Flanger>(effect.get())) {
+        flanger->prepare(arena);
+    }
+    else if (auto* chorus = std::get_if<Chorus>(effect.get())) {
+        chorus->prepare(arena);
+    }
+    else if (auto* ensemble = std::get_if<Ensemble>(effect.get())) {
+        ensemble->prepare(sampleRate, arena);
+    }
+    else if (auto* convolution = std::get_if<Convolution>(effect.get())) {
+        convolution->prepare(sampleRate);
+    }
+}
+
+bool FxBlock::isReady() {
+    if (auto* convolution = std::get_if<Convolution>(effect.get())) {
+        return convolution->isReady();
+    }
+    return true;
+}
+
+void FxBlock::setReducedQuality(bool reduced) {
+    if (auto* ensemble = std::get_if<Ensemble>(effect.get())) {
+        ensemble->setVoices(reduced ? Ensemble::maxVoices / 2 : Ensemble::maxVoices);
     }
 }
 
@@ -193,6 +297,73 @@ void FxBlock::processBlock(juce::AudioBuffer<float>& buffer) {
         }, *effect);
 }
 
+void FxBlock::setValue(int parameter, float value) {
+    if (auto* overdrive = std::get_if<Overdrive>(effect.get())) {
+        if (parameter == 0) {
+            overdrive->drive = value;
+        }
+        else {
+            overdrive->tone = value;
+        }
+    }
+    else if (auto* reverb = std::get_if<Reverb>(effect.get())) {
+        if (parameter == 0) {
+            reverb->damping = value;
+        }
+        else {
+            reverb->roomSize = value;
+        }
+    }
+    else if (auto* delay = std::get_if<Delay>(effect.get())) {
+        if (parameter == 0) {
+            delay->feedback = value;
+        }
+        else {
+            delay->time = value;
+        }
+    }
+    else if (auto* flanger = std::get_if<Flanger>(effect.get())) {
+        if (parameter == 0) {
+            flanger->depth = value * 15;
+        }
+        else {
+            flanger->rate = value * 5;
+        }
+    }
+    else if (auto* chorus = std::get_if<Chorus>(effect.get())) {
+        if (parameter == 0) {
+            chorus->depth = 15 * value;
+        }
+        else {
+            chorus->rate = value;
+        }
+    }
+    else if (auto* filter = std::get_if<Filter>(effect.get())) {
+        if (parameter == 0) {
+            filter->highCut = value;
+        }
+        else {
+            filter->lowCut = value;
+        }
+    }
+    else if (auto* convolution = std::get_if<Convolution>(effect.get())) {
+        if (parameter == 0) {
+            convolution->mix = value;
+        }
+        else {
+            convolution->setSize(value);
+        }
+    }
+    else if (auto* ensemble = std::get_if<Ensemble>(effect.get())) {
+        if (parameter == 0) {
+            ensemble->depth = value;
+        }
+        else {
+            ensemble->rate = value;
+        }
+    }
+}
+
 std::map<std::string, float> FxBlock::getDefaultParameters(const std::string& name) {
     if (name == "Overdrive") {
         return { {"Drive", 0.5f}, {"Tone", 0.5f} };
@@ -212,6 +383,12 @@ std::map<std::string, float> FxBlock::getDefaultParameters(const std::string& na
     else if (name == "Filter") {
         return { {"HighCut", 1.0f}, {"LowCut", 0.01f} };
     }
+    else if (name == "Convolution") {
+        return { {"Mix", 0.5f}, {"Size", 0.3f} };
+    }
+    else if (name == "Ensemble") {
+        return { {"Depth", 0.5f}, {"Rate", 0.25f} };
+    }
     return {};
 }
 
@@ -290,7 +467,7 @@ void FxBlockComponent::setFxBlock(const FxBlock& fxBlock) {
     param1Slider.setValue(it->second);
     param1Slider.setName(it->first);
     param1Slider.setSliderStyle(juce::Slider::SliderStyle::RotaryVerticalDrag);
-    param1Slider.setRange(0.01, 1.0, 0.01);
+    param1Slider.setRange(FxBlock::minValue, FxBlock::maxValue, 0.01);
     param1Slider.setNumDecimalPlacesToDisplay(2);
     param1Slider.setTextValueSuffix("");
     param1Label.setText(it->first, juce::dontSendNotification);
@@ -299,7 +476,7 @@ void FxBlockComponent::setFxBlock(const FxBlock& fxBlock) {
         param2Slider.setValue(it->second);
         param2Slider.setName(it->first);
         param2Slider.setSliderStyle(juce::Slider::SliderStyle::RotaryVerticalDrag);
-        param2Slider.setRange(0.01, 1.0, 0.01);
+        param2Slider.setRange(FxBlock::minValue, FxBlock::maxValue, 0.01);
         param2Slider.setNumDecimalPlacesToDisplay(2);
         param2Slider.setTextValueSuffix("");
         param2Label.setText(it->first, juce::dontSendNotification);
@@ -324,6 +501,8 @@ FxList::FxList() {
     effects.emplace_back("Flanger");
     effects.emplace_back("Chorus");
     effects.emplace_back("Filter");
+    effects.emplace_back("Convolution");
+    effects.emplace_back("Ensemble");
     setRowHeight(75);
 }
 
@@ -369,57 +548,29 @@ void FxList::toggleEffectEnabled(int index) {
 }
 
 void FxList::setEffect1(int index, float value) {
-    if (effects[index].name == "Overdrive") {
-        effects[index].parameters["Drive"] = value;
-        std::get<Overdrive>(*effects[index].effect).drive = value;
-    }
-    else if (effects[index].name == "Reverb") {
-        effects[index].parameters["Damping"] = value;
-        std::get<Reverb>(*effects[index].effect).damping = value;
-    }
-    else if (effects[index].name == "Delay") {
-        effects[index].parameters["Feedback"] = value;
-        std::get<Delay>(*effects[index].effect).feedback = value;
-    }
-    else if (effects[index].name == "Flanger") {
-        effects[index].parameters["Depth"] = value;
-        std::get<Flanger>(*effects[index].effect).depth = value * 15;
-    }
-    else if (effects[index].name == "Chorus") {
-        effects[index].parameters["Depth"] = value;
-        std::get<Chorus>(*effects[index].effect).depth = 15 * value;
-    }
-    else if (effects[index].name == "Filter") {
-        effects[index].parameters["HighCut"] = value;
-        std::get<Filter>(*effects[index].effect).highCut = value;
-    }
+    setEffectParameter(index, 0, value);
 }
 
 void FxList::setEffect2(int index, float value) {
-    if (effects[index].name == "Overdrive") {
-        effects[index].parameters["Tone"] = value;
-        std::get<Overdrive>(*effects[index].effect).tone = value;
-    }
-    else if (effects[index].name == "Reverb") {
-        effects[index].parameters["Room Size"] = value;
-        std::get<Reverb>(*effects[index].effect).roomSize = value;
-    }
-    else if (effects[index].name == "Delay") {
-        effects[index].parameters["Time"] = value;
-        std::get<Delay>(*effects[index].effect).time = value;
-    }
-    else if (effects[index].name == "Flanger") {
-        effects[index].parameters["Rate"] = value;
-        std::get<Flanger>(*effects[index].effect).rate = value * 5;
-    }
-    else if (effects[index].name == "Chorus") {
-        effects[index].parameters["Rate"] = value;
-        std::get<Chorus>(*effects[index].effect).rate = value;
+    setEffectParameter(index, 1, value);
+}
+
+void FxList::setEffectParameter(int index, int parameter, float value) {
+    auto& parameters = effects[index].parameters;
+    if (parameter < 0 || parameter >= static_cast<int>(parameters.size())) {
+        return;
     }
-    else if (effects[index].name == "Filter") {
-        effects[index].parameters["LowCut"] = value;
-        std::get<Filter>(*effects[index].effect).lowCut = value;
+    std::next(parameters.begin(), parameter)->second = value;
+    effects[index].setValue(parameter, value);
+}
+
+// Модуляция меняет только сам эффект: сохранённое значение остаётся базой для следующего блока.
+// Размер свёртки пересобирает импульс и поэтому не модулируется.
+void FxList::modulateEffect(int index, int parameter, float value) {
+    if (std::holds_alternative<Convolution>(*effects[index].effect) && parameter == 1) {
+        return;
     }
+    effects[index].setValue(parameter, value);
 }
 
 void FxList::moveEffectUp(int index) {
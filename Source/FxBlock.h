@@ -12,43 +12,60 @@
 #include <JuceHeader.h>
 #include <variant>
 #include <cmath>
+#include "Convolution.h"
+#include "LFO.h"
+#include "Ensemble.h"
+#include "Waveshaper.h"
+#include "DspArena.h"
 
 class Overdrive {
 public:
     float drive;
     float tone;
-    juce::IIRFilter filter;
+    float sampleRate;
+    Waveshaper shaper;
+    juce::IIRFilter filters[Waveshaper::maxChannels];
 
     Overdrive(float drive = 0.5f, float tone = 0.5f)
-        : drive(drive), tone(tone) {}
+        : drive(drive), tone(tone), sampleRate(48000.0f), filterTone(-1.0f) {}
 
     void processBlock(juce::AudioBuffer<float>& buffer);
     void updateFilter();
+    void setSampleRate(float newSampleRate);
+
+private:
+    float filterTone;
 };
 
+// juce::Reverb не копируется и не перемещается, поэтому создаётся на месте, как Convolution
 class Reverb {
 public:
     float roomSize;
     float damping;
+    juce::Reverb reverb;
+    juce::Reverb::Parameters params;
 
     Reverb(float roomSize = 0.7f, float damping = 0.6f)
         : roomSize(roomSize), damping(damping) {}
 
+    void prepare(double sampleRate);
     void processBlock(juce::AudioBuffer<float>& buffer);
 };
 
+// Линии задержки эффектов берутся из арены процессора в prepare
 class Delay {
 public:
+    static constexpr int maxDelaySamples = 48000;
+
     float time;
     float feedback;
-    std::vector<float> delayBuffer;
+    float* delayBuffer;
     int delayBufferPos;
 
     Delay(float time = 0.5f, float feedback = 0.5f)
-        : time(time), feedback(feedback), delayBufferPos(0) {
-        delayBuffer.resize(48000.0);
-    }
+        : time(time), feedback(feedback), delayBuffer(nullptr), delayBufferPos(0) {}
 
+    void prepare(DspArena& arena);
     void processBlock(juce::AudioBuffer<float>& buffer);
 };
 
@@ -57,17 +74,20 @@ public:
     float rate;
     float depth;
     float sampleRate;
-    float phase;
+    LFO lfo;
+
+    // Глубина до 15 мс
+    static constexpr int maxDelaySamples = 15 * 48;
 
-    std::vector<float> delayBuffer;
+    float* delayBuffer;
     int delayBufferPos;
 
     Flanger(float sr = 48000.0, float rate = 0.25f, float depth = 0.5f)
-        : rate(rate * 5), depth(depth * 15), sampleRate(sr), phase(0.0f), delayBufferPos(0) {
-        int delayBufferSize = static_cast<int>(this->depth / 1000.0f * sampleRate);
-        delayBuffer.resize(delayBufferSize, 0.0f);
+        : rate(rate * 5), depth(depth * 15), sampleRate(sr), delayBuffer(nullptr), delayBufferPos(0) {
+        lfo.addTap(0.0f);
     }
 
+    void prepare(DspArena& arena);
     void processBlock(juce::AudioBuffer<float>& buffer);
 };
 
@@ -75,17 +95,26 @@ class Chorus {
 public:
     float rate; 
     float depth;
-    std::vector<float> delayBuffer;
+    float* delayBuffer;
     int delayBufferPos;
-    float phase;
+    LFO lfo;
     float sampleRate;
 
+    // Самая длинная задержка - 20 сэмплов плюс 15 мс глубины, берём с запасом
+    static constexpr int bufferSize = 2048;
+
+    // Отводы LFO: модуляция высоты для двух линий и сами задержки в противофазе
+    enum Tap { PitchTap1, PitchTap2, DelayTap1, DelayTap2 };
+
     Chorus(float rate = 0.25f, float depth = 0.5f, float sampleRate = 48000.0f)
-        : rate(rate), depth(15 * depth), sampleRate(sampleRate), delayBufferPos(0), phase(0) {
-        int maxDelaySamples = static_cast<int>(depth * sampleRate);
-        delayBuffer.resize(maxDelaySamples, 0.0f);
+        : rate(rate), depth(15 * depth), delayBuffer(nullptr), delayBufferPos(0), sampleRate(sampleRate) {
+        lfo.addTap(0.5f);
+        lfo.addTap(-0.5f);
+        lfo.addTap(0.0f);
+        lfo.addTap(juce::MathConstants<float>::pi);
     }
 
+    void prepare(DspArena& arena);
     void processBlock(juce::AudioBuffer<float>& buffer);
 };
 
@@ -103,18 +132,36 @@ public:
     }
 
     void updateFilter();
+    void reset();
     void processBlock(juce::AudioBuffer<float>& buffer);
 };
 
 
+using EffectVariant = std::variant<Overdrive, Reverb, Delay, Flanger, Chorus, Filter, Convolution, Ensemble>;
+
 struct FxBlock {
+    // Диапазон обоих параметров, как у ручек; модуляция тоже не выходит за него
+    static constexpr float minValue = 0.01f;
+    static constexpr float maxValue = 1.0f;
+
     std::string name;
     bool isActive;
     std::map<std::string, float> parameters;
-    std::unique_ptr <std::variant<Overdrive, Reverb, Delay, Flanger, Chorus, Filter>> effect;
+    std::unique_ptr<EffectVariant> effect;
 
     FxBlock(const std::string& name);
+    // Настраивает эффект на частоту, берёт его линии задержки из арены и сбрасывает всё
+    // состояние: хвосты, фазы LFO, память фильтров. После prepare звук эффекта зависит
+    // только от того, что в него подали дальше.
+    void prepare(double sampleRate, DspArena& arena);
+    // false, пока Convolution ждёт построения ИХ в фоне
+    bool isReady();
     void processBlock(juce::AudioBuffer<float>& buffer);
+    // Облегчённый режим под нагрузкой; пока это только половина голосов Ensemble
+    void setReducedQuality(bool reduced);
+    // Ставит значение прямо в эффект, parameters не трогает.
+    // Номер параметра - его место в parameters (ключи идут по алфавиту).
+    void setValue(int parameter, float value);
     std::map<std::string, float> getDefaultParameters(const std::string& name);
 };
 
@@ -162,6 +209,8 @@ public:
 
     void setEffect1(int index, float value);
     void setEffect2(int index, float value);
+    void setEffectParameter(int index, int parameter, float value);
+    void modulateEffect(int index, int parameter, float value);
 
     std::vector<FxBlock> effects;
 };
@@ -0,0 +1,132 @@
+/*
+  ==============================================================================
+
+    FxPipeline.cpp
+    Created: 25 Oct 2026 10:18:44am
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#include "FxPipeline.h"
+#include <algorithm>
+
+namespace {
+    // Кольцо и линейный буфер, перенос через конец кольца
+    void writeRing(juce::AudioBuffer<float>& ring, int channel, int position, const float* source, int numSamples) {
+        int first = std::min(numSamples, ring.getNumSamples() - position);
+        ring.copyFrom(channel, position, source, first);
+        if (first < numSamples) {
+            ring.copyFrom(channel, 0, source + first, numSamples - first);
+        }
+    }
+
+    void readRing(const juce::AudioBuffer<float>& ring, int channel, int position, float* dest, int numSamples) {
+        int first = std::min(numSamples, ring.getNumSamples() - position);
+        juce::FloatVectorOperations::copy(dest, ring.getReadPointer(channel, position), first);
+        if (first < numSamples) {
+            juce::FloatVectorOperations::copy(dest + first, ring.getReadPointer(channel, 0), numSamples - first);
+        }
+    }
+}
+
+FxPipeline::FxPipeline()
+    : juce::Thread("SynthFM effects") {}
+
+FxPipeline::~FxPipeline() {
+    stopThread(1000);
+}
+
+void FxPipeline::start(int maxBlockSize, double sampleRate) {
+    if (!isThreadRunning()) {
+        startRealtimeThread(juce::Thread::RealtimeOptions{}.withApproximateAudioProcessingTime(maxBlockSize, sampleRate));
+    }
+}
+
+bool FxPipeline::isRunning() {
+    return isThreadRunning();
+}
+
+void FxPipeline::prepare(int maxBlockSize, int channels, int auxChannels) {
+    latency = juce::jmax(1, maxBlockSize);
+    ringSize = 2 * latency;
+    numChannels = channels;
+    numAuxChannels = auxChannels;
+    input.setSize(numChannels + 1, latency);
+    output.setSize(numChannels, ringSize);
+    auxDelay.setSize(numAuxChannels, ringSize);
+    reset();
+}
+
+void FxPipeline::reset() {
+    input.clear();
+    output.clear();
+    auxDelay.clear();
+    writePosition = 0;
+}
+
+int FxPipeline::getLatency() {
+    return latency;
+}
+
+void FxPipeline::waitUntilIdle() {
+    while (busy.load()) {
+    }
+}
+
+void FxPipeline::process(juce::AudioBuffer<float>& buffer, const float* dry, Chain chain, void* context) {
+    int channels = std::min(numChannels, buffer.getNumChannels());
+    int auxChannels = std::min(numAuxChannels, buffer.getNumChannels() - channels);
+
+    // Блок длиннее заявленного в prepareToPlay идёт кусками, по куску в полёте
+    for (int start = 0; start < buffer.getNumSamples(); start += latency) {
+        int numSamples = std::min(latency, buffer.getNumSamples() - start);
+        waitUntilIdle();
+
+        for (int channel = 0; channel < channels; ++channel) {
+            input.copyFrom(channel, 0, buffer, channel, start, numSamples);
+        }
+        if (dry != nullptr) {
+            input.copyFrom(numChannels, 0, dry + start, numSamples);
+        }
+        else {
+            input.clear(numChannels, 0, numSamples);
+        }
+
+        // Поток дописал в кольцо всё до writePosition, а читаем мы на latency раньше
+        int readPosition = (writePosition + ringSize - latency) % ringSize;
+        for (int channel = 0; channel < channels; ++channel) {
+            readRing(output, channel, readPosition, buffer.getWritePointer(channel, start), numSamples);
+        }
+        for (int aux = 0; aux < auxChannels; ++aux) {
+            float* data = buffer.getWritePointer(channels + aux, start);
+            writeRing(auxDelay, aux, writePosition, data, numSamples);
+            readRing(auxDelay, aux, readPosition, data, numSamples);
+        }
+
+        jobChain = chain;
+        jobContext = context;
+        jobPosition = writePosition;
+        jobSamples = numSamples;
+        writePosition = (writePosition + numSamples) % ringSize;
+        busy.store(true);
+        notify();
+    }
+}
+
+void FxPipeline::run() {
+    while (!threadShouldExit()) {
+        if (!busy.load()) {
+            wait(10);
+            continue;
+        }
+
+        juce::AudioBuffer<float> block(input.getArrayOfWritePointers(), numChannels, jobSamples);
+        jobChain(jobContext, block);
+        for (int channel = 0; channel < numChannels; ++channel) {
+            block.addFrom(channel, 0, input.getReadPointer(numChannels), jobSamples);
+            writeRing(output, channel, jobPosition, block.getReadPointer(channel), jobSamples);
+        }
+        busy.store(false);
+    }
+}
@@ -0,0 +1,60 @@
+/*
+  ==============================================================================
+
+    FxPipeline.h
+    Created: 25 Oct 2026 10:18:44am
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+
+// Цепочка эффектов на отдельном потоке реального времени: пока он обрабатывает блок N,
+// аудиопоток рендерит голоса блока N+1. Хост может менять размер блока, поэтому выход
+// идёт через кольцо с постоянной задержкой в максимальный блок. Каналы сверх основных
+// (выходы партий) задерживаются на столько же, чтобы хост выровнял всё одной компенсацией.
+class FxPipeline : private juce::Thread {
+public:
+    using Chain = void (*)(void* context, juce::AudioBuffer<float>& buffer);
+
+    FxPipeline();
+    ~FxPipeline() override;
+
+    void start(int maxBlockSize, double sampleRate);
+    bool isRunning();
+
+    // Вызывать только при свободном потоке; задержка равна maxBlockSize
+    void prepare(int maxBlockSize, int numChannels, int numAuxChannels);
+    void reset();
+    int getLatency();
+
+    // Ждёт, пока поток доделает отданный ему блок. После этого цепочку можно трогать.
+    void waitUntilIdle();
+
+    // Отдаёт потоку первые numChannels каналов buffer и сухой сигнал dry (добавляется после
+    // цепочки, может быть nullptr) и заменяет весь buffer выходом, задержанным на getLatency
+    void process(juce::AudioBuffer<float>& buffer, const float* dry, Chain chain, void* context);
+
+private:
+    juce::AudioBuffer<float> input;      // основные каналы и последним сухой
+    juce::AudioBuffer<float> output;     // кольцо на две задержки
+    juce::AudioBuffer<float> auxDelay;
+    int latency = 0;
+    int ringSize = 0;
+    int numChannels = 0;
+    int numAuxChannels = 0;
+    int writePosition = 0;
+
+    Chain jobChain = nullptr;
+    void* jobContext = nullptr;
+    int jobPosition = 0;
+    int jobSamples = 0;
+    std::atomic<bool> busy{ false };
+
+    void run() override;
+
+    JUCE_DECLARE_NON_COPYABLE(FxPipeline)
+};
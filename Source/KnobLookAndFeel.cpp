@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+    KnobLookAndFeel.cpp
+    Created: 22 Oct 2026 3:18:27pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#include "KnobLookAndFeel.h"
+
+namespace {
+    // Та же геометрия, что у LookAndFeel_V4::drawRotarySlider
+    struct KnobGeometry {
+        juce::Rectangle<float> bounds;
+        float radius;
+        float lineWidth;
+        float arcRadius;
+
+        KnobGeometry(float width, float height) {
+            bounds = juce::Rectangle<float>(width, height).reduced(10.0f);
+            radius = juce::jmin(bounds.getWidth(), bounds.getHeight()) / 2.0f;
+            lineWidth = juce::jmin(8.0f, radius * 0.5f);
+            arcRadius = radius - lineWidth * 0.5f;
+        }
+    };
+}
+
+juce::Image& KnobLookAndFeel::getKnobBackground(int width, int height, juce::Colour colour,
+    float startAngle, float endAngle, float scale) {
+    for (auto& knob : cache) {
+        if (knob.width == width && knob.height == height && knob.colour == colour.getARGB()
+            && knob.startAngle == startAngle && knob.endAngle == endAngle && knob.scale == scale) {
+            return knob.image;
+        }
+    }
+
+    // Размеров ручек немного; переполнение значит, что окно тянут мышью - начинаем заново
+    if (cache.size() >= maxCachedImages) {
+        cache.clear();
+    }
+
+    juce::Image image(juce::Image::ARGB, juce::jmax(1, juce::roundToInt(width * scale)),
+        juce::jmax(1, juce::roundToInt(height * scale)), true);
+    {
+        juce::Graphics g(image);
+        g.addTransform(juce::AffineTransform::scale(scale));
+
+        KnobGeometry geometry(static_cast<float>(width), static_cast<float>(height));
+        juce::Path backgroundArc;
+        backgroundArc.addCentredArc(geometry.bounds.getCentreX(), geometry.bounds.getCentreY(), geometry.arcRadius,
+            geometry.arcRadius, 0.0f, startAngle, endAngle, true);
+        g.setColour(colour);
+        g.strokePath(backgroundArc, juce::PathStrokeType(geometry.lineWidth, juce::PathStrokeType::curved, juce::PathStrokeType::rounded));
+    }
+
+    cache.push_back({ width, height, colour.getARGB(), startAngle, endAngle, scale, image });
+    return cache.back().image;
+}
+
+void KnobLookAndFeel::drawRotarySlider(juce::Graphics& g, int x, int y, int width, int height, float sliderPos,
+    float rotaryStartAngle, float rotaryEndAngle, juce::Slider& slider) {
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+
+    auto outline = slider.findColour(juce::Slider::rotarySliderOutlineColourId);
+    auto fill = slider.findColour(juce::Slider::rotarySliderFillColourId);
+    float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+    auto area = juce::Rectangle<int>(x, y, width, height).toFloat();
+    g.drawImage(getKnobBackground(width, height, outline, rotaryStartAngle, rotaryEndAngle, scale), area);
+
+    KnobGeometry geometry(static_cast<float>(width), static_cast<float>(height));
+    auto centre = geometry.bounds.getCentre() + area.getPosition();
+    float toAngle = rotaryStartAngle + sliderPos * (rotaryEndAngle - rotaryStartAngle);
+
+    if (slider.isEnabled()) {
+        juce::Path valueArc;
+        valueArc.addCentredArc(centre.x, centre.y, geometry.arcRadius, geometry.arcRadius, 0.0f, rotaryStartAngle, toAngle, true);
+        g.setColour(fill);
+        g.strokePath(valueArc, juce::PathStrokeType(geometry.lineWidth, juce::PathStrokeType::curved, juce::PathStrokeType::rounded));
+    }
+
+    float thumbWidth = geometry.lineWidth * 2.0f;
+    juce::Point<float> thumbPoint(centre.x + geometry.arcRadius * std::cos(toAngle - juce::MathConstants<float>::halfPi),
+        centre.y + geometry.arcRadius * std::sin(toAngle - juce::MathConstants<float>::halfPi));
+    g.setColour(slider.findColour(juce::Slider::thumbColourId));
+    g.fillEllipse(juce::Rectangle<float>(thumbWidth, thumbWidth).withCentre(thumbPoint));
+}
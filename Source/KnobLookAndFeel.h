@@ -0,0 +1,39 @@
+/*
+  ==============================================================================
+
+    KnobLookAndFeel.h
+    Created: 22 Oct 2026 3:18:27pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+
+// LookAndFeel_V4 с кешированной подложкой ручек. Неподвижная дуга одинакова у всех
+// ручек одного размера, поэтому рисуется один раз в картинку, а поверх живьём
+// рисуются только дуга значения и бегунок. Один экземпляр делят все окна плагина.
+class KnobLookAndFeel : public juce::LookAndFeel_V4 {
+public:
+    static constexpr int maxCachedImages = 64;
+
+    void drawRotarySlider(juce::Graphics& g, int x, int y, int width, int height, float sliderPos,
+        float rotaryStartAngle, float rotaryEndAngle, juce::Slider& slider) override;
+
+private:
+    struct CachedKnob {
+        int width;
+        int height;
+        juce::uint32 colour;
+        float startAngle;
+        float endAngle;
+        float scale;
+        juce::Image image;
+    };
+
+    std::vector<CachedKnob> cache;
+
+    juce::Image& getKnobBackground(int width, int height, juce::Colour colour, float startAngle, float endAngle, float scale);
+};
@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+
+    LFO.cpp
+    Created: 18 Oct 2026 5:12:48pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#include "LFO.h"
+#include <cmath>
+
+LFO::LFO()
+    : sinState(0.0), cosState(1.0), rotationSin(0.0), rotationCos(1.0), frequency(0.0f), sampleRate(48000.0f),
+    numTaps(0), tapSin{}, tapCos{}, sinBlock{}, cosBlock{}, taps{} {}
+
+void LFO::setFrequency(float newFrequency, float newSampleRate) {
+    if (newFrequency == frequency && newSampleRate == sampleRate) {
+        return;
+    }
+    frequency = newFrequency;
+    sampleRate = newSampleRate;
+    double increment = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+    rotationSin = std::sin(increment);
+    rotationCos = std::cos(increment);
+}
+
+int LFO::addTap(float phaseOffset) {
+    if (numTaps == maxTaps) {
+        return -1;
+    }
+    tapSin[numTaps] = std::sin(phaseOffset);
+    tapCos[numTaps] = std::cos(phaseOffset);
+    return numTaps++;
+}
+
+void LFO::generate(int numSamples) {
+    double s = sinState;
+    double c = cosState;
+    for (int i = 0; i < numSamples; ++i) {
+        sinBlock[i] = static_cast<float>(s);
+        cosBlock[i] = static_cast<float>(c);
+        double nextSin = s * rotationCos + c * rotationSin;
+        c = c * rotationCos - s * rotationSin;
+        s = nextSin;
+    }
+    // Поправка амплитуды, чтобы ошибка округления не накапливалась от блока к блоку
+    double gain = 1.5 - 0.5 * (s * s + c * c);
+    sinState = s * gain;
+    cosState = c * gain;
+
+    // sin(phase + offset) = sin(phase) * cos(offset) + cos(phase) * sin(offset)
+    for (int t = 0; t < numTaps; ++t) {
+        float* tap = taps[t].data();
+        for (int i = 0; i < numSamples; ++i) {
+            tap[i] = sinBlock[i] * tapCos[t] + cosBlock[i] * tapSin[t];
+        }
+    }
+}
+
+const float* LFO::getTap(int index) const {
+    return taps[index].data();
+}
+
+void LFO::reset() {
+    sinState = 0.0;
+    cosState = 1.0;
+}
@@ -0,0 +1,44 @@
+/*
+  ==============================================================================
+
+    LFO.h
+    Created: 18 Oct 2026 5:12:48pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <array>
+
+// Медленный синусоидальный LFO на вращающемся фазоре: вместо std::sin на каждый сэмпл
+// пара (sin, cos) поворачивается на фиксированный угол. Отводы со сдвигом фазы
+// получаются из той же пары двумя умножениями.
+class LFO {
+public:
+    static constexpr int maxTaps = 8;
+    static constexpr int maxBlockSize = 64;
+
+    LFO();
+
+    void setFrequency(float newFrequency, float newSampleRate);
+    int addTap(float phaseOffset);
+    void generate(int numSamples);
+    const float* getTap(int index) const;
+    void reset();
+
+private:
+    double sinState;
+    double cosState;
+    double rotationSin;
+    double rotationCos;
+    float frequency;
+    float sampleRate;
+
+    int numTaps;
+    std::array<float, maxTaps> tapSin;
+    std::array<float, maxTaps> tapCos;
+    std::array<float, maxBlockSize> sinBlock;
+    std::array<float, maxBlockSize> cosBlock;
+    std::array<std::array<float, maxBlockSize>, maxTaps> taps;
+};
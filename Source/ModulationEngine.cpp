@@ -0,0 +1,305 @@
+/*
+  ==============================================================================
+
+    ModulationEngine.cpp
+    Created: 23 Oct 2026 10:14:52am
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#include "ModulationEngine.h"
+#include <cmath>
+
+ModulationEngine::ModulationEngine()
+    : sampleRate(48000.0f), controlRate(maxControlRate), used(numDestinations, false),
+    sources(numSources * maxVoices, 0.0f), values(numDestinations * maxVoices, 0.0f),
+    globalSources(numSources, 0.0f), globalValues(numDestinations, 0.0f),
+    lfoPhases(ModulationSettings::numLfos * maxVoices, 0.0f), heldValues(ModulationSettings::numLfos * maxVoices, 0.0f),
+    globalPhases{}, globalHeld{},
+    envelopeLevels(ModulationSettings::numEnvelopes * maxVoices, 0.0f), envelopeStages(ModulationSettings::numEnvelopes * maxVoices, Idle),
+    velocities(maxVoices, 0.0f), keyTracks(maxVoices, 0.0f), polyPressures(maxVoices, 0.0f),
+    timbres(maxVoices, 0.0f), modWheel(0.0f), channelPressure(0.0f), globalTimbre(0.0f) {
+    // Место под маршруты выделяется заранее: setSettings зовётся и из аудиопотока при смене программы
+    routes.reserve(ModulationSettings::maxRoutes);
+    activeDestinations.reserve(numDestinations);
+    setSettings(Patch::getDefault().modulation);
+}
+
+void ModulationEngine::setSampleRate(float newSampleRate) {
+    sampleRate = newSampleRate;
+}
+
+void ModulationEngine::reset() {
+    std::fill(lfoPhases.begin(), lfoPhases.end(), 0.0f);
+    std::fill(heldValues.begin(), heldValues.end(), 0.0f);
+    std::fill(std::begin(globalPhases), std::end(globalPhases), 0.0f);
+    std::fill(std::begin(globalHeld), std::end(globalHeld), 0.0f);
+    std::fill(envelopeLevels.begin(), envelopeLevels.end(), 0.0f);
+    std::fill(envelopeStages.begin(), envelopeStages.end(), Idle);
+    // Постоянное зерно: офлайн-рендер одного патча повторяется сэмпл в сэмпл
+    random.setSeed(0x53464d);
+}
+
+void ModulationEngine::setControlRate(int numSamples) {
+    controlRate = juce::jlimit(1, maxControlRate, numSamples);
+}
+
+int ModulationEngine::getControlRate() {
+    return controlRate;
+}
+
+void ModulationEngine::setSettings(const ModulationSettings& newSettings) {
+    settings = newSettings;
+
+    routes.clear();
+    activeDestinations.clear();
+    for (int d = 0; d < numDestinations; ++d) {
+        bool wasUsed = used[d];
+        used[d] = false;
+        if (wasUsed) {
+            // Назначение без маршрутов возвращается в ноль, процессор применит его ещё раз
+            std::fill(values.begin() + d * maxVoices, values.begin() + (d + 1) * maxVoices, 0.0f);
+            globalValues[d] = 0.0f;
+        }
+    }
+
+    for (const auto& route : settings.routes) {
+        if (route.amount == 0.0f || route.source < 0 || route.source >= numSources
+            || route.destination < 0 || route.destination >= numDestinations) {
+            continue;
+        }
+        routes.push_back({ route.source, route.destination, route.amount * getDestinationRange(route.destination) });
+        if (!used[route.destination]) {
+            used[route.destination] = true;
+            activeDestinations.push_back(route.destination);
+        }
+    }
+}
+
+void ModulationEngine::noteOn(int voice, int note, float velocity) {
+    velocities[voice] = velocity;
+    keyTracks[voice] = (note - 60) / 60.0f;
+    polyPressures[voice] = 0.0f;
+    for (int l = 0; l < ModulationSettings::numLfos; ++l) {
+        bool retrigger = settings.lfos[l].retrigger > 0.5f;
+        lfoPhases[l * maxVoices + voice] = retrigger ? 0.0f : globalPhases[l];
+        heldValues[l * maxVoices + voice] = retrigger ? random.nextFloat() * 2.0f - 1.0f : globalHeld[l];
+    }
+    for (int e = 0; e < ModulationSettings::numEnvelopes; ++e) {
+        envelopeLevels[e * maxVoices + voice] = 0.0f;
+        envelopeStages[e * maxVoices + voice] = Attack;
+    }
+}
+
+void ModulationEngine::noteOff(int voice) {
+    for (int e = 0; e < ModulationSettings::numEnvelopes; ++e) {
+        int& stage = envelopeStages[e * maxVoices + voice];
+        if (stage != Idle) {
+            stage = Release;
+        }
+    }
+}
+
+void ModulationEngine::setModWheel(float value) {
+    modWheel = value;
+}
+
+void ModulationEngine::setChannelPressure(float value) {
+    channelPressure = value;
+}
+
+void ModulationEngine::setPolyPressure(int voice, float value) {
+    polyPressures[voice] = value;
+}
+
+void ModulationEngine::setTimbre(int voice, float value) {
+    timbres[voice] = value;
+}
+
+void ModulationEngine::setGlobalTimbre(float value) {
+    globalTimbre = value;
+}
+
+float ModulationEngine::getLfoValue(int lfo, float phase, float held) {
+    switch (juce::jlimit(0, static_cast<int>(SampleAndHold), juce::roundToInt(settings.lfos[lfo].shape))) {
+    case Sine:     return std::sin(juce::MathConstants<float>::twoPi * phase);
+    case Triangle: return 1.0f - 4.0f * std::abs(phase - 0.5f);
+    case Saw:      return 2.0f * phase - 1.0f;
+    case Square:   return phase < 0.5f ? 1.0f : -1.0f;
+    default:       return held;
+    }
+}
+
+void ModulationEngine::process(int numSamples, int numVoices) {
+    if (routes.empty()) {
+        return;
+    }
+    float seconds = numSamples / sampleRate;
+
+    for (int l = 0; l < ModulationSettings::numLfos; ++l) {
+        float increment = std::max(0.0f, settings.lfos[l].rate) * seconds;
+        float* phases = lfoPhases.data() + l * maxVoices;
+        float* held = heldValues.data() + l * maxVoices;
+        float* output = sources.data() + (Lfo1 + l) * maxVoices;
+
+        globalPhases[l] += increment;
+        if (globalPhases[l] >= 1.0f) {
+            globalPhases[l] -= std::floor(globalPhases[l]);
+            globalHeld[l] = random.nextFloat() * 2.0f - 1.0f;
+        }
+        globalSources[Lfo1 + l] = getLfoValue(l, globalPhases[l], globalHeld[l]);
+
+        for (int v = 0; v < numVoices; ++v) {
+            phases[v] += increment;
+            if (phases[v] >= 1.0f) {
+                phases[v] -= std::floor(phases[v]);
+                held[v] = random.nextFloat() * 2.0f - 1.0f;
+            }
+            output[v] = getLfoValue(l, phases[v], held[v]);
+        }
+    }
+
+    // Огибающие линейные, с шагом в контрольный блок
+    for (int e = 0; e < ModulationSettings::numEnvelopes; ++e) {
+        const EnvelopeSettings& envelope = settings.envelopes[e];
+        float attackStep = seconds / std::max(0.001f, envelope.attack);
+        float decayStep = seconds * (1.0f - envelope.sustain) / std::max(0.001f, envelope.decay);
+        float releaseStep = seconds / std::max(0.001f, envelope.release);
+        float* levels = envelopeLevels.data() + e * maxVoices;
+        int* stages = envelopeStages.data() + e * maxVoices;
+
+        for (int v = 0; v < numVoices; ++v) {
+            switch (stages[v]) {
+            case Attack:
+                levels[v] += attackStep;
+                if (levels[v] >= 1.0f) {
+                    levels[v] = 1.0f;
+                    stages[v] = Decay;
+                }
+                break;
+            case Decay:
+                levels[v] -= decayStep;
+                if (levels[v] <= envelope.sustain) {
+                    levels[v] = envelope.sustain;
+                    stages[v] = Sustain;
+                }
+                break;
+            case Sustain:
+                levels[v] = envelope.sustain;
+                break;
+            case Release:
+                levels[v] -= releaseStep;
+                if (levels[v] <= 0.0f) {
+                    levels[v] = 0.0f;
+                    stages[v] = Idle;
+                }
+                break;
+            default:
+                break;
+            }
+        }
+        std::copy(levels, levels + numVoices, sources.begin() + (Envelope1 + e) * maxVoices);
+        globalSources[Envelope1 + e] = 0.0f;
+    }
+
+    float* aftertouch = sources.data() + Aftertouch * maxVoices;
+    for (int v = 0; v < numVoices; ++v) {
+        aftertouch[v] = std::max(channelPressure, polyPressures[v]);
+    }
+    std::copy(velocities.begin(), velocities.begin() + numVoices, sources.begin() + Velocity * maxVoices);
+    std::copy(keyTracks.begin(), keyTracks.begin() + numVoices, sources.begin() + KeyTrack * maxVoices);
+    std::copy(timbres.begin(), timbres.begin() + numVoices, sources.begin() + Timbre * maxVoices);
+    juce::FloatVectorOperations::fill(sources.data() + ModWheel * maxVoices, modWheel, numVoices);
+    globalSources[Velocity] = 0.0f;
+    globalSources[KeyTrack] = 0.0f;
+    globalSources[Aftertouch] = channelPressure;
+    globalSources[ModWheel] = modWheel;
+    globalSources[Timbre] = globalTimbre;
+
+    for (int destination : activeDestinations) {
+        juce::FloatVectorOperations::clear(values.data() + destination * maxVoices, numVoices);
+        globalValues[destination] = 0.0f;
+    }
+    for (const auto& route : routes) {
+        juce::FloatVectorOperations::addWithMultiply(values.data() + route.destination * maxVoices,
+            sources.data() + route.source * maxVoices, route.amount, numVoices);
+        globalValues[route.destination] += route.amount * globalSources[route.source];
+    }
+}
+
+void ModulationEngine::evaluateVoice(int voice) {
+    if (routes.empty()) {
+        return;
+    }
+    for (int l = 0; l < ModulationSettings::numLfos; ++l) {
+        sources[(Lfo1 + l) * maxVoices + voice] = getLfoValue(l, lfoPhases[l * maxVoices + voice], heldValues[l * maxVoices + voice]);
+    }
+    for (int e = 0; e < ModulationSettings::numEnvelopes; ++e) {
+        sources[(Envelope1 + e) * maxVoices + voice] = envelopeLevels[e * maxVoices + voice];
+    }
+    sources[Aftertouch * maxVoices + voice] = std::max(channelPressure, polyPressures[voice]);
+    sources[Velocity * maxVoices + voice] = velocities[voice];
+    sources[KeyTrack * maxVoices + voice] = keyTracks[voice];
+    sources[Timbre * maxVoices + voice] = timbres[voice];
+    sources[ModWheel * maxVoices + voice] = modWheel;
+
+    for (int destination : activeDestinations) {
+        values[destination * maxVoices + voice] = 0.0f;
+    }
+    for (const auto& route : routes) {
+        values[route.destination * maxVoices + voice] += route.amount * sources[route.source * maxVoices + voice];
+    }
+}
+
+bool ModulationEngine::isUsed(int destination) {
+    return used[destination];
+}
+
+const float* ModulationEngine::getValues(int destination) {
+    return values.data() + destination * maxVoices;
+}
+
+float ModulationEngine::getGlobalValue(int destination) {
+    return globalValues[destination];
+}
+
+juce::String ModulationEngine::getSourceName(int source) {
+    static const char* const names[numSources] = {
+        "LFO 1", "LFO 2", "Env 1", "Env 2", "Velocity", "Aftertouch", "Mod Wheel", "Key Track", "Timbre"
+    };
+    return source >= 0 && source < numSources ? names[source] : "";
+}
+
+juce::String ModulationEngine::getDestinationName(int destination) {
+    if (destination < OperatorLevel) {
+        return "Op " + juce::String(destination - OperatorPitch + 1) + " Pitch";
+    }
+    if (destination < ModulationDepth) {
+        return "Op " + juce::String(destination - OperatorLevel + 1) + " Level";
+    }
+    if (destination < FilterCutoff) {
+        int modulator = (destination - ModulationDepth) / numOperators;
+        int carrier = (destination - ModulationDepth) % numOperators;
+        if (modulator == carrier) {
+            return "Op " + juce::String(modulator + 1) + " Feedback";
+        }
+        return "Depth " + juce::String(modulator + 1) + " -> " + juce::String(carrier + 1);
+    }
+    if (destination == FilterCutoff) {
+        return "Filter Cutoff";
+    }
+    int slot = (destination - EffectParameter) / 2;
+    return "FX " + juce::String(slot + 1) + " Param " + juce::String((destination - EffectParameter) % 2 + 1);
+}
+
+// Глубина маршрута хранится в -1..1, здесь - сколько это в единицах назначения
+float ModulationEngine::getDestinationRange(int destination) {
+    if (destination < OperatorLevel) {
+        return 12.0f;
+    }
+    if (destination == FilterCutoff) {
+        return 4.0f;
+    }
+    return 1.0f;
+}
@@ -0,0 +1,131 @@
+/*
+  ==============================================================================
+
+    ModulationEngine.h
+    Created: 23 Oct 2026 10:14:52am
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+#include "Patch.h"
+#include "VoiceFilter.h"
+
+// Модуляция с контрольной частотой: LFO, дополнительные огибающие и MIDI-источники
+// считаются раз в контрольный блок (16-32 сэмпла) сразу для всех голосов. Источники и
+// назначения лежат массивами [номер * maxVoices + голос], маршрут - один проход по дорожкам.
+// Голосовые назначения применяет процессор; уровень внутри блока интерполируется линейно.
+class ModulationEngine {
+public:
+    enum Source {
+        Lfo1,
+        Lfo2,
+        Envelope1,
+        Envelope2,
+        Velocity,
+        Aftertouch,
+        ModWheel,
+        KeyTrack,
+        Timbre,
+        numSources
+    };
+
+    static constexpr int numOperators = PatchParameters::numOperators;
+
+    // Номера назначений хранятся в патче - порядок не менять
+    enum Destination {
+        OperatorPitch = 0,                                              // полутоны, по оператору
+        OperatorLevel = OperatorPitch + numOperators,                   // прибавка к уровню оператора
+        ModulationDepth = OperatorLevel + numOperators,                 // доля глубины, [модулятор * 4 + носитель]
+        FilterCutoff = ModulationDepth + numOperators * numOperators,   // октавы
+        EffectParameter = FilterCutoff + 1,                             // [слот * 2 + параметр], только общие источники
+        numDestinations = EffectParameter + Patch::maxEffects * 2
+    };
+
+    enum LfoShape {
+        Sine,
+        Triangle,
+        Saw,
+        Square,
+        SampleAndHold
+    };
+
+    static constexpr int maxVoices = VoiceFilterBank::maxVoices;
+    // Контрольный блок может быть длиннее блока фильтров: рендер режется на куски по blockSize
+    static constexpr int maxControlRate = 4 * VoiceFilterBank::blockSize;
+
+    ModulationEngine();
+
+    void setSampleRate(float newSampleRate);
+    // Фазы LFO, огибающие и генератор S&H - в начальное состояние; контроллеры не трогает
+    void reset();
+    void setControlRate(int numSamples);
+    int getControlRate();
+    void setSettings(const ModulationSettings& newSettings);
+
+    void noteOn(int voice, int note, float velocity);
+    void noteOff(int voice);
+    void setModWheel(float value);
+    void setChannelPressure(float value);
+    void setPolyPressure(int voice, float value);
+    void setTimbre(int voice, float value);
+    void setGlobalTimbre(float value);
+
+    // Продвигает источники на numSamples и считает назначения для голосов [0, numVoices)
+    void process(int numSamples, int numVoices);
+    // Считает назначения одного голоса по его текущему состоянию, ничего не продвигая:
+    // нота, начавшаяся внутри контрольного блока, получает их до первого сэмпла
+    void evaluateVoice(int voice);
+
+    bool isUsed(int destination);
+    const float* getValues(int destination);
+    float getGlobalValue(int destination);
+
+    static juce::String getSourceName(int source);
+    static juce::String getDestinationName(int destination);
+    static float getDestinationRange(int destination);
+
+private:
+    enum EnvelopeStage { Idle, Attack, Decay, Sustain, Release };
+
+    struct ActiveRoute {
+        int source;
+        int destination;
+        float amount;
+    };
+
+    ModulationSettings settings;
+    float sampleRate;
+    int controlRate;
+
+    std::vector<ActiveRoute> routes;
+    std::vector<int> activeDestinations;
+    std::vector<bool> used;
+
+    std::vector<float> sources;        // [source * maxVoices + voice]
+    std::vector<float> values;         // [destination * maxVoices + voice]
+    std::vector<float> globalSources;
+    std::vector<float> globalValues;
+
+    std::vector<float> lfoPhases;      // [lfo * maxVoices + voice]
+    std::vector<float> heldValues;
+    float globalPhases[ModulationSettings::numLfos];
+    float globalHeld[ModulationSettings::numLfos];
+
+    std::vector<float> envelopeLevels; // [envelope * maxVoices + voice]
+    std::vector<int> envelopeStages;
+
+    std::vector<float> velocities;
+    std::vector<float> keyTracks;
+    std::vector<float> polyPressures;
+    std::vector<float> timbres;
+    float modWheel;
+    float channelPressure;
+    float globalTimbre;
+    juce::Random random;
+
+    float getLfoValue(int lfo, float phase, float held);
+};
@@ -1,77 +1,132 @@
 #include "ModulationMatrix.h"
+#include <algorithm>
 #include <stdexcept>
-#include <iostream>
-#include <queue>
 
-ModulationMatrix::ModulationMatrix(std::vector<Oscillator*>& oscillators)
-    : oscillators(oscillators), modulationDepths(4, std::vector<float>(4, 0.0)), connections(4, std::vector<bool>(4, false)) {
-    if (oscillators.size() != 4) {
+ModulationMatrix::ModulationMatrix(std::vector<Oscillator*>& oscillators) {
+    if (oscillators.size() != numOperators) {
         throw std::invalid_argument("There must be exactly four oscillators.");
     }
+    for (int i = 0; i < numOperators; ++i) {
+        this->oscillators[i] = oscillators[i];
+    }
+}
+
+bool ModulationMatrix::isValidIndex(int index) {
+    return index >= 0 && index < numOperators;
 }
 
+// Циклы и самомодуляция разрешены: они идут через задержку на сэмпл, как обратная связь в DX
 bool ModulationMatrix::setModulation(int modulatorIdx, int carrierIdx, float modulationDepth) {
-    if (carrierIdx == modulatorIdx) {
-        throw std::invalid_argument("An oscillator cannot modulate itself.");
+    if (!isValidIndex(modulatorIdx) || !isValidIndex(carrierIdx)) {
+        return false;
     }
     modulationDepths[modulatorIdx][carrierIdx] = modulationDepth;
-    connections[modulatorIdx][carrierIdx] = true;
-    if (isCyclic()) {
-        connections[modulatorIdx][carrierIdx] = false;
-        modulationDepths[modulatorIdx][carrierIdx] = 0.0;
-        return false;
+    effectiveDepths[modulatorIdx][carrierIdx] = modulationDepth * depthScales[modulatorIdx][carrierIdx];
+    if (!connections[modulatorIdx][carrierIdx]) {
+        connections[modulatorIdx][carrierIdx] = true;
+        compile();
     }
     return true;
 }
 
 bool ModulationMatrix::removeModulation(int modulatorIdx, int carrierIdx) {
+    if (!isValidIndex(modulatorIdx) || !isValidIndex(carrierIdx)) {
+        return false;
+    }
     modulationDepths[modulatorIdx][carrierIdx] = 0.0;
-    connections[modulatorIdx][carrierIdx] = false;
+    effectiveDepths[modulatorIdx][carrierIdx] = 0.0;
+    if (connections[modulatorIdx][carrierIdx]) {
+        connections[modulatorIdx][carrierIdx] = false;
+        compile();
+    }
+    return true;
+}
+
+// Меняет глубину существующей связи без пересборки порядка - для частых обновлений
+bool ModulationMatrix::setDepth(int modulatorIdx, int carrierIdx, float modulationDepth) {
+    if (!isValidIndex(modulatorIdx) || !isValidIndex(carrierIdx) || !connections[modulatorIdx][carrierIdx]) {
+        return false;
+    }
+    modulationDepths[modulatorIdx][carrierIdx] = modulationDepth;
+    effectiveDepths[modulatorIdx][carrierIdx] = modulationDepth * depthScales[modulatorIdx][carrierIdx];
     return true;
 }
 
+void ModulationMatrix::setDepthModulation(int modulatorIdx, int carrierIdx, float scale) {
+    scale = std::max(0.0f, scale);
+    depthScales[modulatorIdx][carrierIdx] = scale;
+    effectiveDepths[modulatorIdx][carrierIdx] = modulationDepths[modulatorIdx][carrierIdx] * scale;
+}
+
+void ModulationMatrix::setLevelModulation(int index, float offset, int numSamples) {
+    if (numSamples <= 0) {
+        levelOffsets[index] = offset;
+        levelSteps[index] = 0.0f;
+    }
+    else {
+        levelSteps[index] = (offset - levelOffsets[index]) / static_cast<float>(numSamples);
+    }
+}
+
 float ModulationMatrix::process() {
-    // Получаем порядок обработки осцилляторов с помощью топологической сортировки
-    std::vector<int> order = topologicalSort();
-    std::vector<float> outputs(4, 0.0);
-    std::vector<float> originalFrequencies(4);
-    // Сохраняем исходные частоты каждого осциллятора
-    for (int i = 0; i < 4; ++i) {
-        originalFrequencies[i] = oscillators[i]->getFrequency();
-    }
-    // Обходим осцилляторы в порядке, определенном топологической сортировкой
-    for (int modulatorIdx : order) {
-        // Получаем следующий сэмпл от текущего осциллятора (модулятора)
-        outputs[modulatorIdx] = oscillators[modulatorIdx]->nextSample();
-        // Проходим по всем возможным осцилляторам-носителям
-        for (int carrierIdx = 0; carrierIdx < 4; ++carrierIdx) {
-            // Проверяем, существует ли связь модуляции между текущими осцилляторами
-            if (connections[modulatorIdx][carrierIdx]) {
-                float modulationEffect = outputs[modulatorIdx] * modulationDepths[modulatorIdx][carrierIdx];
-                // Применяем модуляцию, изменяя частоту осциллятора-носителя
-                oscillators[carrierIdx]->setFrequency(oscillators[carrierIdx]->getFrequency() + modulationEffect);
-            }
-        }
+    // Обходим осцилляторы в заранее собранном порядке: к моменту обработки носителя
+    // его модуляторы либо уже посчитаны, либо это задержанная связь из цикла
+    float delayedOutputs[numOperators];
+    for (int idx = 0; idx < numOperators; ++idx) {
+        // Усреднение двух последних сэмплов гасит "рыскание" обратной связи на больших глубинах, как в DX7
+        delayedOutputs[idx] = 0.5f * (outputs[idx] + previousOutputs[idx]);
+        previousOutputs[idx] = outputs[idx];
     }
-    // Вычисляем итоговый результат, суммируя выходные значения, умноженные на уровень каждого осциллятора
+
     float res = 0.0;
-    for (int idx = 0; idx < 4; ++idx) {
-        res += outputs[idx] * oscillators[idx]->getLevel();
-        // Восстанавливаем исходные частоты осцилляторов после обработки
-        oscillators[idx]->setFrequency(originalFrequencies[idx]);
+    for (int position = 0; position < numOperators; ++position) {
+        int carrierIdx = program.order[position];
+        Oscillator* carrier = oscillators[carrierIdx];
+        if (program.numInputs[carrierIdx] == 0) {
+            outputs[carrierIdx] = carrier->nextSample();
+        }
+        else {
+            float modulationEffect = 0.0f;
+            for (int i = 0; i < program.numInputs[carrierIdx]; ++i) {
+                const Program::Input& input = program.inputs[carrierIdx][i];
+                float modulatorOutput = input.delayed ? delayedOutputs[input.modulator] : outputs[input.modulator];
+                modulationEffect += modulatorOutput * effectiveDepths[input.modulator][carrierIdx];
+            }
+            // Модуляция сдвигает частоту носителя только на этот сэмпл
+            outputs[carrierIdx] = carrier->nextSample(modulationEffect);
+        }
+        res += outputs[carrierIdx] * std::max(0.0f, carrier->getLevel() + levelOffsets[carrierIdx]);
+        levelOffsets[carrierIdx] += levelSteps[carrierIdx];
     }
     return res * level;
 }
 
-
+void ModulationMatrix::reset() {
+    for (int idx = 0; idx < numOperators; ++idx) {
+        outputs[idx] = 0.0f;
+        previousOutputs[idx] = 0.0f;
+        levelOffsets[idx] = 0.0f;
+        levelSteps[idx] = 0.0f;
+        for (int carrierIdx = 0; carrierIdx < numOperators; ++carrierIdx) {
+            depthScales[idx][carrierIdx] = 1.0f;
+            effectiveDepths[idx][carrierIdx] = modulationDepths[idx][carrierIdx];
+        }
+    }
+}
 
 void ModulationMatrix::setLevel(float newLevel) {
     level = newLevel;
 }
 
+void ModulationMatrix::bind(Oscillator* newOscillators) {
+    for (int idx = 0; idx < numOperators; ++idx) {
+        oscillators[idx] = &newOscillators[idx];
+    }
+}
+
 bool ModulationMatrix::isCyclic() {
-    std::vector<int> visited(4, 0);
-    for (int i = 0; i < 4; ++i) {
+    int visited[numOperators] = {};
+    for (int i = 0; i < numOperators; ++i) {
         if (visited[i] == 0 && dfs(i, visited)) {
             return true;
         }
@@ -79,12 +134,12 @@ bool ModulationMatrix::isCyclic() {
     return false;
 }
 
-bool ModulationMatrix::dfs(int v, std::vector<int>& visited) {
+bool ModulationMatrix::dfs(int v, int* visited) {
     if (visited[v] == 1) return true;
     if (visited[v] == 2) return false;
 
     visited[v] = 1;
-    for (int i = 0; i < 4; ++i) {
+    for (int i = 0; i < numOperators; ++i) {
         if (connections[v][i] && dfs(i, visited)) {
             return true;
         }
@@ -93,31 +148,56 @@ bool ModulationMatrix::dfs(int v, std::vector<int>& visited) {
     return false;
 }
 
-std::vector<int> ModulationMatrix::topologicalSort() {
-    std::vector<int> inDegree(4, 0);
-    for (int i = 0; i < 4; ++i) {
-        for (int j = 0; j < 4; ++j) {
-            if (connections[i][j]) inDegree[j]++;
+// Топологическая сортировка по Кану. Если остался цикл, берём оператор с наименьшим
+// номером из тех, что лежат на цикле (в нетривиальной компоненте сильной связности
+// оставшегося графа), и все его входы от ещё не обработанных операторов делаем
+// задержанными. Операторы ниже цикла по течению задержек не получают.
+void ModulationMatrix::compile() {
+    Program compiled;
+    bool done[numOperators] = {};
+    int inDegree[numOperators] = {};
+    for (int i = 0; i < numOperators; ++i) {
+        for (int j = 0; j < numOperators; ++j) {
+            if (connections[i][j] && i != j) inDegree[j]++;
         }
     }
 
-    std::queue<int> q;
-    for (int i = 0; i < 4; ++i) {
-        if (inDegree[i] == 0) q.push(i);
-    }
+    for (int position = 0; position < numOperators; ++position) {
+        int next = -1;
+        for (int i = 0; i < numOperators && next < 0; ++i) {
+            if (!done[i] && inDegree[i] == 0) next = i;
+        }
+        if (next < 0) {
+            // Транзитивное замыкание по оставшимся операторам, без обратной связи на себя
+            bool reach[numOperators][numOperators] = {};
+            for (int i = 0; i < numOperators; ++i) {
+                for (int j = 0; j < numOperators; ++j) {
+                    reach[i][j] = !done[i] && !done[j] && i != j && connections[i][j];
+                }
+            }
+            for (int k = 0; k < numOperators; ++k) {
+                for (int i = 0; i < numOperators; ++i) {
+                    for (int j = 0; j < numOperators; ++j) {
+                        reach[i][j] = reach[i][j] || (reach[i][k] && reach[k][j]);
+                    }
+                }
+            }
+            for (int i = 0; i < numOperators && next < 0; ++i) {
+                if (!done[i] && reach[i][i]) next = i;
+            }
+        }
 
-    std::vector<int> result;
-    while (!q.empty()) {
-        int u = q.front(); q.pop();
-        result.push_back(u);
-        for (int i = 0; i < 4; ++i) {
-            if (connections[u][i] && (--inDegree[i] == 0)) {
-                q.push(i);
+        compiled.order[position] = next;
+        for (int modulator = 0; modulator < numOperators; ++modulator) {
+            if (connections[modulator][next]) {
+                compiled.inputs[next][compiled.numInputs[next]++] = { modulator, !done[modulator] };
             }
         }
+        done[next] = true;
+        for (int i = 0; i < numOperators; ++i) {
+            if (connections[next][i] && i != next) inDegree[i]--;
+        }
     }
 
-    if (result.size() != 4) throw std::logic_error("Cyclic dependency detected, cannot perform topological sort");
-
-    return result;
+    program = compiled;
 }
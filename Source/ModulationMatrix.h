@@ -2,25 +2,55 @@
 
 #include "Oscillator.h"
 #include <vector>
-#include <queue>
 
 class ModulationMatrix {
 public:
+    static constexpr int numOperators = 4;
+
     ModulationMatrix() = default;
     ModulationMatrix(std::vector<Oscillator*>& oscillators);
     bool setModulation(int carrierIdx, int modulatorIdx, float modulationDepth);
     bool removeModulation(int carrierIdx, int modulatorIdx);
+    bool setDepth(int modulatorIdx, int carrierIdx, float modulationDepth);
+    // Модуляция с контрольной частотой: множитель глубины и прибавка к уровню,
+    // уровень доходит до значения линейно за numSamples сэмплов (0 - сразу)
+    void setDepthModulation(int modulatorIdx, int carrierIdx, float scale);
+    void setLevelModulation(int index, float offset, int numSamples);
     float process();
+    void reset();
     bool isCyclic();
     void setOutput(int index);
     void setLevel(float newLevel);
+    // После копирования матрица ещё смотрит на операторы оригинала - перевешиваем на свои
+    void bind(Oscillator* newOscillators);
 
 private:
-    float level;
-    std::vector<Oscillator*> oscillators;
-    std::vector<std::vector<float>> modulationDepths;
-    std::vector<std::vector<bool>> connections;
+    // Порядок обхода, собранный заранее. Связи, замыкающие цикл (и самомодуляция),
+    // берут выход модулятора с прошлого сэмпла, поэтому в process() графа уже нет.
+    struct Program {
+        struct Input {
+            int modulator;
+            bool delayed;
+        };
+        int order[numOperators] = { 0, 1, 2, 3 };
+        Input inputs[numOperators][numOperators];
+        int numInputs[numOperators] = {};
+    };
+
+    float level = 0.0f;
+    Oscillator* oscillators[numOperators] = {};
+    float modulationDepths[numOperators][numOperators] = {};
+    float depthScales[numOperators][numOperators] = { { 1, 1, 1, 1 }, { 1, 1, 1, 1 }, { 1, 1, 1, 1 }, { 1, 1, 1, 1 } };
+    float effectiveDepths[numOperators][numOperators] = {};
+    float levelOffsets[numOperators] = {};
+    float levelSteps[numOperators] = {};
+    bool connections[numOperators][numOperators] = {};
+    Program program;
+
+    float outputs[numOperators] = {};
+    float previousOutputs[numOperators] = {};
 
-    bool dfs(int v, std::vector<int>& visited);
-    std::vector<int> topologicalSort();
+    bool isValidIndex(int index);
+    bool dfs(int v, int* visited);
+    void compile();
 };
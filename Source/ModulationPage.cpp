@@ -0,0 +1,214 @@
+/*
+  ==============================================================================
+
+    ModulationPage.cpp
+    Created: 23 Oct 2026 12:02:37pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#include "ModulationPage.h"
+#include "RenderBenchmark.h"
+
+ModulationPage::ModulationPage(SynthFMAudioProcessor& p) : processor(p) {
+    setInterceptsMouseClicks(false, true);
+
+    for (int i = 0; i < ModulationSettings::numLfos; ++i) {
+        lfoLabels[i].setText("LFO " + juce::String(i + 1), juce::dontSendNotification);
+        addAndMakeVisible(lfoLabels[i]);
+
+        lfoShapeSelectors[i].addItemList({ "Sine", "Triangle", "Saw", "Square", "Sample & Hold" }, 1);
+        lfoShapeSelectors[i].onChange = [this, i] { updateLfo(i); };
+        addAndMakeVisible(lfoShapeSelectors[i]);
+
+        lfoRetriggerButtons[i].setButtonText("Retrigger");
+        lfoRetriggerButtons[i].onClick = [this, i] { updateLfo(i); };
+        addAndMakeVisible(lfoRetriggerButtons[i]);
+
+        lfoRateDials[i].setSliderStyle(juce::Slider::SliderStyle::RotaryVerticalDrag);
+        lfoRateDials[i].setRange(0.01, 20.0, 0.01);
+        lfoRateDials[i].setSkewFactorFromMidPoint(2.0);
+        lfoRateDials[i].setTextValueSuffix(" Hz");
+        lfoRateDials[i].setTextBoxStyle(juce::Slider::TextBoxBelow, false, 70, 20);
+        lfoRateDials[i].onValueChange = [this, i] { updateLfo(i); };
+        addAndMakeVisible(lfoRateDials[i]);
+    }
+
+    for (int rate : { 8, 16, 32 }) {
+        controlRateSelector.addItem("Control rate: " + juce::String(rate) + " samples", rate);
+    }
+    controlRateSelector.setSelectedId(processor.getControlRate(), juce::dontSendNotification);
+    controlRateSelector.onChange = [this] { processor.setControlRate(controlRateSelector.getSelectedId()); };
+    addAndMakeVisible(controlRateSelector);
+
+    mpeButton.setToggleState(processor.isMpeEnabled(), juce::dontSendNotification);
+    mpeButton.onClick = [this] { processor.setMpeEnabled(mpeButton.getToggleState()); };
+    addAndMakeVisible(mpeButton);
+
+    for (int threads : { 1, 2, 4, 8 }) {
+        renderThreadsSelector.addItem("Render: " + juce::String(threads) + (threads == 1 ? " thread" : " threads"), threads);
+    }
+    renderThreadsSelector.setSelectedId(processor.getRenderThreads(), juce::dontSendNotification);
+    renderThreadsSelector.onChange = [this] { processor.setRenderThreads(renderThreadsSelector.getSelectedId()); };
+    addAndMakeVisible(renderThreadsSelector);
+
+    benchmarkButton.onClick = [this] { runBenchmark(); };
+    addAndMakeVisible(benchmarkButton);
+
+    pipelinedFxButton.setToggleState(processor.isFxPipelined(), juce::dontSendNotification);
+    pipelinedFxButton.onClick = [this] { processor.setFxPipelined(pipelinedFxButton.getToggleState()); };
+    addAndMakeVisible(pipelinedFxButton);
+
+    noteCacheButton.setToggleState(processor.isNoteCacheEnabled(), juce::dontSendNotification);
+    noteCacheButton.onClick = [this] { processor.setNoteCacheEnabled(noteCacheButton.getToggleState()); };
+    addAndMakeVisible(noteCacheButton);
+
+    autoQualityButton.setToggleState(processor.isQualityGovernorEnabled(), juce::dontSendNotification);
+    autoQualityButton.onClick = [this] { processor.setQualityGovernorEnabled(autoQualityButton.getToggleState()); };
+    addAndMakeVisible(autoQualityButton);
+    addAndMakeVisible(qualityLabel);
+    timerCallback();
+    startTimerHz(4);
+
+    const char* stageNames[] = { "A", "D", "S", "R" };
+    for (int i = 0; i < ModulationSettings::numEnvelopes; ++i) {
+        envelopeLabels[i].setText("Env " + juce::String(i + 1), juce::dontSendNotification);
+        addAndMakeVisible(envelopeLabels[i]);
+        for (int stage = 0; stage < 4; ++stage) {
+            envelopeSliders[i][stage].setSliderStyle(juce::Slider::SliderStyle::LinearVertical);
+            envelopeSliders[i][stage].setRange(stage == 2 ? 0.0 : 0.001, stage == 2 ? 1.0 : 5.0);
+            envelopeSliders[i][stage].setTextBoxStyle(juce::Slider::NoTextBox, true, 0, 0);
+            envelopeSliders[i][stage].onValueChange = [this, i] { updateEnvelope(i); };
+            addAndMakeVisible(envelopeSliders[i][stage]);
+            envelopeStageLabels[i][stage].setText(stageNames[stage], juce::dontSendNotification);
+            envelopeStageLabels[i][stage].setJustificationType(juce::Justification::centred);
+            addAndMakeVisible(envelopeStageLabels[i][stage]);
+        }
+    }
+
+    for (int i = 0; i < numRows; ++i) {
+        routeSources[i].addItem("Off", 1);
+        for (int source = 0; source < ModulationEngine::numSources; ++source) {
+            routeSources[i].addItem(ModulationEngine::getSourceName(source), source + 2);
+        }
+        routeSources[i].onChange = [this, i] { updateRoute(i); };
+        addAndMakeVisible(routeSources[i]);
+
+        for (int destination = 0; destination < ModulationEngine::numDestinations; ++destination) {
+            routeDestinations[i].addItem(ModulationEngine::getDestinationName(destination), destination + 1);
+        }
+        routeDestinations[i].onChange = [this, i] { updateRoute(i); };
+        addAndMakeVisible(routeDestinations[i]);
+
+        routeAmounts[i].setSliderStyle(juce::Slider::LinearHorizontal);
+        routeAmounts[i].setRange(-1.0, 1.0, 0.001);
+        routeAmounts[i].setDoubleClickReturnValue(true, 0.0);
+        routeAmounts[i].setTextBoxStyle(juce::Slider::TextBoxRight, false, 50, 20);
+        routeAmounts[i].onValueChange = [this, i] { updateRoute(i); };
+        addAndMakeVisible(routeAmounts[i]);
+    }
+}
+
+void ModulationPage::updateLfo(int index) {
+    processor.setLfo(index, lfoShapeSelectors[index].getSelectedId() - 1, static_cast<float>(lfoRateDials[index].getValue()),
+        lfoRetriggerButtons[index].getToggleState());
+}
+
+void ModulationPage::updateEnvelope(int index) {
+    juce::Slider* sliders = envelopeSliders[index];
+    processor.setModulationEnvelope(index, static_cast<float>(sliders[0].getValue()), static_cast<float>(sliders[1].getValue()),
+        static_cast<float>(sliders[2].getValue()), static_cast<float>(sliders[3].getValue()));
+}
+
+void ModulationPage::updateRoute(int index) {
+    processor.setModulationRoute(index, routeSources[index].getSelectedId() - 2, routeDestinations[index].getSelectedId() - 1,
+        static_cast<float>(routeAmounts[index].getValue()));
+}
+
+void ModulationPage::refreshFromPatch(const ModulationSettings& settings) {
+    for (int i = 0; i < ModulationSettings::numLfos; ++i) {
+        lfoShapeSelectors[i].setSelectedId(juce::roundToInt(settings.lfos[i].shape) + 1, juce::dontSendNotification);
+        lfoRetriggerButtons[i].setToggleState(settings.lfos[i].retrigger > 0.5f, juce::dontSendNotification);
+        lfoRateDials[i].setValue(settings.lfos[i].rate, juce::dontSendNotification);
+    }
+    for (int i = 0; i < ModulationSettings::numEnvelopes; ++i) {
+        const EnvelopeSettings& envelope = settings.envelopes[i];
+        envelopeSliders[i][0].setValue(envelope.attack, juce::dontSendNotification);
+        envelopeSliders[i][1].setValue(envelope.decay, juce::dontSendNotification);
+        envelopeSliders[i][2].setValue(envelope.sustain, juce::dontSendNotification);
+        envelopeSliders[i][3].setValue(envelope.release, juce::dontSendNotification);
+    }
+    for (int i = 0; i < numRows; ++i) {
+        const ModulationRoute& route = settings.routes[i];
+        routeSources[i].setSelectedId(route.source >= 0 ? route.source + 2 : 1, juce::dontSendNotification);
+        routeDestinations[i].setSelectedId(route.destination + 1, juce::dontSendNotification);
+        routeAmounts[i].setValue(route.amount, juce::dontSendNotification);
+    }
+}
+
+ModulationPage::~ModulationPage() {
+    stopTimer();
+}
+
+void ModulationPage::timerCallback() {
+    // Какой уровень качества сейчас держит процессор и почему
+    qualityLabel.setText("Quality: " + QualityGovernor::getTierName(processor.getQualityTier())
+        + ", load " + juce::String(juce::roundToInt(processor.getCpuLoad() * 100.0f)) + "%", juce::dontSendNotification);
+}
+
+void ModulationPage::resized()
+{
+    for (int i = 0; i < ModulationSettings::numLfos; ++i) {
+        int x = 20 + i * 240;
+        lfoLabels[i].setBounds(x, 50, 200, 20);
+        lfoShapeSelectors[i].setBounds(x, 75, 120, 24);
+        lfoRetriggerButtons[i].setBounds(x + 130, 75, 100, 24);
+        lfoRateDials[i].setBounds(x, 105, 100, 100);
+    }
+    controlRateSelector.setBounds(20, 212, 170, 24);
+    mpeButton.setBounds(195, 212, 60, 24);
+    renderThreadsSelector.setBounds(260, 212, 130, 24);
+    benchmarkButton.setBounds(395, 212, 100, 24);
+    pipelinedFxButton.setBounds(380, 182, 115, 24);
+    noteCacheButton.setBounds(380, 152, 115, 24);
+
+    for (int i = 0; i < ModulationSettings::numEnvelopes; ++i) {
+        int x = 520 + i * 240;
+        envelopeLabels[i].setBounds(x, 50, 200, 20);
+        for (int stage = 0; stage < 4; ++stage) {
+            envelopeSliders[i][stage].setBounds(x + stage * 55, 75, 30, 130);
+            envelopeStageLabels[i][stage].setBounds(x + stage * 55 - 5, 205, 40, 20);
+        }
+    }
+
+    // Маршруты в две колонки по восемь строк
+    int rowsPerColumn = numRows / 2;
+    for (int i = 0; i < numRows; ++i) {
+        int x = 20 + (i / rowsPerColumn) * 490;
+        int y = 250 + (i % rowsPerColumn) * 28;
+        routeSources[i].setBounds(x, y, 110, 24);
+        routeDestinations[i].setBounds(x + 115, y, 150, 24);
+        routeAmounts[i].setBounds(x + 270, y, 200, 24);
+    }
+    autoQualityButton.setBounds(20, 474, 115, 24);
+    qualityLabel.setBounds(140, 474, 355, 24);
+}
+
+void ModulationPage::runBenchmark() {
+    // Замер идёт на отдельном экземпляре синтезатора, текущий звук не трогаем
+    benchmarkButton.setEnabled(false);
+    benchmarkButton.setButtonText("Running...");
+    juce::Component::SafePointer<ModulationPage> safeThis(this);
+    juce::Thread::launch([safeThis] {
+        auto report = RenderBenchmark::format(RenderBenchmark::run());
+        juce::MessageManager::callAsync([safeThis, report] {
+            if (safeThis == nullptr) {
+                return;
+            }
+            safeThis->benchmarkButton.setEnabled(true);
+            safeThis->benchmarkButton.setButtonText("Benchmark");
+            juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::InfoIcon, "Render benchmark", report);
+        });
+    });
+}
@@ -0,0 +1,57 @@
+/*
+  ==============================================================================
+
+    ModulationPage.h
+    Created: 23 Oct 2026 12:02:37pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+// LFO, огибающие модуляции и таблица маршрутов
+class ModulationPage : public juce::Component, private juce::Timer {
+public:
+    static constexpr int numRows = ModulationSettings::maxRoutes;
+
+    ModulationPage(SynthFMAudioProcessor& processor);
+    ~ModulationPage() override;
+
+    void resized() override;
+    void refreshFromPatch(const ModulationSettings& settings);
+
+private:
+    SynthFMAudioProcessor& processor;
+
+    juce::Label lfoLabels[ModulationSettings::numLfos];
+    juce::ComboBox lfoShapeSelectors[ModulationSettings::numLfos];
+    juce::ToggleButton lfoRetriggerButtons[ModulationSettings::numLfos];
+    juce::Slider lfoRateDials[ModulationSettings::numLfos];
+    juce::ComboBox controlRateSelector;
+    juce::ToggleButton mpeButton{ "MPE" };
+    juce::ComboBox renderThreadsSelector;
+    juce::TextButton benchmarkButton{ "Benchmark" };
+    juce::ToggleButton pipelinedFxButton{ "Pipelined FX" };
+    juce::ToggleButton noteCacheButton{ "Note cache" };
+    juce::ToggleButton autoQualityButton{ "Auto quality" };
+    juce::Label qualityLabel;
+
+    juce::Label envelopeLabels[ModulationSettings::numEnvelopes];
+    juce::Slider envelopeSliders[ModulationSettings::numEnvelopes][4];
+    juce::Label envelopeStageLabels[ModulationSettings::numEnvelopes][4];
+
+    juce::ComboBox routeSources[numRows];
+    juce::ComboBox routeDestinations[numRows];
+    juce::Slider routeAmounts[numRows];
+
+    void updateLfo(int index);
+    void updateEnvelope(int index);
+    void updateRoute(int index);
+    void runBenchmark();
+    void timerCallback() override;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ModulationPage)
+};
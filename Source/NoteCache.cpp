@@ -0,0 +1,229 @@
+/*
+  ==============================================================================
+
+    NoteCache.cpp
+    Created: 26 Oct 2026 6:41:09pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#include "NoteCache.h"
+#include <algorithm>
+#include <cstring>
+
+bool NoteCache::Key::operator==(const Key& other) const {
+    return patchHash == other.patchHash && note == other.note && velocity == other.velocity && sampleRate == other.sampleRate;
+}
+
+size_t NoteCache::KeyHash::operator()(const Key& key) const {
+    std::uint64_t hash = key.patchHash;
+    hash ^= (static_cast<std::uint64_t>(key.note) << 40) ^ (static_cast<std::uint64_t>(key.velocity) << 32)
+        ^ static_cast<std::uint64_t>(key.sampleRate);
+    return static_cast<size_t>(hash * 0x9e3779b97f4a7c15ull);
+}
+
+size_t NoteCache::Entry::getBytes() const {
+    return sizeof(Entry) + (samples.capacity() + envelopes.capacity()) * sizeof(float)
+        + checkpoints.capacity() * sizeof(Voice::Snapshot);
+}
+
+bool NoteCache::Track::isBusy() const {
+    return replay != nullptr || (recording != nullptr && !finished);
+}
+
+NoteCache::NoteCache(size_t maxBytes)
+    : maxBytes(maxBytes) {}
+
+void NoteCache::prepare(double sampleRate) {
+    // Снимки держат указатели на таблицы арены, после её перестройки они недействительны
+    clear();
+    maxLength = juce::roundToInt(sampleRate * maxLengthSeconds);
+}
+
+void NoteCache::clear() {
+    index.clear();
+    entries.clear();
+    bytesUsed = 0;
+}
+
+void NoteCache::setMaxBytes(size_t newMaxBytes) {
+    maxBytes = newMaxBytes;
+    evict();
+}
+
+size_t NoteCache::getBytesUsed() {
+    return bytesUsed;
+}
+
+int NoteCache::getNumEntries() {
+    return static_cast<int>(entries.size());
+}
+
+std::uint64_t NoteCache::hashParameters(const PatchParameters& parameters) {
+    // FNV-1a по байтам параметров: патч - плоская структура из float
+    unsigned char bytes[sizeof(PatchParameters)];
+    std::memcpy(bytes, &parameters, sizeof(PatchParameters));
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    for (unsigned char byte : bytes) {
+        hash = (hash ^ byte) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+NoteCache::Key NoteCache::makeKey(std::uint64_t patchHash, int note, float velocity, double sampleRate) {
+    Key key;
+    key.patchHash = patchHash;
+    key.note = note;
+    key.velocity = juce::roundToInt(velocity * 127.0f);
+    key.sampleRate = juce::roundToInt(sampleRate);
+    return key;
+}
+
+void NoteCache::begin(Track& track, Voice& voice, const Key& key) {
+    track.replay.reset();
+    track.recording.reset();
+    track.position = 0;
+    track.finished = false;
+
+    auto found = index.find(key);
+    if (found != index.end()) {
+        entries.splice(entries.begin(), entries, found->second);
+        track.replay = *found->second;
+        return;
+    }
+
+    track.recording = std::make_unique<Entry>();
+    track.recording->key = key;
+    track.recording->checkpoints.emplace_back();
+    voice.saveSnapshot(track.recording->checkpoints.back());
+}
+
+void NoteCache::render(Track& track, Voice& voice, float* samples, float* envelopes, int stride, int startSample, int numSamples) {
+    // Событие выразительности делает ноту непредсказуемой ещё до того, как применится
+    if (track.isBusy() && voice.getExpression().getNextSample() >= 0) {
+        goLive(track, voice);
+    }
+
+    int i = 0;
+    if (track.replay != nullptr) {
+        const Entry& entry = *track.replay;
+        int count = std::min(numSamples, entry.length - track.position);
+        for (; i < count; ++i) {
+            samples[i * stride] = entry.samples[track.position + i];
+            envelopes[i * stride] = entry.envelopes[track.position + i];
+        }
+        track.position += count;
+        if (track.position >= entry.length) {
+            voice.restoreSnapshot(entry.finalState);
+            track.replay.reset();
+        }
+    }
+    else if (track.recording != nullptr && !track.finished) {
+        // Кусками до следующего снимка, чтобы снимки легли ровно по сетке
+        Entry& entry = *track.recording;
+        while (i < numSamples && !track.finished) {
+            if (static_cast<int>(entry.checkpoints.size()) * checkpointInterval == track.position) {
+                entry.checkpoints.emplace_back();
+                voice.saveSnapshot(entry.checkpoints.back());
+            }
+            int count = std::min({ numSamples - i, checkpointInterval - track.position % checkpointInterval, maxLength - track.position });
+            voice.render(samples + i * stride, envelopes + i * stride, stride, startSample + i, count);
+            for (int j = i; j < i + count; ++j) {
+                entry.samples.push_back(samples[j * stride]);
+                entry.envelopes.push_back(envelopes[j * stride]);
+            }
+            i += count;
+            track.position += count;
+            if (voice.isSettled() || track.position >= maxLength) {
+                finishRecording(track, voice);
+            }
+        }
+    }
+
+    if (i < numSamples) {
+        voice.render(samples + i * stride, envelopes + i * stride, stride, startSample + i, numSamples - i);
+    }
+}
+
+bool NoteCache::goLive(Track& track, Voice& voice, bool keepRecording) {
+    bool restored = false;
+    if (track.replay != nullptr) {
+        // Ближайший снимок не позже позиции, остаток досчитываем без вывода
+        const Entry& entry = *track.replay;
+        if (track.position >= entry.length) {
+            voice.restoreSnapshot(entry.finalState);
+        }
+        else {
+            int checkpoint = track.position / checkpointInterval;
+            voice.restoreSnapshot(entry.checkpoints[checkpoint]);
+            voice.advance(track.position - checkpoint * checkpointInterval);
+        }
+        track.replay.reset();
+        restored = true;
+    }
+    if (track.recording != nullptr && !track.finished) {
+        if (keepRecording) {
+            finishRecording(track, voice);
+        }
+        else {
+            track.recording.reset();
+        }
+    }
+    return restored;
+}
+
+void NoteCache::retire(Track& track, Voice& voice) {
+    if (track.recording != nullptr && !track.finished) {
+        finishRecording(track, voice);
+    }
+    commit(track);
+    track.replay.reset();
+    track.position = 0;
+}
+
+void NoteCache::commit(Track& track) {
+    if (track.recording == nullptr || !track.finished) {
+        return;
+    }
+    std::unique_ptr<Entry> entry = std::move(track.recording);
+    track.finished = false;
+    if (entry->length < minLength) {
+        return;
+    }
+
+    // Та же нота могла записаться другим голосом; оставляем более длинную запись
+    auto found = index.find(entry->key);
+    if (found != index.end()) {
+        if ((*found->second)->length >= entry->length) {
+            return;
+        }
+        bytesUsed -= (*found->second)->getBytes();
+        entries.erase(found->second);
+        index.erase(found);
+    }
+
+    entry->samples.shrink_to_fit();
+    entry->envelopes.shrink_to_fit();
+    entry->checkpoints.shrink_to_fit();
+    bytesUsed += entry->getBytes();
+    Key key = entry->key;
+    entries.push_front(std::shared_ptr<const Entry>(std::move(entry)));
+    index[key] = entries.begin();
+    evict();
+}
+
+void NoteCache::finishRecording(Track& track, Voice& voice) {
+    voice.saveSnapshot(track.recording->finalState);
+    track.recording->length = track.position;
+    track.finished = true;
+}
+
+void NoteCache::evict() {
+    // Проигрываемые сейчас записи держит shared_ptr дорожки, так что удалять можно любую
+    while (bytesUsed > maxBytes && !entries.empty()) {
+        bytesUsed -= entries.back()->getBytes();
+        index.erase(entries.back()->key);
+        entries.pop_back();
+    }
+}
@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    NoteCache.h
+    Created: 26 Oct 2026 6:41:09pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "Voice.h"
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Кэш начала нот для офлайн-рендера. Пока голос ничем не модулируется, его выход зависит
+// только от патча, ноты и частоты дискретизации: первая такая нота записывается вместе
+// со снимками голоса до выхода огибающих на sustain, повторные проигрываются из памяти.
+// Как только голос перестаёт быть предсказуемым (отпускание, выразительность, правка
+// патча, модуляция голоса), он восстанавливается из ближайшего снимка и считается вживую.
+// Записи выделяются на потоке рендера, поэтому кэш включается только в офлайне.
+class NoteCache {
+public:
+    static constexpr int checkpointInterval = 1024;
+    static constexpr int minLength = 256;         // короче не сохраняем - не окупится
+    static constexpr float maxLengthSeconds = 4.0f;
+
+    struct Key {
+        std::uint64_t patchHash = 0;
+        int note = 0;
+        int velocity = 0;
+        int sampleRate = 0;
+
+        bool operator==(const Key& other) const;
+    };
+
+    // Сэмплы и огибающая фильтра от начала ноты; checkpoints[k] - голос на сэмпле
+    // k * checkpointInterval, finalState - на сэмпле length
+    struct Entry {
+        Key key;
+        std::vector<float> samples;
+        std::vector<float> envelopes;
+        std::vector<Voice::Snapshot> checkpoints;
+        Voice::Snapshot finalState;
+        int length = 0;
+
+        size_t getBytes() const;
+    };
+
+    // Запись или проигрывание ноты одного голоса. Трогается только потоком, который
+    // рендерит этот голос, и аудиопотоком между рендерами.
+    struct Track {
+        std::shared_ptr<const Entry> replay;
+        std::unique_ptr<Entry> recording;
+        int position = 0;
+        bool finished = false;     // запись окончена и ждёт commit
+
+        bool isBusy() const;
+    };
+
+    explicit NoteCache(size_t maxBytes = 64 * 1024 * 1024);
+
+    void prepare(double sampleRate);
+    void clear();
+    void setMaxBytes(size_t newMaxBytes);
+    size_t getBytesUsed();
+    int getNumEntries();
+
+    static std::uint64_t hashParameters(const PatchParameters& parameters);
+    static Key makeKey(std::uint64_t patchHash, int note, float velocity, double sampleRate);
+
+    // Голос только что запущен: проигрываем готовую запись или начинаем новую
+    void begin(Track& track, Voice& voice, const Key& key);
+    // Заменяет voice.render для голоса с дорожкой кэша
+    void render(Track& track, Voice& voice, float* samples, float* envelopes, int stride, int startSample, int numSamples);
+    // Переводит голос на живой рендер с текущей позиции. Возвращает true, если состояние
+    // голоса восстановлено из снимка (его параметры тогда взяты из записи).
+    // keepRecording = false выбрасывает недописанную запись - нужно при смене патча.
+    bool goLive(Track& track, Voice& voice, bool keepRecording = true);
+    // Голос отдают другой ноте: записанное сдаётся в кэш, проигрывание бросается
+    void retire(Track& track, Voice& voice);
+    // Переносит законченную запись в кэш; только на аудиопотоке
+    void commit(Track& track);
+
+private:
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+    using EntryList = std::list<std::shared_ptr<const Entry>>;
+
+    EntryList entries;    // в начале - недавно использованные
+    std::unordered_map<Key, EntryList::iterator, KeyHash> index;
+    size_t maxBytes;
+    size_t bytesUsed = 0;
+    int maxLength = 0;
+
+    void finishRecording(Track& track, Voice& voice);
+    void evict();
+};
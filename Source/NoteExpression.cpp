@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    NoteExpression.cpp
+    Created: 23 Oct 2026 3:41:18pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#include "NoteExpression.h"
+#include <limits>
+
+NoteExpression::NoteExpression()
+    : numEvents(0), nextEvent(0), current{}, overflow{}, overflowed{} {
+}
+
+void NoteExpression::reset(float noteBend, float globalBend, float pressure, float timbre) {
+    numEvents = 0;
+    nextEvent = 0;
+    current[NoteBend] = noteBend;
+    current[GlobalBend] = globalBend;
+    current[Pressure] = pressure;
+    current[Timbre] = timbre;
+    for (bool& flag : overflowed) {
+        flag = false;
+    }
+}
+
+void NoteExpression::push(int sample, Type type, float value) {
+    // Контроллер часто шлёт несколько значений в один сэмпл - нужно только последнее
+    if (numEvents > nextEvent && events[numEvents - 1].sample == sample && events[numEvents - 1].type == type) {
+        events[numEvents - 1].value = value;
+        return;
+    }
+    if (numEvents == capacity) {
+        overflow[type] = value;
+        overflowed[type] = true;
+        return;
+    }
+    events[numEvents++] = { sample, type, value };
+}
+
+int NoteExpression::getNextSample() {
+    return nextEvent < numEvents ? events[nextEvent].sample : -1;
+}
+
+bool NoteExpression::apply(int sample) {
+    bool bendChanged = false;
+    while (nextEvent < numEvents && events[nextEvent].sample <= sample) {
+        bendChanged |= set(events[nextEvent].type, events[nextEvent].value);
+        ++nextEvent;
+    }
+    return bendChanged;
+}
+
+bool NoteExpression::flush() {
+    bool bendChanged = apply(std::numeric_limits<int>::max());
+    for (int type = 0; type < numTypes; ++type) {
+        if (overflowed[type]) {
+            bendChanged |= set(type, overflow[type]);
+            overflowed[type] = false;
+        }
+    }
+    numEvents = 0;
+    nextEvent = 0;
+    return bendChanged;
+}
+
+bool NoteExpression::set(int type, float value) {
+    bool changed = current[type] != value;
+    current[type] = value;
+    return changed && (type == NoteBend || type == GlobalBend);
+}
+
+float NoteExpression::getPitchBend() {
+    return current[NoteBend] + current[GlobalBend];
+}
+
+float NoteExpression::getPressure() {
+    return current[Pressure];
+}
+
+float NoteExpression::getTimbre() {
+    return current[Timbre];
+}
@@ -0,0 +1,60 @@
+/*
+  ==============================================================================
+
+    NoteExpression.h
+    Created: 23 Oct 2026 3:41:18pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// Выразительность одной ноты (MPE): изгиб высоты, давление и тембр. События блока
+// складываются в массив своего голоса с позицией сэмпла и разбираются при рендере по порядку.
+// Массив фиксированный: при переполнении остаются только последние значения, они применяются в flush.
+class NoteExpression {
+public:
+    enum Type {
+        NoteBend,       // полутоны, свой для ноты
+        GlobalBend,     // полутоны, общий для всех нот партии
+        Pressure,
+        Timbre,
+        numTypes
+    };
+
+    static constexpr int capacity = 128;
+
+    NoteExpression();
+
+    void reset(float noteBend, float globalBend, float pressure, float timbre);
+    void push(int sample, Type type, float value);
+
+    // Позиция следующего события или -1, если событий больше нет
+    int getNextSample();
+    // Применяет события с позицией не больше sample; true, если изменился изгиб
+    bool apply(int sample);
+    // Применяет всё оставшееся и очищает массив перед следующим блоком
+    bool flush();
+
+    float getPitchBend();
+    float getPressure();
+    float getTimbre();
+
+private:
+    struct Event {
+        int sample;
+        int type;
+        float value;
+    };
+
+    Event events[capacity];
+    int numEvents;
+    int nextEvent;
+    float current[numTypes];
+    float overflow[numTypes];
+    bool overflowed[numTypes];
+
+    bool set(int type, float value);
+};
@@ -11,14 +11,17 @@
 #include "Oscillator.h" 
 
 Oscillator::Oscillator()
-    : type(Sine), frequency(0.0), phase(0.0), sampleRate(48000.0), phaseIncrement(0.0), level(0.0) {
-    updatePhaseIncrement();
+    : type(Sine), pitch(0.0), frequency(0.0), phase(0.0), phaseIncrement(0.0), modulationScale(0.0), level(0.0) {
 }
 
 void Oscillator::setWaveType(WaveType newType) {
     type = newType;
 }
 
+void Oscillator::setDraft(bool isDraft) {
+    draft = isDraft;
+}
+
 Oscillator::WaveType Oscillator::getWaveType() {
     return type;
 }
@@ -27,18 +30,24 @@ float Oscillator::getFrequency() {
     return frequency;
 }
 
-void Oscillator::setFrequency(float newFrequency) {
-    frequency = newFrequency;
+void Oscillator::setPitch(float newPitch) {
+    pitch = newPitch;
+    frequency = pitchTable->getFrequency(pitchTable->getIncrement(pitch));
     updatePhaseIncrement();
 }
 
-void Oscillator::setSampleRate(float newSampleRate) {
-    sampleRate = newSampleRate;
-    updatePhaseIncrement();
+void Oscillator::setTables(const SharedTables* newTables, const PitchTable* newPitchTable) {
+    tables = newTables;
+    pitchTable = newPitchTable;
 }
 
+// Вызывается только при смене высоты; FM на каждом сэмпле идёт через modulationScale без деления
 void Oscillator::updatePhaseIncrement() {
-    phaseIncrement = frequency * frequencyMultiplier * detuneFactor * juce::MathConstants<float>::twoPi / sampleRate;
+    if (pitchTable == nullptr) {
+        return;
+    }
+    phaseIncrement = pitchTable->getIncrement(pitch + octaveOffset + detuneOffset + pitchModulation + pitchBend);
+    modulationScale = frequency > 0.0f ? phaseIncrement / frequency : 0.0f;
 }
 
 void Oscillator::setLevel(float newLevel) {
@@ -49,17 +58,17 @@ float Oscillator::getLevel() {
     return level;
 }
 
-float Oscillator::nextSample() {
+float Oscillator::nextSample(float frequencyOffset) {
     float sample = 0.0;
     switch (type) {
     case Sine:
-        sample = std::sin(phase);
+        sample = draft ? tables->sineDraft(phase) : tables->sine(phase);
         break;
     case Square:
-        sample = (std::sin(phase) >= 0.0) ? 1.0 : -1.0;
+        sample = (tables->sine(phase) >= 0.0) ? 1.0 : -1.0;
         break;
     case Triangle:
-        sample = 2.0 * std::asin(std::sin(phase)) / juce::MathConstants<float>::pi;
+        sample = draft ? tables->triangleDraft(phase) : tables->triangle(phase);
         break;
     case Saw:
         sample = 2.0 * (phase / juce::MathConstants<float>::twoPi) - 1.0;
@@ -68,9 +77,11 @@ float Oscillator::nextSample() {
     float filteredSample = sample - lastSample + 0.995 * lastSample;
     lastSample = filteredSample;
 
-    phase += phaseIncrement;
+    phase += phaseIncrement + frequencyOffset * modulationScale;
     if (phase >= juce::MathConstants<float>::twoPi)
         phase -= juce::MathConstants<float>::twoPi;
+    else if (phase < 0.0f)
+        phase += juce::MathConstants<float>::twoPi;
 
     return adsr.applyEnvelope(filteredSample);
 }
@@ -78,15 +89,31 @@ float Oscillator::nextSample() {
 void Oscillator::reset() {
     phase = 0.0;
     phaseIncrement = 0.0;
+    pitchModulation = 0.0f;
+    pitchBend = 0.0f;
+    lastSample = 0.0f;
     adsr.reset();
 }
 
 void Oscillator::setOctave(int octave) {
-    frequencyMultiplier = std::pow(2.0, octave);
+    octaveOffset = 12.0f * octave;
+    updatePhaseIncrement();
 }
 
 void Oscillator::setDetune(float cents) {
-    detuneFactor = std::pow(2.0, cents / 1200.0);
+    detuneOffset = cents / 100.0f;
+    updatePhaseIncrement();
+}
+
+// Модуляция высоты в полутонах, меняется с контрольной частотой
+void Oscillator::setPitchModulation(float semitones) {
+    pitchModulation = semitones;
+    updatePhaseIncrement();
+}
+
+void Oscillator::setPitchBend(float semitones) {
+    pitchBend = semitones;
+    updatePhaseIncrement();
 }
 
 void Oscillator::noteOn() {
@@ -97,6 +124,14 @@ void Oscillator::noteOff() {
     adsr.noteOff();
 }
 
+bool Oscillator::isActive() {
+    return adsr.isActive();
+}
+
+ADSR::State Oscillator::getEnvelopeState() {
+    return adsr.getState();
+}
+
 void Oscillator::setAttackTime(float time) {
     adsr.setAttackTime(time);
 }
@@ -12,6 +12,8 @@
 
 #include <JuceHeader.h>
 #include "ADSR.h"
+#include "SharedTables.h"
+#include "PitchTable.h"
 
 class Oscillator {
 public:
@@ -24,36 +26,52 @@ public:
 
 private:
     WaveType type;
+    float pitch;
     float frequency;
     float phase;
-    float sampleRate;
     float phaseIncrement;
+    float modulationScale;
     float lastSample = 0;
     float level;
+    bool draft = false;
 
-    double frequencyMultiplier = 1.0;
-    double detuneFactor = 1.0;
+    // Сдвиги высоты в полутонах, складываются с высотой ноты перед поиском в таблице
+    float octaveOffset = 0.0f;
+    float detuneOffset = 0.0f;
+    float pitchModulation = 0.0f;
+    float pitchBend = 0.0f;
 
     ADSR adsr;
+    const SharedTables* tables = nullptr;
+    const PitchTable* pitchTable = nullptr;
 
 public:
     Oscillator();
 
     void setWaveType(WaveType newType);
+    // Таблицы без интерполяции - ступень качества под нагрузкой
+    void setDraft(bool isDraft);
     WaveType getWaveType();
-    void setFrequency(float newFrequency);
+    // Высота ноты в полутонах (номер MIDI-ноты), частота берётся из таблицы
+    void setPitch(float newPitch);
     float getFrequency();
-    void setSampleRate(float newSampleRate);
+    // Таблицы форм волны и высот; без них осциллятор звучать не может
+    void setTables(const SharedTables* newTables, const PitchTable* newPitchTable);
     void updatePhaseIncrement();
-    float nextSample();
+    // frequencyOffset - частотная модуляция в герцах на этот сэмпл
+    float nextSample(float frequencyOffset = 0.0f);
     void reset();
     void setLevel(float newLevel);
     float getLevel();
     void setOctave(int octave);
     void setDetune(float cents);
+    void setPitchModulation(float semitones);
+    void setPitchBend(float semitones);
 
     void noteOn();
     void noteOff();
+    bool isActive();
+    ADSR::State getEnvelopeState();
     void setAttackTime(float time);
     void setDecayTime(float time);
     void setSustainLevel(float level);
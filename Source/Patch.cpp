@@ -0,0 +1,188 @@
+/*
+  ==============================================================================
+
+    Patch.cpp
+    Created: 20 Oct 2026 1:07:45pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#include "Patch.h"
+#include "ModulationEngine.h"
+#include "Oscillator.h"
+#include "VoiceFilter.h"
+#include <cstring>
+
+Patch Patch::getDefault() {
+    Patch patch;
+    std::memset(&patch, 0, sizeof(Patch));
+
+    for (auto& op : patch.parameters.operators) {
+        op.attack = 0.02f;
+        op.decay = 0.02f;
+        op.sustain = 0.7f;
+        op.release = 0.02f;
+    }
+    patch.parameters.filterCutoff = 20000.0f;
+    patch.parameters.filterAttack = 0.02f;
+    patch.parameters.filterDecay = 0.02f;
+    patch.parameters.filterSustain = 0.7f;
+    patch.parameters.filterRelease = 0.02f;
+
+    for (auto& lfo : patch.modulation.lfos) {
+        lfo.rate = 5.0f;
+    }
+    for (auto& envelope : patch.modulation.envelopes) {
+        envelope.attack = 0.01f;
+        envelope.decay = 0.3f;
+        envelope.release = 0.3f;
+    }
+    for (auto& route : patch.modulation.routes) {
+        route.source = -1;
+    }
+    return patch;
+}
+
+void Patch::writeTo(juce::MemoryBlock& destData) const {
+    Header header{ magic, version, static_cast<std::uint32_t>(sizeof(Patch)), 0 };
+    destData.setSize(sizeof(Header) + sizeof(Patch));
+    auto* bytes = static_cast<char*>(destData.getData());
+    std::memcpy(bytes, &header, sizeof(Header));
+    std::memcpy(bytes + sizeof(Header), this, sizeof(Patch));
+}
+
+bool Patch::readFrom(const void* data, int sizeInBytes, int* bytesRead) {
+    if (data == nullptr || sizeInBytes < static_cast<int>(sizeof(Header))) {
+        return false;
+    }
+    Header header;
+    std::memcpy(&header, data, sizeof(Header));
+    if (header.magic != magic || header.version > version
+        || header.size > static_cast<std::uint32_t>(sizeInBytes) - sizeof(Header)) {
+        return false;
+    }
+
+    readPayload(static_cast<const char*>(data) + sizeof(Header), header.size);
+    if (bytesRead != nullptr) {
+        *bytesRead = static_cast<int>(sizeof(Header) + header.size);
+    }
+    return true;
+}
+
+void Patch::readPayload(const void* data, size_t sizeInBytes) {
+    *this = getDefault();
+    std::memcpy(this, data, std::min(sizeInBytes, sizeof(Patch)));
+    sanitize();
+}
+
+void Patch::sanitize() {
+    const Patch defaults = getDefault();
+    float* values = parameters.data();
+    for (int i = 0; i < PatchParameters::size(); ++i) {
+        if (!std::isfinite(values[i])) {
+            values[i] = defaults.parameters.data()[i];
+        }
+    }
+    for (auto& op : parameters.operators) {
+        op.waveType = static_cast<float>(juce::jlimit(0, static_cast<int>(Oscillator::Saw), juce::roundToInt(op.waveType)));
+    }
+    parameters.filterMode = static_cast<float>(juce::jlimit(0, static_cast<int>(VoiceFilterBank::Notch), juce::roundToInt(parameters.filterMode)));
+
+    numEffects = juce::jlimit(0, static_cast<int>(maxEffects), static_cast<int>(numEffects));
+    for (int i = 0; i < maxEffects; ++i) {
+        effects[i].name[EffectSlot::maxNameLength - 1] = '\0';
+        for (int p = 0; p < 2; ++p) {
+            if (!std::isfinite(effects[i].parameters[p])) {
+                effects[i].parameters[p] = defaults.effects[i].parameters[p];
+            }
+        }
+    }
+
+    for (int i = 0; i < ModulationSettings::numLfos; ++i) {
+        LfoSettings& lfo = modulation.lfos[i];
+        lfo.shape = std::isfinite(lfo.shape) ? lfo.shape : defaults.modulation.lfos[i].shape;
+        lfo.shape = static_cast<float>(juce::jlimit(0, static_cast<int>(ModulationEngine::SampleAndHold), juce::roundToInt(lfo.shape)));
+        lfo.rate = std::isfinite(lfo.rate) ? lfo.rate : defaults.modulation.lfos[i].rate;
+        lfo.retrigger = std::isfinite(lfo.retrigger) ? lfo.retrigger : defaults.modulation.lfos[i].retrigger;
+    }
+    for (int i = 0; i < ModulationSettings::numEnvelopes; ++i) {
+        float* stages = &modulation.envelopes[i].attack;
+        const float* defaultStages = &defaults.modulation.envelopes[i].attack;
+        for (int stage = 0; stage < 4; ++stage) {
+            stages[stage] = std::isfinite(stages[stage]) ? stages[stage] : defaultStages[stage];
+        }
+    }
+    for (auto& route : modulation.routes) {
+        route.amount = std::isfinite(route.amount) ? route.amount : 0.0f;
+    }
+}
+
+std::unique_ptr<juce::XmlElement> Patch::createXml() const {
+    static const char* const operatorFields[] = { "waveType", "level", "octave", "detune", "attack", "decay", "sustain", "release" };
+
+    auto xml = std::make_unique<juce::XmlElement>("SynthFMPatch");
+    xml->setAttribute("version", static_cast<int>(version));
+    xml->setAttribute("level", parameters.level);
+
+    for (int i = 0; i < PatchParameters::numOperators; ++i) {
+        auto* op = xml->createNewChildElement("Operator");
+        op->setAttribute("index", i);
+        const float* values = &parameters.operators[i].waveType;
+        for (int field = 0; field < 8; ++field) {
+            op->setAttribute(operatorFields[field], values[field]);
+        }
+        for (int carrier = 0; carrier < PatchParameters::numOperators; ++carrier) {
+            if (parameters.modulationEnabled[i][carrier] > 0.5f) {
+                auto* modulation = op->createNewChildElement("Modulates");
+                modulation->setAttribute("carrier", carrier);
+                modulation->setAttribute("depth", parameters.modulationDepths[i][carrier]);
+            }
+        }
+    }
+
+    auto* filter = xml->createNewChildElement("Filter");
+    filter->setAttribute("mode", parameters.filterMode);
+    filter->setAttribute("cutoff", parameters.filterCutoff);
+    filter->setAttribute("resonance", parameters.filterResonance);
+    filter->setAttribute("envelopeAmount", parameters.filterEnvelopeAmount);
+    filter->setAttribute("attack", parameters.filterAttack);
+    filter->setAttribute("decay", parameters.filterDecay);
+    filter->setAttribute("sustain", parameters.filterSustain);
+    filter->setAttribute("release", parameters.filterRelease);
+
+    auto* chain = xml->createNewChildElement("Effects");
+    for (int i = 0; i < numEffects; ++i) {
+        auto* effect = chain->createNewChildElement("Effect");
+        effect->setAttribute("name", juce::String(effects[i].name));
+        effect->setAttribute("active", effects[i].isActive);
+        effect->setAttribute("param1", effects[i].parameters[0]);
+        effect->setAttribute("param2", effects[i].parameters[1]);
+    }
+
+    auto* modulationXml = xml->createNewChildElement("Modulation");
+    for (int i = 0; i < ModulationSettings::numLfos; ++i) {
+        auto* lfo = modulationXml->createNewChildElement("LFO");
+        lfo->setAttribute("index", i);
+        lfo->setAttribute("shape", modulation.lfos[i].shape);
+        lfo->setAttribute("rate", modulation.lfos[i].rate);
+        lfo->setAttribute("retrigger", modulation.lfos[i].retrigger);
+    }
+    for (int i = 0; i < ModulationSettings::numEnvelopes; ++i) {
+        auto* envelope = modulationXml->createNewChildElement("Envelope");
+        envelope->setAttribute("index", i);
+        envelope->setAttribute("attack", modulation.envelopes[i].attack);
+        envelope->setAttribute("decay", modulation.envelopes[i].decay);
+        envelope->setAttribute("sustain", modulation.envelopes[i].sustain);
+        envelope->setAttribute("release", modulation.envelopes[i].release);
+    }
+    for (const auto& route : modulation.routes) {
+        if (route.source >= 0 && route.amount != 0.0f) {
+            auto* routeXml = modulationXml->createNewChildElement("Route");
+            routeXml->setAttribute("source", static_cast<int>(route.source));
+            routeXml->setAttribute("destination", static_cast<int>(route.destination));
+            routeXml->setAttribute("amount", route.amount);
+        }
+    }
+    return xml;
+}
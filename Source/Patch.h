@@ -0,0 +1,123 @@
+/*
+  ==============================================================================
+
+    Patch.h
+    Created: 20 Oct 2026 1:07:45pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+// Все непрерывные параметры патча подряд одними float - этот блок пишется
+// в состояние как есть и годится для поэлементной интерполяции.
+struct OperatorParameters {
+    float waveType;
+    float level;
+    float octave;
+    float detune;
+    float attack;
+    float decay;
+    float sustain;
+    float release;
+};
+
+struct PatchParameters {
+    static constexpr int numOperators = 4;
+
+    OperatorParameters operators[numOperators];
+    float modulationDepths[numOperators][numOperators];   // [modulator][carrier], диагональ - обратная связь
+    float modulationEnabled[numOperators][numOperators];
+    float level;
+
+    float filterMode;
+    float filterCutoff;
+    float filterResonance;
+    float filterEnvelopeAmount;
+    float filterAttack;
+    float filterDecay;
+    float filterSustain;
+    float filterRelease;
+
+    static constexpr int size() { return static_cast<int>(sizeof(PatchParameters) / sizeof(float)); }
+    float* data() { return reinterpret_cast<float*>(this); }
+    const float* data() const { return reinterpret_cast<const float*>(this); }
+};
+
+struct EffectSlot {
+    static constexpr int maxNameLength = 16;
+
+    char name[maxNameLength];
+    std::int32_t isActive;
+    float parameters[2];
+};
+
+// Источники модуляции и маршруты. Номера источников и назначений - из ModulationEngine,
+// маршрут без источника (-1) или с нулевой глубиной считается пустым.
+struct LfoSettings {
+    float shape;
+    float rate;
+    float retrigger;
+};
+
+struct EnvelopeSettings {
+    float attack;
+    float decay;
+    float sustain;
+    float release;
+};
+
+struct ModulationRoute {
+    std::int32_t source;
+    std::int32_t destination;
+    float amount;
+};
+
+struct ModulationSettings {
+    static constexpr int numLfos = 2;
+    static constexpr int numEnvelopes = 2;
+    static constexpr int maxRoutes = 16;
+
+    LfoSettings lfos[numLfos];
+    EnvelopeSettings envelopes[numEnvelopes];
+    ModulationRoute routes[maxRoutes];
+};
+
+struct Patch {
+    static constexpr std::uint32_t magic = 0x314d4653;   // "SFM1"
+    static constexpr std::uint32_t version = 2;
+    static constexpr int maxEffects = 16;
+
+    // Заголовок фиксированного размера; всё после него - сырые байты Patch.
+    // Более старые версии короче: недостающий хвост остаётся по умолчанию.
+    struct Header {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint32_t size;
+        std::uint32_t reserved;
+    };
+
+    PatchParameters parameters;
+    std::int32_t numEffects;
+    EffectSlot effects[maxEffects];
+    ModulationSettings modulation;   // с версии 2
+
+    static Patch getDefault();
+
+    void writeTo(juce::MemoryBlock& destData) const;
+    // bytesRead - сколько байт занял патч вместе с заголовком; за ним могут идти другие данные
+    bool readFrom(const void* data, int sizeInBytes, int* bytesRead = nullptr);
+    void readPayload(const void* data, size_t sizeInBytes);
+    // Приводит прочитанные байты к допустимым значениям: вместо NaN и бесконечностей -
+    // значения по умолчанию, номера формы волны, режима фильтра и формы LFO - в пределах своих enum
+    void sanitize();
+    std::unique_ptr<juce::XmlElement> createXml() const;
+};
+
+static_assert(std::is_trivially_copyable<Patch>::value, "Patch is stored with memcpy");
+static_assert(sizeof(PatchParameters) == PatchParameters::size() * sizeof(float), "PatchParameters must be a flat float block");
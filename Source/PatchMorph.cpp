@@ -0,0 +1,110 @@
+/*
+  ==============================================================================
+
+    PatchMorph.cpp
+    Created: 21 Oct 2026 3:48:22pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#include "PatchMorph.h"
+#include <cstddef>
+#include <cstring>
+
+namespace {
+    constexpr int parameterIndex(size_t offset) {
+        return static_cast<int>(offset / sizeof(float));
+    }
+
+    constexpr int operatorStride = parameterIndex(sizeof(OperatorParameters));
+    constexpr int waveTypeField = parameterIndex(offsetof(OperatorParameters, waveType));
+    constexpr int enabledBegin = parameterIndex(offsetof(PatchParameters, modulationEnabled));
+    constexpr int enabledEnd = enabledBegin + PatchParameters::numOperators * PatchParameters::numOperators;
+    constexpr int filterModeIndex = parameterIndex(offsetof(PatchParameters, filterMode));
+}
+
+MorphTable::MorphTable(const std::vector<Patch>& snapshots)
+    : numSnapshots(juce::jlimit(0, maxSnapshots, static_cast<int>(snapshots.size()))),
+    layout(snapshots.empty() ? Patch::getDefault() : snapshots.front()),
+    values(juce::jmax(1, numSnapshots) * numParameters, 0.0f),
+    deltas(juce::jmax(1, numSnapshots - 1) * numParameters, 0.0f) {
+    for (int s = 0; s < numSnapshots; ++s) {
+        float* row = values.data() + s * numParameters;
+        std::memcpy(row, snapshots[s].parameters.data(), sizeof(PatchParameters));
+
+        // Эффекты выравниваются по цепочке первого снимка: слот ищется по имени,
+        // а если в снимке такого эффекта нет, остаются значения первого снимка
+        for (int slot = 0; slot < layout.numEffects; ++slot) {
+            const EffectSlot* source = &layout.effects[slot];
+            for (int k = 0; k < snapshots[s].numEffects; ++k) {
+                if (std::strncmp(snapshots[s].effects[k].name, source->name, EffectSlot::maxNameLength) == 0) {
+                    source = &snapshots[s].effects[k];
+                    break;
+                }
+            }
+            row[effectOffset + slot * 2] = source->parameters[0];
+            // Размер свёртки перестраивает ИХ в фоне - такое на ходу не морфим
+            row[effectOffset + slot * 2 + 1] = std::strcmp(layout.effects[slot].name, "Convolution") == 0
+                ? layout.effects[slot].parameters[1] : source->parameters[1];
+        }
+    }
+
+    for (int s = 0; s + 1 < numSnapshots; ++s) {
+        juce::FloatVectorOperations::subtract(deltas.data() + s * numParameters,
+            values.data() + (s + 1) * numParameters, values.data() + s * numParameters, numParameters);
+    }
+
+    for (int parameter = 0; parameter < numParameters; ++parameter) {
+        bool differs = false;
+        for (int s = 1; s < numSnapshots && !differs; ++s) {
+            differs = values[s * numParameters + parameter] != values[parameter];
+        }
+        if (differs) {
+            activeParameters.push_back(parameter);
+            if (isStepped(parameter)) {
+                steppedParameters.push_back(parameter);
+            }
+        }
+    }
+}
+
+int MorphTable::getNumSnapshots() {
+    return numSnapshots;
+}
+
+const Patch& MorphTable::getLayout() {
+    return layout;
+}
+
+const std::vector<int>& MorphTable::getActiveParameters() {
+    return activeParameters;
+}
+
+bool MorphTable::isStepped(int parameter) {
+    if (parameter < PatchParameters::numOperators * operatorStride) {
+        return parameter % operatorStride == waveTypeField;
+    }
+    return (parameter >= enabledBegin && parameter < enabledEnd) || parameter == filterModeIndex;
+}
+
+void MorphTable::evaluate(float position, float* destination) {
+    if (numSnapshots < 2) {
+        std::memcpy(destination, values.data(), numParameters * sizeof(float));
+        return;
+    }
+
+    float scaled = juce::jlimit(0.0f, 1.0f, position) * static_cast<float>(numSnapshots - 1);
+    int segment = juce::jmin(static_cast<int>(scaled), numSnapshots - 2);
+    float fraction = scaled - static_cast<float>(segment);
+
+    const float* from = values.data() + segment * numParameters;
+    juce::FloatVectorOperations::copy(destination, from, numParameters);
+    juce::FloatVectorOperations::addWithMultiply(destination, deltas.data() + segment * numParameters, fraction, numParameters);
+
+    // Форму волны, режим фильтра и включение связей не смешать - переключаем посередине
+    const float* to = from + numParameters;
+    for (int parameter : steppedParameters) {
+        destination[parameter] = fraction < 0.5f ? from[parameter] : to[parameter];
+    }
+}
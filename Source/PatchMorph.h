@@ -0,0 +1,44 @@
+/*
+  ==============================================================================
+
+    PatchMorph.h
+    Created: 21 Oct 2026 3:48:22pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+#include "Patch.h"
+
+// Таблица морфинга: снимки патчей, разложенные в плоский массив float,
+// и разности соседних снимков. Строится на потоке сообщений целиком,
+// аудиопоток только считает по ней линейную интерполяцию.
+class MorphTable {
+public:
+    static constexpr int maxSnapshots = 8;
+    static constexpr int numEffectParameters = Patch::maxEffects * 2;
+    static constexpr int effectOffset = PatchParameters::size();
+    static constexpr int numParameters = PatchParameters::size() + numEffectParameters;
+
+    MorphTable(const std::vector<Patch>& snapshots);
+
+    int getNumSnapshots();
+    const Patch& getLayout();
+    const std::vector<int>& getActiveParameters();
+
+    // position 0..1 проходит снимки по порядку; destination - numParameters float
+    void evaluate(float position, float* destination);
+
+private:
+    int numSnapshots;
+    Patch layout;
+    std::vector<float> values;      // [снимок][параметр]
+    std::vector<float> deltas;      // [отрезок][параметр]
+    std::vector<int> steppedParameters;
+    std::vector<int> activeParameters;
+
+    static bool isStepped(int parameter);
+};
@@ -0,0 +1,37 @@
+/*
+  ==============================================================================
+
+    PitchTable.cpp
+    Created: 26 Oct 2026 2:52:18pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#include "PitchTable.h"
+#include <algorithm>
+#include <cmath>
+
+void PitchTable::prepare(double sampleRate, DspArena& arena) {
+    increments = arena.allocateArray<float>(size);
+    hertzPerRadian = static_cast<float>(sampleRate / juce::MathConstants<double>::twoPi);
+    if (increments == nullptr) {
+        return;
+    }
+    for (int i = 0; i < size; ++i) {
+        double pitch = minPitch + static_cast<double>(i) / stepsPerSemitone;
+        double frequency = 440.0 * std::exp2((pitch - 69.0) / 12.0);
+        increments[i] = static_cast<float>(frequency * juce::MathConstants<double>::twoPi / sampleRate);
+    }
+}
+
+float PitchTable::getIncrement(float pitch) const {
+    float position = std::min(static_cast<float>(size - 1), std::max(0.0f, (pitch - minPitch) * stepsPerSemitone));
+    int index = std::min(static_cast<int>(position), size - 2);
+    float fraction = position - index;
+    return increments[index] + fraction * (increments[index + 1] - increments[index]);
+}
+
+float PitchTable::getFrequency(float increment) const {
+    return increment * hertzPerRadian;
+}
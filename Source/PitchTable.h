@@ -0,0 +1,35 @@
+/*
+  ==============================================================================
+
+    PitchTable.h
+    Created: 26 Oct 2026 2:52:18pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "DspArena.h"
+
+// Приращения фазы (радиан на сэмпл) по высоте в полутонах - номер MIDI-ноты с дробной
+// частью, куда уже сложены октава, расстройка, изгиб и модуляция. Таблица своя у каждой
+// частоты дискретизации и лежит в арене экземпляра. 16 точек на полутон с линейной
+// интерполяцией дают относительную ошибку около 1e-6; высота вне диапазона прижимается к краю.
+class PitchTable {
+public:
+    static constexpr int minPitch = -160;
+    static constexpr int maxPitch = 256;
+    static constexpr int stepsPerSemitone = 16;
+    static constexpr int size = (maxPitch - minPitch) * stepsPerSemitone + 1;
+
+    void prepare(double sampleRate, DspArena& arena);
+
+    float getIncrement(float pitch) const;
+    // Частота в герцах, которой соответствует приращение
+    float getFrequency(float increment) const;
+
+private:
+    float* increments = nullptr;
+    float hertzPerRadian = 0.0f;
+};
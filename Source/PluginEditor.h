@@ -11,11 +11,17 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
 #include "FxBlock.h"
+#include "PresetBrowser.h"
+#include "Analyzer.h"
+#include "SynthPage.h"
+#include "FilterPage.h"
+#include "ModulationPage.h"
+#include "KnobLookAndFeel.h"
 
 //==============================================================================
 /**
 */
-class SynthFMAudioProcessorEditor : public juce::AudioProcessorEditor
+class SynthFMAudioProcessorEditor : public juce::AudioProcessorEditor, public juce::ChangeListener
 {
 public:
     SynthFMAudioProcessorEditor(SynthFMAudioProcessor&);
@@ -23,36 +29,35 @@ public:
 
     void paint(juce::Graphics&) override;
     void resized() override;
-    void comboBoxChanged(juce::ComboBox* comboBoxThatHasChanged);
     void showFxInterface();
     void showSynthInterface();
+    void showFilterInterface();
+    void showModulationInterface();
+    void showPresetInterface();
+    void showScopeInterface();
+    void refreshFromPatch();
+    void changeListenerCallback(juce::ChangeBroadcaster* source) override;
 
 private:
     SynthFMAudioProcessor& processor;
     juce::MidiKeyboardComponent keyboardComponent;
-    juce::ComboBox waveTypeSelector[4];
-    juce::Slider modulationDepthDials[4][4];
-    juce::ToggleButton enableModulation[4][4];
-    juce::Slider octaveDials[4];
-    juce::Slider detuneDials[4];
-    juce::Slider attackSliders[4];
-    juce::Slider decaySliders[4];
-    juce::Slider sustainSliders[4];
-    juce::Slider releaseSliders[4];
-    juce::Slider levelDials[4];
-
-    juce::Slider levelSlider;
-    juce::Label levelLabel;
-
-    juce::Label attackLabels[4];
-    juce::Label decayLabels[4];
-    juce::Label sustainLabels[4];
-    juce::Label releaseLabels[4];
-
+    juce::SharedResourcePointer<KnobLookAndFeel> knobLookAndFeel;
     juce::TextButton synthButton{ "Synth" };
+    juce::TextButton filterButton{ "Filter" };
+    juce::TextButton modulationButton{ "Mod" };
     juce::TextButton fxButton{ "FX" };
-
-    bool isSynth = true;
+    juce::TextButton presetButton{ "Presets" };
+    juce::TextButton scopeButton{ "Scope" };
+
+    // Страницы создаются при первом показе
+    std::unique_ptr<SynthPage> synthPage;
+    std::unique_ptr<FilterPage> filterPage;
+    std::unique_ptr<ModulationPage> modulationPage;
+    std::unique_ptr<PresetBrowser> presetBrowser;
+    std::unique_ptr<Analyzer> analyzer;
+
+    juce::Rectangle<int> getPageBounds();
+    void showPage(juce::Component* page);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SynthFMAudioProcessorEditor)
 };
@@ -8,29 +8,73 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include <cstddef>
+#include <limits>
+
+namespace {
+    // Номер поля в плоском блоке float, по которому идёт морфинг
+    constexpr int field(size_t offset) {
+        return static_cast<int>(offset / sizeof(float));
+    }
+
+    constexpr int operatorStride = field(sizeof(OperatorParameters));
+    constexpr int octaveField = field(offsetof(OperatorParameters, octave));
+    constexpr int detuneField = field(offsetof(OperatorParameters, detune));
+    // Режим, срез, резонанс и глубина огибающей фильтра - настройки VoiceFilterBank, а не голоса
+    constexpr int filterSettingsBegin = field(offsetof(PatchParameters, filterMode));
+    constexpr int filterSettingsEnd = field(offsetof(PatchParameters, filterAttack));
+
+    // Блок партий в состоянии плагина, пишется сразу за основным патчем
+    constexpr int partsMagic = 0x54504653;   // "SFPT"
+}
 
 //==============================================================================
 SynthFMAudioProcessor::SynthFMAudioProcessor()
 #ifndef JucePlugin_PreferredChannelConfigurations
-     : AudioProcessor (BusesProperties()
-                     #if ! JucePlugin_IsMidiEffect
-                      #if ! JucePlugin_IsSynth
-                       .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
-                      #endif
-                       .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
-                     #endif
-                       )
+     : AudioProcessor (createBusesProperties())
 #endif
 {
-    oscillators.resize(4);
-    for (auto& osc : oscillators) {
-        osc = new Oscillator();
+    renderPool = std::make_unique<RenderPool>(1);
+    morphValues.resize(MorphTable::numParameters, 0.0f);
+    appliedMorphValues.resize(MorphTable::numParameters, 0.0f);
+    channelVoices.fill(-1);
+    for (auto& send : partSends) {
+        send.store(1.0f);
     }
-    modulationMatrix = ModulationMatrix(oscillators);
+
+    Patch defaultPatch = Patch::getDefault();
+    partPatches.fill(defaultPatch);
+    buildDspState(currentSampleRate);
+    storeEffects(defaultPatch);
+    applyPatch(defaultPatch);
+
+    presetBank.open(getDefaultPresetBankFile());
+    startTimer(20);
+}
+
+juce::AudioProcessor::BusesProperties SynthFMAudioProcessor::createBusesProperties() {
+    BusesProperties buses;
+   #if ! JucePlugin_IsMidiEffect
+    #if ! JucePlugin_IsSynth
+    buses = buses.withInput("Input", juce::AudioChannelSet::stereo(), true);
+    #endif
+    buses = buses.withOutput("Output", juce::AudioChannelSet::stereo(), true);
+    // Отдельные выходы партий 2-16, по умолчанию выключены
+    for (int part = 1; part < numParts; ++part) {
+        buses = buses.withOutput("Part " + juce::String(part + 1), juce::AudioChannelSet::stereo(), false);
+    }
+   #endif
+    return buses;
 }
 
 SynthFMAudioProcessor::~SynthFMAudioProcessor()
 {
+    stopTimer();
+    delete pendingMorph.exchange(nullptr);
+    delete retiredMorph.exchange(nullptr);
+    delete pendingPool.exchange(nullptr);
+    delete retiredPool.exchange(nullptr);
+    destroyVoices();
 }
 
 //==============================================================================
@@ -73,33 +117,280 @@ double SynthFMAudioProcessor::getTailLengthSeconds() const
 
 int SynthFMAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    return juce::jmax(1, presetBank.getNumPresets());   // NB: some hosts don't cope very well if you tell them there are 0 programs,
+                                                        // so this should be at least 1, even if you're not really implementing programs.
 }
 
 int SynthFMAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return currentProgram.load();
 }
 
 void SynthFMAudioProcessor::setCurrentProgram (int index)
 {
+    // Может прийти и с аудиопотока (MIDI program change), поэтому номер проверяется при загрузке
+    setPartProgram(0, index);
 }
 
 const juce::String SynthFMAudioProcessor::getProgramName (int index)
 {
-    return {};
+    return presetBank.getName(index);
 }
 
 void SynthFMAudioProcessor::changeProgramName (int index, const juce::String& newName)
 {
 }
 
+PresetBank& SynthFMAudioProcessor::getPresetBank() {
+    return presetBank;
+}
+
+bool SynthFMAudioProcessor::loadPresetBank(const juce::File& file) {
+    if (!presetBank.open(file)) {
+        return false;
+    }
+    currentProgram.store(0);
+    updateHostDisplay();
+    return true;
+}
+
+bool SynthFMAudioProcessor::installPresetBank(const juce::File& newBankFile) {
+    // Открытый банк отображён в память, поэтому сначала закрываем его, потом подменяем файл
+    juce::File target = presetBank.isOpen() ? presetBank.getFile() : getDefaultPresetBankFile();
+    presetBank.close();
+    target.getParentDirectory().createDirectory();
+    bool moved = newBankFile.moveFileTo(target);
+    return loadPresetBank(target) && moved;
+}
+
+juce::File SynthFMAudioProcessor::getDefaultPresetBankFile() {
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile("SynthFM").getChildFile("Presets.sfmbank");
+}
+
+void SynthFMAudioProcessor::addMorphSnapshot() {
+    if (static_cast<int>(morphSnapshots.size()) >= MorphTable::maxSnapshots) {
+        return;
+    }
+    Patch snapshot = patch;
+    storeEffects(snapshot);
+    morphSnapshots.push_back(snapshot);
+    rebuildMorphTable();
+}
+
+void SynthFMAudioProcessor::clearMorphSnapshots() {
+    morphSnapshots.clear();
+    rebuildMorphTable();
+}
+
+int SynthFMAudioProcessor::getNumMorphSnapshots() {
+    return static_cast<int>(morphSnapshots.size());
+}
+
+void SynthFMAudioProcessor::setMorphPosition(float position) {
+    morphTarget.store(juce::jlimit(0.0f, 1.0f, position));
+}
+
+void SynthFMAudioProcessor::setMorphController(int controllerNumber) {
+    morphController.store(controllerNumber);
+}
+
+void SynthFMAudioProcessor::rebuildMorphTable() {
+    delete pendingMorph.exchange(new MorphTable(morphSnapshots));
+}
+
+void SynthFMAudioProcessor::updateMorph(int numSamples) {
+    if (morphTable == nullptr || morphTable->getNumSnapshots() < 2) {
+        return;
+    }
+
+    // Позиция сглаживается по блокам с постоянной ~30 мс, чтобы рывки контроллера не щёлкали
+    float target = morphTarget.load();
+    float coefficient = 1.0f - std::exp(-static_cast<float>(numSamples) / (0.03f * static_cast<float>(currentSampleRate)));
+    morphPosition += (target - morphPosition) * coefficient;
+    if (std::abs(target - morphPosition) < 1.0e-4f) {
+        morphPosition = target;
+    }
+    if (morphPosition == appliedMorphPosition) {
+        return;
+    }
+    appliedMorphPosition = morphPosition;
+
+    // Сдвинувшиеся параметры голоса пишутся в плоский блок патча, и голосам раздаются
+    // только они; эффекты обновляются отдельно в applyMorphEffects
+    morphTable->evaluate(morphPosition, morphValues.data());
+    float* parameters = patch.parameters.data();
+    std::array<int, PatchParameters::size()> changed;
+    int numChanged = 0;
+    bool filterChanged = false;
+    bool pitchChanged[PatchParameters::numOperators] = {};
+    for (int parameter : morphTable->getActiveParameters()) {
+        if (parameter >= MorphTable::effectOffset || morphValues[parameter] == appliedMorphValues[parameter]) {
+            continue;
+        }
+        parameters[parameter] = morphValues[parameter];
+        appliedMorphValues[parameter] = morphValues[parameter];
+        int member = parameter % operatorStride;
+        if (parameter < PatchParameters::numOperators * operatorStride
+            && (member == octaveField || member == detuneField)) {
+            pitchChanged[parameter / operatorStride] = true;
+        }
+        else if (parameter >= filterSettingsBegin && parameter < filterSettingsEnd) {
+            filterChanged = true;
+        }
+        else {
+            changed[numChanged++] = parameter;
+        }
+    }
+
+    // Октава и расстройка смешиваются как одна высота в центах
+    for (int index = 0; index < PatchParameters::numOperators; ++index) {
+        if (!pitchChanged[index]) {
+            continue;
+        }
+        OperatorParameters& op = patch.parameters.operators[index];
+        float cents = op.octave * 1200.0f + op.detune;
+        int octave = juce::jlimit(-4, 4, juce::roundToInt(cents / 1200.0f));
+        op.octave = static_cast<float>(octave);
+        op.detune = cents - 1200.0f * static_cast<float>(octave);
+        // Перенос через октаву меняет обе половины высоты
+        changed[numChanged++] = index * operatorStride + octaveField;
+        changed[numChanged++] = index * operatorStride + detuneField;
+    }
+
+    if (numChanged > 0) {
+        forEachPartVoice(0, [&](Voice& voice) {
+            for (int i = 0; i < numChanged; ++i) {
+                voice.setParameter(patch.parameters, changed[i]);
+            }
+        });
+    }
+    if (filterChanged) {
+        updatePartFilters(0);
+    }
+}
+
+void SynthFMAudioProcessor::applyMorphEffects() {
+    if (morphTable == nullptr || morphTable->getNumSnapshots() < 2) {
+        return;
+    }
+    for (int parameter : morphTable->getActiveParameters()) {
+        float value = morphValues[parameter];
+        if (parameter < MorphTable::effectOffset || value == appliedMorphValues[parameter]) {
+            continue;
+        }
+        appliedMorphValues[parameter] = value;
+        int slot = (parameter - MorphTable::effectOffset) / 2;
+        const char* name = morphTable->getLayout().effects[slot].name;
+        for (int i = 0; i < static_cast<int>(fxList.effects.size()); ++i) {
+            if (fxList.effects[i].name == name) {
+                if ((parameter - MorphTable::effectOffset) % 2 == 0) {
+                    fxList.setEffect1(i, value);
+                }
+                else {
+                    fxList.setEffect2(i, value);
+                }
+                break;
+            }
+        }
+    }
+}
+
+void SynthFMAudioProcessor::timerCallback() {
+    delete retiredMorph.exchange(nullptr);
+    delete retiredPool.exchange(nullptr);
+    loadRequestedPrograms();
+    if (patchChanged.exchange(false)) {
+        sendChangeMessage();
+    }
+}
+
+void SynthFMAudioProcessor::loadRequestedPrograms() {
+    for (int part = 0; part < numParts; ++part) {
+        ProgramSlot& slot = programSlots[part];
+        int program = slot.requested.exchange(-1);
+        Patch loaded;
+        if (program < 0 || !presetBank.getPatch(program, loaded)) {
+            continue;
+        }
+
+        // Пока аудиопоток читает прошлый патч, слот трогать нельзя - повторим на следующем тике
+        int state = slot.state.load();
+        while (state != Reading && !slot.state.compare_exchange_weak(state, Writing)) {}
+        if (state == Reading) {
+            int none = -1;
+            slot.requested.compare_exchange_strong(none, program);
+            continue;
+        }
+        slot.patch = loaded;
+        slot.state.store(Ready);
+        if (part == 0) {
+            currentProgram.store(program);
+        }
+    }
+}
+
 //==============================================================================
 void SynthFMAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    for (auto& osc : oscillators) {
-        osc->setSampleRate(sampleRate);
+    currentSampleRate = sampleRate;
+    visualTap.setSampleRate(sampleRate);
+    fxPipeline.waitUntilIdle();
+    buildDspState(sampleRate);
+    filterBank.setSampleRate(sampleRate);
+    maxBlockSize = juce::jmax(1, samplesPerBlock);
+    dryMix.assign(static_cast<size_t>(maxBlockSize), 0.0f);
+    controlRemaining = 0;
+    modulation.setSampleRate(static_cast<float>(sampleRate));
+    modulation.reset();
+    governor.prepare(sampleRate);
+
+    int mainChannels = getBus(false, 0) != nullptr ? getBus(false, 0)->getNumberOfChannels() : 0;
+    fxPipeline.prepare(maxBlockSize, mainChannels, getTotalNumOutputChannels() - mainChannels);
+    if (fxPipelined.load()) {
+        fxPipeline.start(maxBlockSize, sampleRate);
+    }
+    updateLatency();
+}
+
+void SynthFMAudioProcessor::buildDspState(double sampleRate) {
+    destroyVoices();
+    dspArena.beginLayout();
+    layoutDspState(sampleRate);
+    dspArena.allocate();
+    layoutDspState(sampleRate);
+
+    // Новые голоса молчат и принадлежат первой партии
+    for (auto* voice : voices) {
+        voice->setTables(sharedTables.get(), &pitchTable);
+        voice->setParameters(patch.parameters);
+    }
+    channelVoices.fill(-1);
+    noteCache.prepare(sampleRate);
+    for (auto& track : noteTracks) {
+        track = NoteCache::Track();
+    }
+    partHashes.fill(0);
+    draftWaveforms = false;
+}
+
+void SynthFMAudioProcessor::layoutDspState(double sampleRate) {
+    // На проходе подсчёта арена раздаёт nullptr, на втором - настоящие адреса
+    pitchTable.prepare(sampleRate, dspArena);
+    for (auto& voice : voices) {
+        voice = dspArena.create<Voice>();
+    }
+    for (auto& effect : fxList.effects) {
+        effect.prepare(sampleRate, dspArena);
+    }
+}
+
+void SynthFMAudioProcessor::destroyVoices() {
+    for (auto& voice : voices) {
+        if (voice != nullptr) {
+            voice->~Voice();
+            voice = nullptr;
+        }
     }
 }
 
@@ -110,62 +401,593 @@ void SynthFMAudioProcessor::releaseResources()
 }
 
 void SynthFMAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) {
+    auto startTicks = juce::Time::getHighResolutionTicks();
+    applyQualityTier();
     keyboardState.processNextMidiBuffer(midiMessages, 0, buffer.getNumSamples(), true);
+
+    // Все буферы выделены под maxBlockSize, блок хоста длиннее режется на куски
+    for (int offset = 0; offset < buffer.getNumSamples(); offset += maxBlockSize) {
+        int numSamples = std::min(maxBlockSize, buffer.getNumSamples() - offset);
+        juce::AudioBuffer<float> chunk(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), offset, numSamples);
+        processChunk(chunk, midiMessages, offset, offset + numSamples == buffer.getNumSamples());
+    }
+
+    // Офлайн бюджета нет - там всегда полное качество
+    if (governorEnabled.load() && !isNonRealtime()) {
+        double elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+        governor.update(elapsed, buffer.getNumSamples());
+    }
+    else {
+        governor.reset();
+    }
+    qualityTier.store(governor.getTier());
+    cpuLoad.store(governor.getLoad());
+}
+
+void SynthFMAudioProcessor::applyQualityTier() {
+    QualityGovernor::Tier tier = governor.getTier();
+
+    int rate = userControlRate.load();
+    if (tier >= QualityGovernor::SlowModulation) {
+        rate = std::min(4 * rate, static_cast<int>(ModulationEngine::maxControlRate));
+    }
+    modulation.setControlRate(rate);
+
+    bool draft = tier >= QualityGovernor::DraftWaveforms;
+    if (draft != draftWaveforms) {
+        draftWaveforms = draft;
+        for (auto* voice : voices) {
+            voice->setDraft(draft);
+        }
+    }
+
+    // Голоса за новым пределом не обрываются, а уходят в release; новые ноты берут только
+    // голоса до предела, так что дорожки рендера постепенно сжимаются
+    int limit = tier >= QualityGovernor::QuarterPolyphony ? maxVoices / 4
+        : tier >= QualityGovernor::HalfPolyphony ? maxVoices / 2 : maxVoices;
+    if (limit < voiceLimit) {
+        for (int v = limit; v < maxVoices; ++v) {
+            if (voices[v]->isActive() && !voices[v]->isReleased()) {
+                noteCache.goLive(noteTracks[v], *voices[v]);
+                voices[v]->release();
+                modulation.noteOff(v);
+            }
+        }
+    }
+    voiceLimit = limit;
+}
+
+void SynthFMAudioProcessor::applyEffectQuality() {
+    // Только пока конвейер эффектов стоит: Ensemble при смене числа голосов переписывает громкости
+    bool reduced = governor.getTier() >= QualityGovernor::ReducedEnsemble;
+    if (reduced != reducedEffects) {
+        reducedEffects = reduced;
+        for (auto& effect : fxList.effects) {
+            effect.setReducedQuality(reduced);
+        }
+    }
+}
+
+void SynthFMAudioProcessor::processChunk(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages, int offset, bool isLastChunk) {
     buffer.clear();
-    juce::MidiMessage m;
-    int time;
 
-    juce::MidiBuffer::Iterator it(midiMessages);
-    while (it.getNextEvent(m, time)) {
-        if (m.isNoteOn()) {
-            currentFrequency = juce::MidiMessage::getMidiNoteInHertz(m.getNoteNumber() - 12);
-            for (auto& osc : oscillators) {
-                osc->reset();
-                osc->setFrequency(currentFrequency);
-                osc->noteOn();
+    // Правка модуляции из интерфейса идёт раньше программ: программа, пришедшая в том же блоке, новее
+    int readyModulation = Ready;
+    if (modulationSlot.state.compare_exchange_strong(readyModulation, Reading)) {
+        modulation.setSettings(modulationSlot.settings);
+        modulationSlot.state.store(Free);
+    }
+
+    for (int part = 0; part < numParts; ++part) {
+        ProgramSlot& slot = programSlots[part];
+        int readyState = Ready;
+        if (slot.state.compare_exchange_strong(readyState, Reading)) {
+            fxPipeline.waitUntilIdle();
+            applyPartPatch(part, slot.patch);
+            slot.state.store(Free);
+            if (part == 0) {
+                patchChanged.store(true);
             }
-            noteCurrentlyOn = true;
         }
-        else if (m.isNoteOff()) {
-            noteCurrentlyOn = false;
+    }
+    updatePartOutputs(buffer);
+
+    if (retiredMorph.load() == nullptr) {
+        if (auto* next = pendingMorph.exchange(nullptr)) {
+            retiredMorph.store(morphTable.release());
+            morphTable.reset(next);
+            // Новая таблица применяется целиком, даже если позиция не сдвинулась
+            std::fill(appliedMorphValues.begin(), appliedMorphValues.end(), std::numeric_limits<float>::quiet_NaN());
+            appliedMorphPosition = -1.0f;
         }
     }
+    updateMorph(buffer.getNumSamples());
 
-    if (noteCurrentlyOn) {
-        float* channelData0 = buffer.getWritePointer(0);
-        float* channelData1 = buffer.getWritePointer(1);
-        for (int sample = 0; sample < buffer.getNumSamples(); ++sample) {
-            auto nextSample = modulationMatrix.process();
-            channelData0[sample] = nextSample;
-            channelData1[sample] = nextSample;
+    if (retiredPool.load() == nullptr) {
+        if (auto* next = pendingPool.exchange(nullptr)) {
+            retiredPool.store(renderPool.release());
+            renderPool.reset(next);
         }
-        for (auto& effect : fxList.effects) {
-            if (effect.isActive) {
-                effect.processBlock(buffer);
+    }
+    updateNoteCache();
+
+    // Голоса рендерятся кусками между нотными событиями, так что ноты стартуют точно по сэмплу.
+    // Выразительность блок не режет: она уходит в массивы своих голосов вместе с позицией.
+    int position = 0;
+    for (const auto metadata : midiMessages) {
+        int samplePosition = metadata.samplePosition - offset;
+        if (samplePosition < 0 && offset > 0) {
+            continue;
+        }
+        if (samplePosition >= buffer.getNumSamples() && !isLastChunk) {
+            break;
+        }
+        int eventPosition = juce::jlimit(0, buffer.getNumSamples(), samplePosition);
+        const juce::MidiMessage message = metadata.getMessage();
+        if (!isExpressionEvent(message)) {
+            renderVoices(buffer, position, eventPosition);
+            position = eventPosition;
+        }
+        handleMidiEvent(message, eventPosition);
+    }
+    renderVoices(buffer, position, buffer.getNumSamples());
+    for (auto& voice : voices) {
+        voice->flushExpression();
+    }
+
+    for (int part = 1; part < numParts; ++part) {
+        if (partOutputs[part] != nullptr && getBus(false, part)->getNumberOfChannels() > 1) {
+            int channel = getChannelIndexInProcessBlockBuffer(false, part, 0);
+            buffer.copyFrom(channel + 1, 0, buffer, channel, 0, buffer.getNumSamples());
+        }
+    }
+
+    // Эффекты обрабатывают только основную шину; сухая часть партий добавляется после них
+    juce::AudioBuffer<float> mainBus = getBusBuffer(buffer, false, 0);
+    bool wasPipelined = blockPipelined;
+    blockPipelined = fxPipelined.load() && fxPipeline.isRunning();
+    // Всё, что меняет цепочку (морфинг слотов, качество, модуляция), идёт только после ожидания
+    fxPipeline.waitUntilIdle();
+    applyMorphEffects();
+    applyEffectQuality();
+    applyEffectModulation();
+    if (blockPipelined) {
+        // После включения первый блок задержки выходит тишиной
+        if (!wasPipelined) {
+            fxPipeline.reset();
+        }
+        fxPipeline.process(buffer, blockMultitimbral ? dryMix.data() : nullptr, &processEffectsTask, this);
+    }
+    else {
+        processEffects(mainBus);
+        if (blockMultitimbral) {
+            for (int channel = 0; channel < mainBus.getNumChannels(); ++channel) {
+                juce::FloatVectorOperations::add(mainBus.getWritePointer(channel), dryMix.data(), mainBus.getNumSamples());
+            }
+        }
+    }
+    visualTap.push(mainBus);
+}
+
+void SynthFMAudioProcessor::processEffectsTask(void* context, juce::AudioBuffer<float>& buffer) {
+    static_cast<SynthFMAudioProcessor*>(context)->processEffects(buffer);
+}
+
+void SynthFMAudioProcessor::processEffects(juce::AudioBuffer<float>& buffer) {
+    for (auto& effect : fxList.effects) {
+        if (effect.isActive) {
+            effect.processBlock(buffer);
+        }
+    }
+}
+
+void SynthFMAudioProcessor::updatePartOutputs(juce::AudioBuffer<float>& buffer) {
+    blockMultitimbral = multitimbral.load();
+    partOutputs.fill(nullptr);
+    if (blockMultitimbral) {
+        juce::FloatVectorOperations::clear(dryMix.data(), buffer.getNumSamples());
+        for (int part = 1; part < numParts && part < getBusCount(false); ++part) {
+            auto* bus = getBus(false, part);
+            if (bus != nullptr && bus->isEnabled() && bus->getNumberOfChannels() > 0) {
+                partOutputs[part] = buffer.getWritePointer(getChannelIndexInProcessBlockBuffer(false, part, 0));
+            }
+        }
+    }
+
+    for (int v = 0; v < maxVoices; ++v) {
+        updateLaneMix(v);
+    }
+}
+
+void SynthFMAudioProcessor::updateLaneMix(int voice) {
+    // Без мультитембрального режима всё идёт в эффекты, как раньше
+    int part = voices[voice]->getPart();
+    float send = blockMultitimbral ? partSends[part].load() : 1.0f;
+    laneOutputs[voice] = partOutputs[part];
+    laneSends[voice] = laneOutputs[voice] != nullptr ? 0.0f : send;
+    laneDry[voice] = laneOutputs[voice] != nullptr ? 0.0f : 1.0f - send;
+}
+
+void SynthFMAudioProcessor::updateNoteCache() {
+    bool wasActive = blockNoteCache;
+    blockNoteCache = noteCacheEnabled.load() && isNonRealtime();
+    if (!blockNoteCache) {
+        if (wasActive) {
+            for (int v = 0; v < maxVoices; ++v) {
+                noteCache.retire(noteTracks[v], *voices[v]);
+            }
+        }
+        return;
+    }
+
+    // Правка патча партии (сеттеры, морфинг, смена программы) меняет его хэш: голоса партии
+    // уходят на живой рендер, недописанные записи выбрасываются, а восстановленные
+    // из снимка голоса получают новые параметры
+    for (int part = 0; part < numParts; ++part) {
+        std::uint64_t hash = NoteCache::hashParameters(partPatches[part].parameters);
+        if (hash == partHashes[part]) {
+            continue;
+        }
+        partHashes[part] = hash;
+        for (int v = 0; v < maxVoices; ++v) {
+            if (voices[v]->getPart() == part && noteCache.goLive(noteTracks[v], *voices[v], false)) {
+                voices[v]->setParameters(partPatches[part].parameters);
+            }
+        }
+    }
+}
+
+bool SynthFMAudioProcessor::isVoiceModulated() {
+    for (int destination = 0; destination < ModulationEngine::FilterCutoff; ++destination) {
+        if (modulation.isUsed(destination) || modulationApplied[destination]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SynthFMAudioProcessor::isExpressionEvent(const juce::MidiMessage& message) {
+    return message.isPitchWheel() || message.isChannelPressure() || message.isAftertouch() || message.isController();
+}
+
+bool SynthFMAudioProcessor::isMemberChannel(int channel) {
+    // В мультитембральном режиме каналы принадлежат партиям, MPE не действует
+    return mpeEnabled.load() && !multitimbral.load() && channel >= 2 && channel <= numMidiChannels;
+}
+
+void SynthFMAudioProcessor::pushChannelExpression(int channel, int samplePosition, NoteExpression::Type type, float value) {
+    int v = channelVoices[channel - 1];
+    if (v >= 0 && voices[v]->getChannel() == channel && voices[v]->isActive()) {
+        voices[v]->pushExpression(samplePosition, type, value);
+    }
+}
+
+int SynthFMAudioProcessor::getChannelPart(int channel) {
+    return multitimbral.load() && channel >= 1 && channel <= numParts ? channel - 1 : 0;
+}
+
+void SynthFMAudioProcessor::pushPartExpression(int part, int samplePosition, NoteExpression::Type type, float value) {
+    for (auto& voice : voices) {
+        if (voice->isActive() && voice->getPart() == part
+            && (type == NoteExpression::GlobalBend || !isMemberChannel(voice->getChannel()))) {
+            voice->pushExpression(samplePosition, type, value);
+        }
+    }
+}
+
+void SynthFMAudioProcessor::handleMidiEvent(const juce::MidiMessage& message, int samplePosition) {
+    int channel = message.getChannel();
+    if (message.isNoteOn()) {
+        startVoice(message.getNoteNumber(), channel, static_cast<float>(message.getNoteNumber() - 12), message.getFloatVelocity());
+    }
+    else if (message.isNoteOff()) {
+        for (int v = 0; v < maxVoices; ++v) {
+            if (voices[v]->getNote() == message.getNoteNumber() && voices[v]->getChannel() == channel && !voices[v]->isReleased()) {
+                noteCache.goLive(noteTracks[v], *voices[v]);
+                voices[v]->release();
+                modulation.noteOff(v);
+            }
+        }
+    }
+    else if (message.isProgramChange()) {
+        if (multitimbral.load() && channel > 1 && channel <= numParts) {
+            setPartProgram(channel - 1, message.getProgramChangeNumber());
+        }
+        else {
+            setCurrentProgram(message.getProgramChangeNumber());
+        }
+    }
+    else if (message.isPitchWheel()) {
+        float bend = (message.getPitchWheelValue() - 8192) / 8192.0f;
+        if (isMemberChannel(channel)) {
+            channelBends[channel - 1] = bend * memberBendRange;
+            pushChannelExpression(channel, samplePosition, NoteExpression::NoteBend, channelBends[channel - 1]);
+        }
+        else {
+            int part = getChannelPart(channel);
+            partBends[part] = bend * masterBendRange;
+            pushPartExpression(part, samplePosition, NoteExpression::GlobalBend, partBends[part]);
+        }
+    }
+    else if (message.isChannelPressure()) {
+        float pressure = message.getChannelPressureValue() / 127.0f;
+        if (isMemberChannel(channel)) {
+            channelPressures[channel - 1] = pressure;
+            pushChannelExpression(channel, samplePosition, NoteExpression::Pressure, pressure);
+        }
+        else if (multitimbral.load()) {
+            // Давление канала партии не должно доходить до голосов других партий
+            int part = getChannelPart(channel);
+            partPressures[part] = pressure;
+            pushPartExpression(part, samplePosition, NoteExpression::Pressure, pressure);
+        }
+        else {
+            modulation.setChannelPressure(pressure);
+        }
+    }
+    else if (message.isAftertouch()) {
+        for (auto& voice : voices) {
+            if (voice->getNote() == message.getNoteNumber() && voice->getChannel() == channel && !voice->isReleased()) {
+                voice->pushExpression(samplePosition, NoteExpression::Pressure, message.getAfterTouchValue() / 127.0f);
             }
         }
     }
+    else if (message.isController()) {
+        // CC74 - тембр по MPE: на канале ноты свой, иначе общий
+        if (message.getControllerNumber() == 74) {
+            float timbre = message.getControllerValue() / 127.0f;
+            if (isMemberChannel(channel)) {
+                channelTimbres[channel - 1] = timbre;
+                pushChannelExpression(channel, samplePosition, NoteExpression::Timbre, timbre);
+            }
+            else {
+                int part = getChannelPart(channel);
+                partTimbres[part] = timbre;
+                // Общие цели модуляции (эффекты) следуют за первой партией
+                if (part == 0) {
+                    modulation.setGlobalTimbre(timbre);
+                }
+                pushPartExpression(part, samplePosition, NoteExpression::Timbre, timbre);
+            }
+        }
+        // Колесо модуляции может одновременно вести и морфинг
+        if (message.getControllerNumber() == 1) {
+            modulation.setModWheel(message.getControllerValue() / 127.0f);
+        }
+        if (message.getControllerNumber() == morphController.load()) {
+            morphTarget.store(message.getControllerValue() / 127.0f);
+        }
+    }
+}
+
+void SynthFMAudioProcessor::startVoice(int note, int channel, float pitch, float velocity) {
+    // Свободный голос до предела полифонии, а если все заняты - самый старый, причём
+    // отпущенные уступают раньше удерживаемых
+    int chosen = 0;
+    for (int i = 0; i < voiceLimit; ++i) {
+        if (!voices[i]->isActive()) {
+            chosen = i;
+            break;
+        }
+        bool released = voices[i]->isReleased();
+        bool chosenReleased = voices[chosen]->isReleased();
+        if (released != chosenReleased ? released : voices[i]->getAge() < voices[chosen]->getAge()) {
+            chosen = i;
+        }
+    }
+    if (noteTracks[chosen].isBusy()) {
+        noteCache.retire(noteTracks[chosen], *voices[chosen]);
+    }
+    // Партия - по MIDI-каналу; голос, пришедший из другой партии, получает её параметры целиком
+    int part = getChannelPart(channel);
+    if (voices[chosen]->getPart() != part) {
+        voices[chosen]->setPart(part);
+        voices[chosen]->setParameters(partPatches[part].parameters);
+        updateLaneMix(chosen);
+    }
+    voices[chosen]->start(note, channel, pitch, ++noteCounter);
+    // Нота на своём канале MPE сразу получает изгиб, давление и тембр, присланные перед ней
+    if (isMemberChannel(channel)) {
+        voices[chosen]->setExpression(channelBends[channel - 1], partBends[part], channelPressures[channel - 1], channelTimbres[channel - 1]);
+    }
     else {
-        for (auto& osc : oscillators) {
-            //osc->setFrequency(0.0);
-            osc->noteOff();
+        voices[chosen]->setExpression(0.0f, partBends[part], partPressures[part], partTimbres[part]);
+    }
+    if (channel >= 1 && channel <= numMidiChannels) {
+        channelVoices[channel - 1] = chosen;
+    }
+    // Записывать и проигрывать можно только ноту, на звук которой ничто не влияет
+    if (blockNoteCache && !isVoiceModulated() && voices[chosen]->getExpression().getPitchBend() == 0.0f) {
+        noteCache.begin(noteTracks[chosen], *voices[chosen], NoteCache::makeKey(partHashes[part], note, velocity, currentSampleRate));
+    }
+    filterBank.resetVoice(chosen);
+    applyFilterSettings(chosen);
+    modulation.noteOn(chosen, note, velocity);
+    // Назначения голоса сразу, а не на следующей границе сетки: иначе до неё нота
+    // звучит без скорости, ключа и огибающих модуляции и потом прыгает
+    NoteExpression& expression = voices[chosen]->getExpression();
+    modulation.setPolyPressure(chosen, expression.getPressure());
+    modulation.setTimbre(chosen, expression.getTimbre());
+    modulation.evaluateVoice(chosen);
+    for (int destination = 0; destination < ModulationEngine::EffectParameter; ++destination) {
+        if (modulation.isUsed(destination)) {
+            applyVoiceDestination(chosen, destination, modulation.getValues(destination)[chosen], 0);
+        }
+    }
+}
+
+void SynthFMAudioProcessor::renderVoices(juce::AudioBuffer<float>& buffer, int startSample, int endSample) {
+    float* channelData0 = buffer.getWritePointer(0);
+    float* channelData1 = buffer.getWritePointer(1);
+
+    // Контрольные блоки идут сплошной сеткой через блоки хоста и события: модуляция
+    // считается только на границах, поэтому звук не зависит от размера буфера хоста.
+    // События и края блока хоста лишь режут рендер внутри контрольного блока.
+    int controlRate = modulation.getControlRate();
+    controlRemaining = std::min(controlRemaining, controlRate);
+    int numSamples = 0;
+    for (int blockStart = startSample; blockStart < endSample; blockStart += numSamples) {
+        int numLanes = 0;
+        for (int v = 0; v < maxVoices; ++v) {
+            if (voices[v]->isActive()) {
+                numLanes = v + 1;
+            }
         }
-        float* channelData0 = buffer.getWritePointer(0);
-        float* channelData1 = buffer.getWritePointer(1);
-        for (int sample = 0; sample < buffer.getNumSamples(); ++sample) {
-            auto nextSample = modulationMatrix.process();
-            channelData0[sample] = nextSample;
-            channelData1[sample] = nextSample;
+
+        if (controlRemaining == 0) {
+            // Давление и тембр нот попадают в модуляцию с контрольной частотой
+            for (int v = 0; v < numLanes; ++v) {
+                NoteExpression& expression = voices[v]->getExpression();
+                modulation.setPolyPressure(v, expression.getPressure());
+                modulation.setTimbre(v, expression.getTimbre());
+            }
+            modulation.process(controlRate, numLanes);
+            if (blockNoteCache && isVoiceModulated()) {
+                for (int v = 0; v < numLanes; ++v) {
+                    noteCache.goLive(noteTracks[v], *voices[v]);
+                }
+            }
+            if (numLanes > 0) {
+                applyVoiceModulation(controlRate, numLanes);
+            }
+            controlRemaining = controlRate;
         }
-        for (auto& effect : fxList.effects) {
-            if (effect.isActive) {
-                effect.processBlock(buffer);
+
+        numSamples = std::min({ controlRemaining, endSample - blockStart, static_cast<int>(VoiceFilterBank::blockSize) });
+        controlRemaining -= numSamples;
+        if (numLanes == 0) {
+            continue;
+        }
+
+        batchStart = blockStart;
+        batchSamples = numSamples;
+        batchLanes = numLanes;
+        int numBatches = (numLanes + batchSize - 1) / batchSize;
+        renderPool->run(&renderBatchTask, this, numBatches);
+        if (blockNoteCache) {
+            for (int v = 0; v < numLanes; ++v) {
+                noteCache.commit(noteTracks[v]);
+            }
+        }
+
+        for (int i = 0; i < numSamples; ++i) {
+            float nextSample = 0.0f;
+            float drySample = 0.0f;
+            for (int batch = 0; batch < numBatches; ++batch) {
+                nextSample += batchSends[batch * VoiceFilterBank::blockSize + i];
+                drySample += batchDry[batch * VoiceFilterBank::blockSize + i];
+            }
+            channelData0[blockStart + i] = nextSample;
+            channelData1[blockStart + i] = nextSample;
+            if (blockMultitimbral) {
+                dryMix[blockStart + i] = drySample;
+            }
+        }
+
+        // Партии со своей шиной пишутся туда мимо эффектов
+        for (int v = 0; v < numLanes; ++v) {
+            if (float* output = laneOutputs[v]) {
+                for (int i = 0; i < numSamples; ++i) {
+                    output[blockStart + i] += voiceSamples[i * maxVoices + v];
+                }
+            }
+        }
+    }
+}
+
+
+
+void SynthFMAudioProcessor::renderBatchTask(void* context, int batch) {
+    static_cast<SynthFMAudioProcessor*>(context)->renderBatch(batch);
+}
+
+void SynthFMAudioProcessor::renderBatch(int batch) {
+    int firstLane = batch * batchSize;
+    int lastLane = std::min(firstLane + batchSize, batchLanes);
+    for (int v = firstLane; v < lastLane; ++v) {
+        if (voices[v]->isActive()) {
+            noteCache.render(noteTracks[v], *voices[v], voiceSamples.data() + v, voiceEnvelopes.data() + v, maxVoices, batchStart, batchSamples);
+        }
+        else {
+            for (int i = 0; i < batchSamples; ++i) {
+                voiceSamples[i * maxVoices + v] = 0.0f;
+                voiceEnvelopes[i * maxVoices + v] = 0.0f;
+            }
+        }
+    }
+
+    filterBank.process(voiceSamples.data(), voiceEnvelopes.data(), batchSamples, firstLane, lastLane);
+
+    const float* sendGains = laneSends.data();
+    const float* dryGains = laneDry.data();
+    float* sends = batchSends.data() + batch * VoiceFilterBank::blockSize;
+    float* dry = batchDry.data() + batch * VoiceFilterBank::blockSize;
+    for (int i = 0; i < batchSamples; ++i) {
+        const float* lanes = voiceSamples.data() + i * maxVoices;
+        float sendSample = 0.0f;
+        float drySample = 0.0f;
+        for (int v = firstLane; v < lastLane; ++v) {
+            sendSample += lanes[v] * sendGains[v];
+            drySample += lanes[v] * dryGains[v];
+        }
+        sends[i] = sendSample;
+        dry[i] = drySample;
+    }
+}
+
+void SynthFMAudioProcessor::applyVoiceModulation(int numSamples, int numLanes) {
+    for (int destination = 0; destination < ModulationEngine::EffectParameter; ++destination) {
+        bool isUsed = modulation.isUsed(destination);
+        if (!isUsed && !modulationApplied[destination]) {
+            continue;
+        }
+        modulationApplied[destination] = isUsed;
+
+        const float* values = modulation.getValues(destination);
+        for (int v = 0; v < numLanes; ++v) {
+            if (voices[v]->isActive()) {
+                // Уровень плавно идёт к новому значению за блок; снятый маршрут сбрасывается сразу
+                applyVoiceDestination(v, destination, values[v], isUsed ? numSamples : 0);
             }
         }
     }
 }
 
+void SynthFMAudioProcessor::applyVoiceDestination(int v, int destination, float value, int numSamples) {
+    Voice& voice = *voices[v];
+    if (destination < ModulationEngine::OperatorLevel) {
+        voice.getOperator(destination - ModulationEngine::OperatorPitch).setPitchModulation(value);
+    }
+    else if (destination < ModulationEngine::ModulationDepth) {
+        voice.getMatrix().setLevelModulation(destination - ModulationEngine::OperatorLevel, value, numSamples);
+    }
+    else if (destination < ModulationEngine::FilterCutoff) {
+        int connection = destination - ModulationEngine::ModulationDepth;
+        voice.getMatrix().setDepthModulation(connection / Voice::numOperators, connection % Voice::numOperators, 1.0f + value);
+    }
+    else {
+        filterBank.setCutoffModulation(v, value);
+    }
+}
+
+void SynthFMAudioProcessor::applyEffectModulation() {
+    int numSlots = std::min(static_cast<int>(fxList.effects.size()), static_cast<int>(Patch::maxEffects));
+    for (int slot = 0; slot < numSlots; ++slot) {
+        const auto& parameters = fxList.effects[slot].parameters;
+        for (int parameter = 0; parameter < 2 && parameter < static_cast<int>(parameters.size()); ++parameter) {
+            int destination = ModulationEngine::EffectParameter + slot * 2 + parameter;
+            bool isUsed = modulation.isUsed(destination);
+            if (!isUsed && !modulationApplied[destination]) {
+                continue;
+            }
+            modulationApplied[destination] = isUsed;
 
+            float base = std::next(parameters.begin(), parameter)->second;
+            float offset = isUsed ? modulation.getGlobalValue(destination) : 0.0f;
+            fxList.modulateEffect(slot, parameter, juce::jlimit(FxBlock::minValue, FxBlock::maxValue, base + offset));
+        }
+    }
+}
 
 //==============================================================================
 bool SynthFMAudioProcessor::hasEditor() const
@@ -181,65 +1003,452 @@ juce::AudioProcessorEditor* SynthFMAudioProcessor::createEditor()
 //==============================================================================
 void SynthFMAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+    Patch state = patch;
+    storeEffects(state);
+    state.writeTo(destData);
+
+    // Партии дописываются за основным патчем - прежние версии читают только его
+    juce::MemoryOutputStream stream(destData, true);
+    stream.writeInt(partsMagic);
+    stream.writeBool(multitimbral.load());
+    for (auto& send : partSends) {
+        stream.writeFloat(send.load());
+    }
+    for (int part = 1; part < numParts; ++part) {
+        juce::MemoryBlock partData;
+        partPatches[part].writeTo(partData);
+        stream.writeInt(static_cast<int>(partData.getSize()));
+        stream.write(partData.getData(), partData.getSize());
+    }
 }
 
 void SynthFMAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    // Сначала всё разбирается, потом применяется одним куском, пока обработка остановлена
+    auto restored = std::make_unique<std::array<Patch, numParts>>();
+    std::array<bool, numParts> hasPart{};
+    int patchSize = 0;
+    if (!(*restored)[0].readFrom(data, sizeInBytes, &patchSize)) {
+        return;
+    }
+    hasPart[0] = true;
+
+    bool restoredMultitimbral = multitimbral.load();
+    std::array<float, numParts> restoredSends{};
+    bool hasParts = false;
+    juce::MemoryInputStream stream(static_cast<const char*>(data) + patchSize, static_cast<size_t>(sizeInBytes - patchSize), false);
+    if (stream.getNumBytesRemaining() >= 4 && stream.readInt() == partsMagic) {
+        hasParts = true;
+        restoredMultitimbral = stream.readBool();
+        for (auto& send : restoredSends) {
+            send = juce::jlimit(0.0f, 1.0f, stream.readFloat());
+        }
+        for (int part = 1; part < numParts; ++part) {
+            int size = stream.readInt();
+            if (size <= 0 || size > stream.getNumBytesRemaining()) {
+                break;
+            }
+            juce::MemoryBlock partData;
+            stream.readIntoMemoryBlock(partData, size);
+            hasPart[part] = (*restored)[part].readFrom(partData.getData(), size);
+        }
+    }
+
+    // suspendProcessing дожидается текущего processBlock и не пускает следующие,
+    // конвейер эффектов доделывает свой блок - после этого патчи, эффекты и модуляцию
+    // можно менять с этого потока
+    suspendProcessing(true);
+    fxPipeline.waitUntilIdle();
+    // Состояние хоста важнее программ и правок модуляции, заказанных до него
+    for (auto& slot : programSlots) {
+        slot.requested.store(-1);
+        int readyState = Ready;
+        slot.state.compare_exchange_strong(readyState, Free);
+    }
+    int readyModulation = Ready;
+    modulationSlot.state.compare_exchange_strong(readyModulation, Free);
+    if (hasParts) {
+        multitimbral.store(restoredMultitimbral);
+        for (int part = 0; part < numParts; ++part) {
+            partSends[part].store(restoredSends[part]);
+        }
+    }
+    for (int part = 0; part < numParts; ++part) {
+        if (hasPart[part]) {
+            applyPartPatch(part, (*restored)[part]);
+        }
+    }
+    suspendProcessing(false);
+    sendChangeMessage();
+}
+
+void SynthFMAudioProcessor::applyPartPatch(int part, const Patch& partPatch) {
+    if (part == 0) {
+        applyPatch(partPatch);
+        return;
+    }
+    // У остальных партий из патча берутся только голосовые параметры, эффекты и модуляция общие
+    partPatches[part] = partPatch;
+    forEachPartVoice(part, [&](Voice& voice) { voice.setParameters(partPatch.parameters); });
+    updatePartFilters(part);
+}
+
+void SynthFMAudioProcessor::applyFilterSettings(int voice) {
+    const PatchParameters& parameters = partPatches[voices[voice]->getPart()].parameters;
+    filterBank.setSettings(voice, static_cast<VoiceFilterBank::Mode>(juce::roundToInt(parameters.filterMode)),
+        parameters.filterCutoff, parameters.filterResonance, parameters.filterEnvelopeAmount);
+}
+
+void SynthFMAudioProcessor::updatePartFilters(int part) {
+    for (int v = 0; v < maxVoices; ++v) {
+        if (voices[v]->getPart() == part) {
+            applyFilterSettings(v);
+        }
+    }
+}
+
+const Patch& SynthFMAudioProcessor::getPatch() const {
+    return patch;
+}
+
+void SynthFMAudioProcessor::applyPatch(const Patch& newPatch) {
+    const PatchParameters& parameters = newPatch.parameters;
+    for (int i = 0; i < Voice::numOperators; ++i) {
+        const OperatorParameters& op = parameters.operators[i];
+        setOscillatorWaveType(i, static_cast<Oscillator::WaveType>(juce::roundToInt(op.waveType)));
+        setOscillatorLevel(i, op.level);
+        setOscillatorOctave(i, juce::roundToInt(op.octave));
+        setOscillatorDetune(i, op.detune);
+        // Скорости спада и затухания ADSR считаются от sustain, поэтому он первый
+        setOscillatorSustain(i, op.sustain);
+        setOscillatorAttack(i, op.attack);
+        setOscillatorDecay(i, op.decay);
+        setOscillatorRelease(i, op.release);
+    }
+
+    // Циклы матрица принимает, так что связи можно ставить в любом порядке
+    for (int modulator = 0; modulator < Voice::numOperators; ++modulator) {
+        for (int carrier = 0; carrier < Voice::numOperators; ++carrier) {
+            float depth = parameters.modulationDepths[modulator][carrier];
+            patch.parameters.modulationDepths[modulator][carrier] = depth;
+            bool isEnabled = parameters.modulationEnabled[modulator][carrier] > 0.5f;
+            setModulationDepth(modulator, carrier, isEnabled ? depth : -1.0f);
+        }
+    }
+    setLevel(parameters.level);
+
+    setFilterMode(static_cast<VoiceFilterBank::Mode>(juce::roundToInt(parameters.filterMode)));
+    setFilterCutoff(parameters.filterCutoff);
+    setFilterResonance(parameters.filterResonance);
+    setFilterEnvelopeAmount(parameters.filterEnvelopeAmount);
+    setFilterSustain(parameters.filterSustain);
+    setFilterAttack(parameters.filterAttack);
+    setFilterDecay(parameters.filterDecay);
+    setFilterRelease(parameters.filterRelease);
+
+    applyEffects(newPatch);
+
+    patch.modulation = newPatch.modulation;
+    modulation.setSettings(patch.modulation);
+}
+
+void SynthFMAudioProcessor::storeEffects(Patch& destPatch) const {
+    destPatch.numEffects = std::min(static_cast<int>(fxList.effects.size()), static_cast<int>(Patch::maxEffects));
+    for (int i = 0; i < destPatch.numEffects; ++i) {
+        const FxBlock& block = fxList.effects[i];
+        EffectSlot& slot = destPatch.effects[i];
+        std::memset(&slot, 0, sizeof(EffectSlot));
+        block.name.copy(slot.name, EffectSlot::maxNameLength - 1);
+        slot.isActive = block.isActive ? 1 : 0;
+        int index = 0;
+        for (const auto& parameter : block.parameters) {
+            if (index < 2) {
+                slot.parameters[index++] = parameter.second;
+            }
+        }
+    }
+}
+
+void SynthFMAudioProcessor::applyEffects(const Patch& sourcePatch) {
+    auto& effects = fxList.effects;
+    int position = 0;
+    for (int i = 0; i < sourcePatch.numEffects; ++i) {
+        const EffectSlot& slot = sourcePatch.effects[i];
+        // Блок с таким именем переставляется на своё место в цепочке
+        for (int j = position; j < static_cast<int>(effects.size()); ++j) {
+            if (effects[j].name == slot.name) {
+                std::swap(effects[j], effects[position]);
+                effects[position].isActive = slot.isActive != 0;
+                // Сеттеры эффекта трогаем только при реальном изменении параметра:
+                // смена программы приходит на аудиопоток, а часть эффектов перестраивается
+                auto& parameters = effects[position].parameters;
+                if (parameters.size() > 0 && parameters.begin()->second != slot.parameters[0]) {
+                    fxList.setEffect1(position, slot.parameters[0]);
+                }
+                if (parameters.size() > 1 && std::next(parameters.begin())->second != slot.parameters[1]) {
+                    fxList.setEffect2(position, slot.parameters[1]);
+                }
+                ++position;
+                break;
+            }
+        }
+    }
 }
 
-Oscillator* SynthFMAudioProcessor::getOscillator(int index) {
-    return oscillators[index];
+void SynthFMAudioProcessor::setOscillatorWaveType(int index, Oscillator::WaveType type) {
+    patch.parameters.operators[index].waveType = static_cast<float>(type);
+    forEachPartVoice(0, [&](Voice& voice) { voice.getOperator(index).setWaveType(type); });
 }
 
 bool SynthFMAudioProcessor::setModulationDepth(int carrierIdx, int modulatorIdx, float modulationDepth) {
-    if (modulationDepth < 0.00) {
-        return modulationMatrix.removeModulation(carrierIdx, modulatorIdx);
-    } else {
-        return modulationMatrix.setModulation(carrierIdx, modulatorIdx, modulationDepth);
+    bool result = true;
+    forEachPartVoice(0, [&](Voice& voice) {
+        if (modulationDepth < 0.00) {
+            result = voice.getMatrix().removeModulation(carrierIdx, modulatorIdx);
+        } else {
+            result = voice.getMatrix().setModulation(carrierIdx, modulatorIdx, modulationDepth);
+        }
+    });
+    if (modulationDepth >= 0.00) {
+        patch.parameters.modulationDepths[carrierIdx][modulatorIdx] = modulationDepth;
     }
+    patch.parameters.modulationEnabled[carrierIdx][modulatorIdx] = (modulationDepth >= 0.00 && result) ? 1.0f : 0.0f;
+    return result;
 }
 
 void SynthFMAudioProcessor::setOscillatorLevel(int index, float level) {
-    oscillators[index]->setLevel(level);
+    patch.parameters.operators[index].level = level;
+    forEachPartVoice(0, [&](Voice& voice) { voice.getOperator(index).setLevel(level); });
 }
 
 void SynthFMAudioProcessor::setLevel(float level) {
-    modulationMatrix.setLevel(level);
+    patch.parameters.level = level;
+    forEachPartVoice(0, [&](Voice& voice) { voice.getMatrix().setLevel(level); });
 }
 
 void SynthFMAudioProcessor::setOscillatorOctave(int index, int octave) {
-    if (index >= 0 && index < oscillators.size()) {
-        oscillators[index]->setOctave(octave);
-        // Äîïîëíèòåëüíûå äåéñòâèÿ ïîñëå èçìåíåíèÿ îêòàâû, åñëè íåîáõîäèìî
+    if (index >= 0 && index < Voice::numOperators) {
+        patch.parameters.operators[index].octave = static_cast<float>(octave);
+        forEachPartVoice(0, [&](Voice& voice) { voice.getOperator(index).setOctave(octave); });
     }
 }
 
 void SynthFMAudioProcessor::setOscillatorDetune(int index, float detune) {
-    if (index >= 0 && index < oscillators.size()) {
-        oscillators[index]->setDetune(detune);
-        // Äîïîëíèòåëüíûå äåéñòâèÿ ïîñëå èçìåíåíèÿ äåòþíà, åñëè íåîáõîäèìî
+    if (index >= 0 && index < Voice::numOperators) {
+        patch.parameters.operators[index].detune = detune;
+        forEachPartVoice(0, [&](Voice& voice) { voice.getOperator(index).setDetune(detune); });
     }
 }
 
 void SynthFMAudioProcessor::setOscillatorAttack(int index, float time) {
-    oscillators[index]->setAttackTime(time);
+    patch.parameters.operators[index].attack = time;
+    forEachPartVoice(0, [&](Voice& voice) { voice.getOperator(index).setAttackTime(time); });
 }
 
 void SynthFMAudioProcessor::setOscillatorDecay(int index, float time) {
-    oscillators[index]->setDecayTime(time);
+    patch.parameters.operators[index].decay = time;
+    forEachPartVoice(0, [&](Voice& voice) { voice.getOperator(index).setDecayTime(time); });
 }
 
 void SynthFMAudioProcessor::setOscillatorSustain(int index, float level) {
-    oscillators[index]->setSustainLevel(level);
+    patch.parameters.operators[index].sustain = level;
+    forEachPartVoice(0, [&](Voice& voice) { voice.getOperator(index).setSustainLevel(level); });
 }
 
 void SynthFMAudioProcessor::setOscillatorRelease(int index, float time) {
-    oscillators[index]->setReleaseTime(time);
+    patch.parameters.operators[index].release = time;
+    forEachPartVoice(0, [&](Voice& voice) { voice.getOperator(index).setReleaseTime(time); });
+}
+
+void SynthFMAudioProcessor::setFilterMode(VoiceFilterBank::Mode mode) {
+    patch.parameters.filterMode = static_cast<float>(mode);
+    updatePartFilters(0);
+}
+
+void SynthFMAudioProcessor::setFilterCutoff(float frequency) {
+    patch.parameters.filterCutoff = frequency;
+    updatePartFilters(0);
+}
+
+void SynthFMAudioProcessor::setFilterResonance(float resonance) {
+    patch.parameters.filterResonance = resonance;
+    updatePartFilters(0);
+}
+
+void SynthFMAudioProcessor::setFilterEnvelopeAmount(float octaves) {
+    patch.parameters.filterEnvelopeAmount = octaves;
+    updatePartFilters(0);
+}
+
+void SynthFMAudioProcessor::setFilterAttack(float time) {
+    patch.parameters.filterAttack = time;
+    forEachPartVoice(0, [&](Voice& voice) { voice.getFilterEnvelope().setAttackTime(time); });
+}
+
+void SynthFMAudioProcessor::setFilterDecay(float time) {
+    patch.parameters.filterDecay = time;
+    forEachPartVoice(0, [&](Voice& voice) { voice.getFilterEnvelope().setDecayTime(time); });
+}
+
+void SynthFMAudioProcessor::setFilterSustain(float level) {
+    patch.parameters.filterSustain = level;
+    forEachPartVoice(0, [&](Voice& voice) { voice.getFilterEnvelope().setSustainLevel(level); });
+}
+
+void SynthFMAudioProcessor::setFilterRelease(float time) {
+    patch.parameters.filterRelease = time;
+    forEachPartVoice(0, [&](Voice& voice) { voice.getFilterEnvelope().setReleaseTime(time); });
+}
+
+void SynthFMAudioProcessor::setLfo(int index, int shape, float rate, bool retrigger) {
+    if (index >= 0 && index < ModulationSettings::numLfos) {
+        LfoSettings& lfo = patch.modulation.lfos[index];
+        lfo.shape = static_cast<float>(shape);
+        lfo.rate = rate;
+        lfo.retrigger = retrigger ? 1.0f : 0.0f;
+        postModulationSettings();
+    }
+}
+
+void SynthFMAudioProcessor::setModulationEnvelope(int index, float attack, float decay, float sustain, float release) {
+    if (index >= 0 && index < ModulationSettings::numEnvelopes) {
+        patch.modulation.envelopes[index] = { attack, decay, sustain, release };
+        postModulationSettings();
+    }
+}
+
+void SynthFMAudioProcessor::setModulationRoute(int index, int source, int destination, float amount) {
+    if (index >= 0 && index < ModulationSettings::maxRoutes) {
+        patch.modulation.routes[index] = { source, destination, amount };
+        postModulationSettings();
+    }
+}
+
+void SynthFMAudioProcessor::postModulationSettings() {
+    // Маршруты перестраивает аудиопоток в начале блока; пока он читает слот, ждём
+    for (;;) {
+        int state = modulationSlot.state.load();
+        if (state != Reading && modulationSlot.state.compare_exchange_weak(state, Writing)) {
+            break;
+        }
+        juce::Thread::yield();
+    }
+    modulationSlot.settings = patch.modulation;
+    modulationSlot.state.store(Ready);
+}
+
+void SynthFMAudioProcessor::setControlRate(int numSamples) {
+    userControlRate.store(juce::jlimit(1, static_cast<int>(VoiceFilterBank::blockSize), numSamples));
+}
+
+int SynthFMAudioProcessor::getControlRate() {
+    return userControlRate.load();
+}
+
+void SynthFMAudioProcessor::setMpeEnabled(bool enabled) {
+    mpeEnabled.store(enabled);
+}
+
+bool SynthFMAudioProcessor::isMpeEnabled() {
+    return mpeEnabled.load();
+}
+
+void SynthFMAudioProcessor::setMultitimbral(bool enabled) {
+    multitimbral.store(enabled);
+}
+
+bool SynthFMAudioProcessor::isMultitimbral() {
+    return multitimbral.load();
+}
+
+void SynthFMAudioProcessor::setPartProgram(int part, int program) {
+    if (part < 0 || part >= numParts || program < 0) {
+        return;
+    }
+    programSlots[part].requested.store(program);
+    // С потока сообщений (хост, браузер пресетов) патч читается сразу, с аудиопотока - по таймеру
+    if (juce::MessageManager::existsAndIsCurrentThread()) {
+        loadRequestedPrograms();
+    }
+}
+
+void SynthFMAudioProcessor::setPartSend(int part, float send) {
+    if (part >= 0 && part < numParts) {
+        partSends[part].store(juce::jlimit(0.0f, 1.0f, send));
+    }
+}
+
+float SynthFMAudioProcessor::getPartSend(int part) {
+    return part >= 0 && part < numParts ? partSends[part].load() : 0.0f;
+}
+
+void SynthFMAudioProcessor::setRenderThreads(int numThreads) {
+    // Потоки создаются здесь, на потоке сообщений; аудиопоток только подменяет указатель
+    numThreads = juce::jlimit(1, static_cast<int>(RenderPool::maxWorkers), numThreads);
+    renderThreads.store(numThreads);
+    delete pendingPool.exchange(new RenderPool(numThreads));
+}
+
+int SynthFMAudioProcessor::getRenderThreads() {
+    return renderThreads.load();
+}
+
+size_t SynthFMAudioProcessor::getDspMemoryUsage() {
+    return dspArena.getCapacity();
+}
+
+void SynthFMAudioProcessor::setFxPipelined(bool enabled) {
+    // Поток запускается здесь; аудиопоток переключается на конвейер, когда увидит его запущенным
+    if (enabled) {
+        fxPipeline.start(maxBlockSize, currentSampleRate);
+    }
+    fxPipelined.store(enabled);
+    updateLatency();
+}
+
+bool SynthFMAudioProcessor::isFxPipelined() {
+    return fxPipelined.load();
+}
+
+void SynthFMAudioProcessor::setNoteCacheEnabled(bool enabled) {
+    noteCacheEnabled.store(enabled);
+}
+
+bool SynthFMAudioProcessor::isNoteCacheEnabled() {
+    return noteCacheEnabled.load();
+}
+
+bool SynthFMAudioProcessor::waitUntilEffectsReady(int timeoutMs) {
+    auto isReady = [this] {
+        return std::all_of(fxList.effects.begin(), fxList.effects.end(), [](FxBlock& effect) { return effect.isReady(); });
+    };
+    for (int waited = 0; !isReady(); ++waited) {
+        if (waited >= timeoutMs) {
+            return false;
+        }
+        juce::Thread::sleep(1);
+    }
+    return true;
+}
+
+void SynthFMAudioProcessor::setQualityGovernorEnabled(bool enabled) {
+    governorEnabled.store(enabled);
+}
+
+bool SynthFMAudioProcessor::isQualityGovernorEnabled() {
+    return governorEnabled.load();
+}
+
+QualityGovernor::Tier SynthFMAudioProcessor::getQualityTier() {
+    return static_cast<QualityGovernor::Tier>(qualityTier.load());
+}
+
+float SynthFMAudioProcessor::getCpuLoad() {
+    return cpuLoad.load();
+}
+
+void SynthFMAudioProcessor::updateLatency() {
+    setLatencySamples(fxPipelined.load() ? fxPipeline.getLatency() : 0);
 }
 
 //==============================================================================
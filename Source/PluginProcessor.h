@@ -4,12 +4,29 @@
 #include "Oscillator.h"
 #include "ModulationMatrix.h"
 #include "FxBlock.h"
+#include "Voice.h"
+#include "VoiceFilter.h"
+#include "Patch.h"
+#include "PresetBank.h"
+#include "PatchMorph.h"
+#include "AudioTap.h"
+#include "ModulationEngine.h"
+#include "RenderPool.h"
+#include "FxPipeline.h"
+#include "DspArena.h"
+#include "NoteCache.h"
+#include "QualityGovernor.h"
+#include <array>
+#include <atomic>
 
-class SynthFMAudioProcessor : public juce::AudioProcessor {
+class SynthFMAudioProcessor : public juce::AudioProcessor, public juce::ChangeBroadcaster, private juce::Timer {
 public:
     SynthFMAudioProcessor();
     ~SynthFMAudioProcessor() override;
 
+    static constexpr int maxVoices = VoiceFilterBank::maxVoices;
+    static constexpr int numParts = 16;
+
     void prepareToPlay(double sampleRate, int samplesPerBlock) override;
     void releaseResources() override;
 
@@ -33,8 +50,22 @@ public:
 
     void getStateInformation(juce::MemoryBlock& destData) override;
     void setStateInformation(const void* data, int sizeInBytes) override;
-    Oscillator* getOscillator(int index);
 
+    const Patch& getPatch() const;
+    void applyPatch(const Patch& newPatch);
+
+    PresetBank& getPresetBank();
+    bool loadPresetBank(const juce::File& file);
+    bool installPresetBank(const juce::File& newBankFile);
+    static juce::File getDefaultPresetBankFile();
+
+    void addMorphSnapshot();
+    void clearMorphSnapshots();
+    int getNumMorphSnapshots();
+    void setMorphPosition(float position);
+    void setMorphController(int controllerNumber);
+
+    void setOscillatorWaveType(int index, Oscillator::WaveType type);
     bool setModulationDepth(int carrierIdx, int modulatorIdx, float modulationDepth);
     void setOscillatorLevel(int index, float level);
     void setLevel(float level);
@@ -45,15 +76,232 @@ public:
     void setOscillatorSustain(int index, float level);
     void setOscillatorRelease(int index, float time);
 
+    void setFilterMode(VoiceFilterBank::Mode mode);
+    void setFilterCutoff(float frequency);
+    void setFilterResonance(float resonance);
+    void setFilterEnvelopeAmount(float octaves);
+    void setFilterAttack(float time);
+    void setFilterDecay(float time);
+    void setFilterSustain(float level);
+    void setFilterRelease(float time);
+
+    void setLfo(int index, int shape, float rate, bool retrigger);
+    void setModulationEnvelope(int index, float attack, float decay, float sustain, float release);
+    void setModulationRoute(int index, int source, int destination, float amount);
+    void setControlRate(int numSamples);
+    int getControlRate();
+    void setMpeEnabled(bool enabled);
+    bool isMpeEnabled();
+
+    // Мультитембральный режим: на каждом MIDI-канале своя партия со своим патчем и посылом
+    // в общую цепочку эффектов, голоса берутся из общего пула. Редактор правит первую партию.
+    void setMultitimbral(bool enabled);
+    bool isMultitimbral();
+    void setPartProgram(int part, int program);
+    void setPartSend(int part, float send);
+    float getPartSend(int part);
+
+    // Параллельный рендер голосов: 1 - всё в потоке хоста. Результат от числа потоков не зависит.
+    void setRenderThreads(int numThreads);
+    int getRenderThreads();
+
+    // Сколько байт занимает состояние голосов и линии задержки эффектов
+    size_t getDspMemoryUsage();
+
+    // Эффекты на отдельном потоке параллельно с рендером следующего блока, ценой задержки в блок
+    void setFxPipelined(bool enabled);
+    bool isFxPipelined();
+
+    // Кэш начала нот: повторные ноты без модуляции голоса берутся из памяти. Действует только
+    // при офлайн-рендере, в реальном времени флаг запоминается, но кэш молчит.
+    void setNoteCacheEnabled(bool enabled);
+    bool isNoteCacheEnabled();
+
+    // Для офлайн-рендера после prepareToPlay: ждёт, пока Convolution построит ИХ в фоне.
+    // false - не дождались за timeoutMs.
+    bool waitUntilEffectsReady(int timeoutMs);
+
+    // Автоматическое снижение качества, когда блок не укладывается во время реального
+    // времени; уровень и загрузка читаются с любого потока
+    void setQualityGovernorEnabled(bool enabled);
+    bool isQualityGovernorEnabled();
+    QualityGovernor::Tier getQualityTier();
+    float getCpuLoad();
+
     juce::MidiKeyboardState keyboardState;
     FxList fxList;
+    AudioTap visualTap;
+
 private:
-    bool noteCurrentlyOn = false;
-    double currentFrequency = 0.0;
     double currentSampleRate = 48000.0;
+    int maxBlockSize = 512;      // под него выделены буферы в prepareToPlay
+    int controlRemaining = 0;    // сколько осталось до границы контрольного блока
+    juce::uint64 noteCounter = 0;
+
+    // Патчи партий по MIDI-каналам; первая партия - основной патч, его правят сеттеры
+    std::array<Patch, numParts> partPatches;
+    Patch& patch = partPatches[0];
+
+    // Смена программы: банк читается только на потоке сообщений (таймером) в слот партии,
+    // аудиопоток забирает готовый патч в начале блока без блокировок. Сам банк аудиопоток
+    // не трогает - открытие и закрытие идут на том же потоке сообщений.
+    enum ProgramPatchState { Free, Writing, Ready, Reading };
+    struct ProgramSlot {
+        Patch patch;
+        std::atomic<int> state{ Free };
+        std::atomic<int> requested{ -1 };
+    };
+    PresetBank presetBank;
+    std::array<ProgramSlot, numParts> programSlots;
+    // Настройки модуляции из сеттеров передаются аудиопотоку так же, через слот
+    struct ModulationSlot {
+        ModulationSettings settings;
+        std::atomic<int> state{ Free };
+    };
+    ModulationSlot modulationSlot;
+    std::atomic<int> currentProgram{ 0 };
+    // Аудиопоток не шлёт сообщений: флаг подхватывает таймер и рассылает изменение
+    std::atomic<bool> patchChanged{ false };
+
+    // Сигнал партии делится между цепочкой эффектов и сухим выходом, а при включённой
+    // шине партии целиком уходит на неё. Коэффициенты дорожек ставятся перед рендером.
+    std::atomic<bool> multitimbral{ false };
+    bool blockMultitimbral = false;   // режим, зафиксированный на текущий блок
+    std::array<std::atomic<float>, numParts> partSends;
+    std::array<float*, numParts> partOutputs{};
+    std::array<float*, maxVoices> laneOutputs{};
+    std::array<float, maxVoices> laneSends{};
+    std::array<float, maxVoices> laneDry{};
+    std::vector<float> dryMix;
+
+    // Морфинг: таблица собирается на потоке сообщений и передаётся через pending,
+    // старая возвращается через retired и удаляется таймером
+    std::vector<Patch> morphSnapshots;
+    std::unique_ptr<MorphTable> morphTable;
+    std::atomic<MorphTable*> pendingMorph{ nullptr };
+    std::atomic<MorphTable*> retiredMorph{ nullptr };
+    std::atomic<float> morphTarget{ 0.0f };
+    std::atomic<int> morphController{ 1 };
+    float morphPosition = 0.0f;
+    float appliedMorphPosition = -1.0f;
+    std::vector<float> morphValues;
+    std::vector<float> appliedMorphValues;
+
+    // Голоса с операторами, таблица высот и линии задержки эффектов лежат в одной арене, она
+    // перестраивается в prepareToPlay; голоса при этом создаются заново
+    // Таблицы форм волны общие на процесс, голоса получают на них указатель
+    juce::SharedResourcePointer<SharedTables> sharedTables;
+    DspArena dspArena;
+    PitchTable pitchTable;
+    std::array<Voice*, maxVoices> voices{};
+    VoiceFilterBank filterBank;
+    alignas(64) std::array<float, VoiceFilterBank::blockSize * maxVoices> voiceSamples{};
+    alignas(64) std::array<float, VoiceFilterBank::blockSize * maxVoices> voiceEnvelopes{};
+
+    // Голоса рендерятся пачками по строке кэша; у каждой пачки свой буфер суммы, и пачки
+    // складываются в одном порядке, так что звук не зависит от того, какой поток что взял.
+    // Новый пул передаётся как таблица морфинга: через pending и retired.
+    static constexpr int batchSize = 16;
+    static constexpr int maxBatches = maxVoices / batchSize;
+    std::unique_ptr<RenderPool> renderPool;
+    std::atomic<RenderPool*> pendingPool{ nullptr };
+    std::atomic<RenderPool*> retiredPool{ nullptr };
+    std::atomic<int> renderThreads{ 1 };
+    alignas(64) std::array<float, maxBatches * VoiceFilterBank::blockSize> batchSends{};
+    alignas(64) std::array<float, maxBatches * VoiceFilterBank::blockSize> batchDry{};
+    int batchStart = 0;
+    int batchSamples = 0;
+    int batchLanes = 0;
+
+    // Конвейер эффектов; пока он считает блок, цепочку трогать нельзя - перед сменой
+    // патча и модуляцией эффектов аудиопоток ждёт его
+    FxPipeline fxPipeline;
+    std::atomic<bool> fxPipelined{ false };
+    bool blockPipelined = false;
+
+    // Дорожки кэша нот по голосам; хэши патчей партий ловят их правку между блоками
+    NoteCache noteCache;
+    std::array<NoteCache::Track, maxVoices> noteTracks;
+    std::array<std::uint64_t, numParts> partHashes{};
+    std::atomic<bool> noteCacheEnabled{ false };
+    bool blockNoteCache = false;
+
+    // Уровень качества меняется только между блоками хоста. Контрольная частота из
+    // настроек хранится отдельно: под нагрузкой движок модуляции получает её кратную.
+    QualityGovernor governor;
+    std::atomic<bool> governorEnabled{ true };
+    std::atomic<int> qualityTier{ QualityGovernor::Full };
+    std::atomic<float> cpuLoad{ 0.0f };
+    std::atomic<int> userControlRate{ VoiceFilterBank::blockSize };
+    int voiceLimit = maxVoices;
+    bool draftWaveforms = false;
+    bool reducedEffects = false;
+
+    // applied - назначение ещё держит ненулевое значение и его надо вернуть, когда маршрут уберут
+    ModulationEngine modulation;
+    std::array<bool, ModulationEngine::numDestinations> modulationApplied{};
+
+    // MPE, нижняя зона: канал 1 общий, на каналах 2-16 по своей ноте
+    static constexpr int numMidiChannels = 16;
+    static constexpr float memberBendRange = 48.0f;
+    static constexpr float masterBendRange = 2.0f;
+    std::atomic<bool> mpeEnabled{ false };
+    std::array<float, numMidiChannels> channelBends{};
+    std::array<float, numMidiChannels> channelPressures{};
+    std::array<float, numMidiChannels> channelTimbres{};
+    std::array<int, numMidiChannels> channelVoices{};
+    // Общие изгиб, давление и тембр - свои у каждой партии; без мультитембральности всё в партии 0
+    std::array<float, numParts> partBends{};
+    std::array<float, numParts> partPressures{};
+    std::array<float, numParts> partTimbres{};
+
+    void processChunk(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages, int offset, bool isLastChunk);
+    void buildDspState(double sampleRate);
+    void layoutDspState(double sampleRate);
+    void destroyVoices();
+    void handleMidiEvent(const juce::MidiMessage& message, int samplePosition);
+    bool isExpressionEvent(const juce::MidiMessage& message);
+    bool isMemberChannel(int channel);
+    void pushChannelExpression(int channel, int samplePosition, NoteExpression::Type type, float value);
+    int getChannelPart(int channel);
+    void pushPartExpression(int part, int samplePosition, NoteExpression::Type type, float value);
+    void startVoice(int note, int channel, float pitch, float velocity);
+    void applyPartPatch(int part, const Patch& partPatch);
+    void applyFilterSettings(int voice);
+    void updatePartFilters(int part);
+    void updatePartOutputs(juce::AudioBuffer<float>& buffer);
+    void updateLaneMix(int voice);
+    void updateNoteCache();
+    void applyQualityTier();
+    void applyEffectQuality();
+    bool isVoiceModulated();
+    static BusesProperties createBusesProperties();
 
-    std::vector<Oscillator*> oscillators;
-    ModulationMatrix modulationMatrix;
+    template <typename Function>
+    void forEachPartVoice(int part, Function function) {
+        for (auto& voice : voices) {
+            if (voice->getPart() == part) {
+                function(*voice);
+            }
+        }
+    }
+    void renderVoices(juce::AudioBuffer<float>& buffer, int startSample, int endSample);
+    void renderBatch(int batch);
+    static void renderBatchTask(void* context, int batch);
+    void applyVoiceModulation(int numSamples, int numLanes);
+    void applyVoiceDestination(int v, int destination, float value, int numSamples);
+    void applyEffectModulation();
+    void processEffects(juce::AudioBuffer<float>& buffer);
+    static void processEffectsTask(void* context, juce::AudioBuffer<float>& buffer);
+    void updateLatency();
+    void storeEffects(Patch& destPatch) const;
+    void applyEffects(const Patch& sourcePatch);
+    void timerCallback() override;
+    void loadRequestedPrograms();
+    void postModulationSettings();
+    void rebuildMorphTable();
+    void updateMorph(int numSamples);
+    void applyMorphEffects();
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SynthFMAudioProcessor)
 };
@@ -0,0 +1,299 @@
+/*
+  ==============================================================================
+
+    PresetBank.cpp
+    Created: 20 Oct 2026 4:12:09pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#include "PresetBank.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    constexpr std::uint32_t noCategory = 0xffffffff;
+
+    char foldCase(char c) {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    // Сравнение без учёта регистра только по первым length байтам имени
+    int comparePrefix(const char* name, const char* prefix, size_t length) {
+        for (size_t i = 0; i < length; ++i) {
+            unsigned char a = static_cast<unsigned char>(foldCase(name[i]));
+            unsigned char b = static_cast<unsigned char>(foldCase(prefix[i]));
+            if (a != b) {
+                return a < b ? -1 : 1;
+            }
+            if (a == 0) {
+                return 0;
+            }
+        }
+        return 0;
+    }
+
+    void copyText(char* dest, int destSize, const juce::String& text) {
+        std::memset(dest, 0, destSize);
+        const char* utf8 = text.toRawUTF8();
+        size_t length = std::strlen(utf8);
+        if (length >= static_cast<size_t>(destSize)) {
+            length = destSize - 1;
+            // не режем многобайтовый символ UTF-8 посередине
+            while (length > 0 && (static_cast<unsigned char>(utf8[length]) & 0xc0) == 0x80) {
+                --length;
+            }
+        }
+        std::memcpy(dest, utf8, length);
+    }
+
+    juce::String readText(const char* text, int maxLength) {
+        return juce::String::fromUTF8(text, static_cast<int>(strnlen(text, maxLength)));
+    }
+
+    std::uint64_t alignTo(std::uint64_t offset, std::uint64_t alignment) {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+}
+
+bool PresetBank::open(const juce::File& bankFile) {
+    close();
+
+    auto mapped = std::make_unique<juce::MemoryMappedFile>(bankFile, juce::MemoryMappedFile::readOnly);
+    const char* data = static_cast<const char*>(mapped->getData());
+    std::uint64_t size = mapped->getSize();
+    if (data == nullptr || size < sizeof(Header)) {
+        return false;
+    }
+
+    // Проверяем только заголовок - индекс и патчи подтянутся по страницам при обращении
+    auto* bankHeader = reinterpret_cast<const Header*>(data);
+    std::uint64_t count = bankHeader->numPresets;
+    if (bankHeader->magic != magic || bankHeader->version > version || bankHeader->patchSize == 0
+        || bankHeader->indexOffset % alignof(IndexEntry) != 0 || bankHeader->patchOffset % alignof(Patch) != 0
+        || bankHeader->indexOffset + count * sizeof(IndexEntry) > size
+        || bankHeader->patchOffset + count * bankHeader->patchSize > size) {
+        return false;
+    }
+
+    file = bankFile;
+    mappedFile = std::move(mapped);
+    header = bankHeader;
+    entries = reinterpret_cast<const IndexEntry*>(data + header->indexOffset);
+    patches = data + header->patchOffset;
+    numPresets = static_cast<int>(count);
+    return true;
+}
+
+void PresetBank::close() {
+    header = nullptr;
+    entries = nullptr;
+    patches = nullptr;
+    numPresets = 0;
+    mappedFile.reset();
+    file = juce::File();
+}
+
+bool PresetBank::isOpen() {
+    return header != nullptr;
+}
+
+juce::File PresetBank::getFile() {
+    return file;
+}
+
+int PresetBank::getNumPresets() {
+    return numPresets;
+}
+
+juce::String PresetBank::getName(int index) {
+    if (index < 0 || index >= numPresets) {
+        return {};
+    }
+    return readText(entries[index].name, maxNameLength);
+}
+
+juce::String PresetBank::getCategory(int index) {
+    if (index < 0 || index >= numPresets) {
+        return {};
+    }
+    return getCategoryName(static_cast<int>(entries[index].category));
+}
+
+juce::StringArray PresetBank::getTags(int index) {
+    juce::StringArray tags;
+    if (index < 0 || index >= numPresets) {
+        return tags;
+    }
+    int numTags = std::min(static_cast<int>(header->numTags), maxTags);
+    for (int tag = 0; tag < numTags; ++tag) {
+        if (entries[index].tagMask & (std::uint64_t(1) << tag)) {
+            tags.add(readText(header->tags[tag], maxTagLength));
+        }
+    }
+    return tags;
+}
+
+bool PresetBank::getPatch(int index, Patch& destPatch) {
+    if (index < 0 || index >= numPresets || entries[index].patchIndex >= static_cast<std::uint32_t>(numPresets)) {
+        return false;
+    }
+    destPatch.readPayload(patches + static_cast<std::uint64_t>(entries[index].patchIndex) * header->patchSize, header->patchSize);
+    return true;
+}
+
+void PresetBank::getPresets(std::vector<Preset>& presets) {
+    presets.reserve(presets.size() + numPresets);
+    for (int i = 0; i < numPresets; ++i) {
+        Preset preset;
+        preset.name = getName(i);
+        preset.category = getCategory(i);
+        preset.tags = getTags(i);
+        getPatch(i, preset.patch);
+        presets.push_back(std::move(preset));
+    }
+}
+
+int PresetBank::getNumCategories() {
+    return header != nullptr ? std::min(static_cast<int>(header->numCategories), maxCategories) : 0;
+}
+
+juce::String PresetBank::getCategoryName(int category) {
+    if (category < 0 || category >= getNumCategories()) {
+        return {};
+    }
+    return readText(header->categories[category], maxTagLength);
+}
+
+std::uint64_t PresetBank::findTag(const juce::String& tag) {
+    if (header == nullptr) {
+        return 0;
+    }
+    int numTags = std::min(static_cast<int>(header->numTags), maxTags);
+    for (int i = 0; i < numTags; ++i) {
+        if (tag.equalsIgnoreCase(readText(header->tags[i], maxTagLength))) {
+            return std::uint64_t(1) << i;
+        }
+    }
+    return 0;
+}
+
+int PresetBank::findCategory(const juce::String& category) {
+    for (int i = 0; i < getNumCategories(); ++i) {
+        if (category.equalsIgnoreCase(getCategoryName(i))) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void PresetBank::search(const juce::String& namePrefix, std::uint64_t requiredTags, int category,
+    std::vector<int>& results, int maxResults) {
+    results.clear();
+    if (numPresets == 0) {
+        return;
+    }
+
+    const char* prefix = namePrefix.toRawUTF8();
+    size_t length = std::min(std::strlen(prefix), static_cast<size_t>(maxNameLength));
+
+    const IndexEntry* first = entries;
+    const IndexEntry* last = entries + numPresets;
+    if (length > 0) {
+        first = std::lower_bound(first, last, prefix, [length](const IndexEntry& entry, const char* key) {
+            return comparePrefix(entry.name, key, length) < 0;
+        });
+        last = std::upper_bound(first, last, prefix, [length](const char* key, const IndexEntry& entry) {
+            return comparePrefix(entry.name, key, length) > 0;
+        });
+    }
+
+    for (const IndexEntry* entry = first; entry != last; ++entry) {
+        if ((entry->tagMask & requiredTags) != requiredTags) {
+            continue;
+        }
+        if (category >= 0 && entry->category != static_cast<std::uint32_t>(category)) {
+            continue;
+        }
+        results.push_back(static_cast<int>(entry - entries));
+        if (maxResults >= 0 && static_cast<int>(results.size()) >= maxResults) {
+            break;
+        }
+    }
+}
+
+bool PresetBank::write(const juce::File& bankFile, std::vector<Preset>& presets) {
+    std::vector<IndexEntry> index(presets.size());
+    auto bankHeader = std::make_unique<Header>();
+    std::memset(bankHeader.get(), 0, sizeof(Header));
+    juce::StringArray tagNames;
+    juce::StringArray categoryNames;
+
+    for (size_t i = 0; i < presets.size(); ++i) {
+        IndexEntry& entry = index[i];
+        std::memset(&entry, 0, sizeof(IndexEntry));
+        copyText(entry.name, maxNameLength, presets[i].name);
+        entry.patchIndex = static_cast<std::uint32_t>(i);
+
+        // Теги и категории сверх таблицы не индексируются
+        for (const auto& tag : presets[i].tags) {
+            int tagIndex = tagNames.indexOf(tag, true);
+            if (tagIndex < 0 && tagNames.size() < maxTags) {
+                tagIndex = tagNames.size();
+                tagNames.add(tag);
+            }
+            if (tagIndex >= 0) {
+                entry.tagMask |= std::uint64_t(1) << tagIndex;
+            }
+        }
+
+        int categoryIndex = categoryNames.indexOf(presets[i].category, true);
+        if (categoryIndex < 0 && presets[i].category.isNotEmpty() && categoryNames.size() < maxCategories) {
+            categoryIndex = categoryNames.size();
+            categoryNames.add(presets[i].category);
+        }
+        entry.category = categoryIndex >= 0 ? static_cast<std::uint32_t>(categoryIndex) : noCategory;
+    }
+
+    std::stable_sort(index.begin(), index.end(), [](const IndexEntry& a, const IndexEntry& b) {
+        return comparePrefix(a.name, b.name, maxNameLength) < 0;
+    });
+
+    bankHeader->magic = magic;
+    bankHeader->version = version;
+    bankHeader->numPresets = static_cast<std::uint32_t>(presets.size());
+    bankHeader->patchSize = sizeof(Patch);
+    bankHeader->numTags = static_cast<std::uint32_t>(tagNames.size());
+    bankHeader->numCategories = static_cast<std::uint32_t>(categoryNames.size());
+    bankHeader->indexOffset = alignTo(sizeof(Header), 64);
+    bankHeader->patchOffset = alignTo(bankHeader->indexOffset + index.size() * sizeof(IndexEntry), 64);
+    for (int i = 0; i < tagNames.size(); ++i) {
+        copyText(bankHeader->tags[i], maxTagLength, tagNames[i]);
+    }
+    for (int i = 0; i < categoryNames.size(); ++i) {
+        copyText(bankHeader->categories[i], maxTagLength, categoryNames[i]);
+    }
+
+    // Пишем во временный файл, чтобы открытый кем-то банк не увидел полузаписанные данные
+    juce::TemporaryFile temporaryFile(bankFile);
+    {
+        juce::FileOutputStream stream(temporaryFile.getFile());
+        if (stream.failedToOpen()) {
+            return false;
+        }
+        static const char padding[64] = {};
+        stream.write(bankHeader.get(), sizeof(Header));
+        stream.write(padding, static_cast<size_t>(bankHeader->indexOffset - sizeof(Header)));
+        stream.write(index.data(), index.size() * sizeof(IndexEntry));
+        stream.write(padding, static_cast<size_t>(bankHeader->patchOffset - bankHeader->indexOffset - index.size() * sizeof(IndexEntry)));
+        for (const auto& preset : presets) {
+            stream.write(&preset.patch, sizeof(Patch));
+        }
+        stream.flush();
+        if (stream.getStatus().failed()) {
+            return false;
+        }
+    }
+    return temporaryFile.overwriteTargetFileWithTemporary();
+}
@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    PresetBank.h
+    Created: 20 Oct 2026 4:12:09pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Patch.h"
+
+// Банк пресетов - один файл, который отображается в память целиком, но читается
+// по страницам: заголовок, таблицы тегов и категорий, индекс фиксированных
+// записей, отсортированный по имени, и затем сырые Patch подряд.
+class PresetBank {
+public:
+    static constexpr std::uint32_t magic = 0x424d4653;   // "SFMB"
+    static constexpr std::uint32_t version = 1;
+    static constexpr int maxTags = 64;
+    static constexpr int maxCategories = 32;
+    static constexpr int maxTagLength = 16;
+    static constexpr int maxNameLength = 40;
+
+    struct Header {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint32_t numPresets;
+        std::uint32_t patchSize;
+        std::uint32_t numTags;
+        std::uint32_t numCategories;
+        std::uint64_t indexOffset;
+        std::uint64_t patchOffset;
+        char tags[maxTags][maxTagLength];
+        char categories[maxCategories][maxTagLength];
+    };
+
+    struct IndexEntry {
+        char name[maxNameLength];
+        std::uint64_t tagMask;
+        std::uint32_t category;
+        std::uint32_t patchIndex;
+        std::uint64_t reserved;
+    };
+
+    // Описание пресета для сборки банка
+    struct Preset {
+        juce::String name;
+        juce::String category;
+        juce::StringArray tags;
+        Patch patch;
+    };
+
+    bool open(const juce::File& file);
+    void close();
+    bool isOpen();
+    juce::File getFile();
+
+    int getNumPresets();
+    juce::String getName(int index);
+    juce::String getCategory(int index);
+    juce::StringArray getTags(int index);
+    bool getPatch(int index, Patch& destPatch);
+    void getPresets(std::vector<Preset>& presets);
+
+    int getNumCategories();
+    juce::String getCategoryName(int category);
+    std::uint64_t findTag(const juce::String& tag);
+    int findCategory(const juce::String& category);
+
+    // Префикс имени ищется бинарным поиском по индексу, теги и категория
+    // проверяются масками. category < 0 - любая.
+    void search(const juce::String& namePrefix, std::uint64_t requiredTags, int category,
+        std::vector<int>& results, int maxResults = -1);
+
+    static bool write(const juce::File& file, std::vector<Preset>& presets);
+
+private:
+    juce::File file;
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+    const Header* header = nullptr;
+    const IndexEntry* entries = nullptr;
+    const char* patches = nullptr;
+    int numPresets = 0;
+};
+
+static_assert(sizeof(PresetBank::IndexEntry) == 64, "IndexEntry is a fixed 64-byte record");
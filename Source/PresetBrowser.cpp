@@ -0,0 +1,327 @@
+/*
+  ==============================================================================
+
+    PresetBrowser.cpp
+    Created: 20 Oct 2026 5:03:51pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#include "PresetBrowser.h"
+#include "DX7Importer.h"
+#include "PreviewRenderer.h"
+
+PresetBrowser::PresetBrowser(SynthFMAudioProcessor& p)
+    : processor(p) {
+    searchBox.setTextToShowWhenEmpty("Search presets, #tag", juce::Colours::grey);
+    searchBox.onTextChange = [this] { refreshResults(); };
+    addAndMakeVisible(searchBox);
+
+    categorySelector.onChange = [this] { refreshResults(); };
+    addAndMakeVisible(categorySelector);
+
+    loadButton.onClick = [this] {
+        fileChooser = std::make_unique<juce::FileChooser>("Load preset bank", processor.getPresetBank().getFile(), "*.sfmbank");
+        fileChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+            [this](const juce::FileChooser& chooser) {
+                auto file = chooser.getResult();
+                if (file.existsAsFile() && processor.loadPresetBank(file)) {
+                    refreshBank();
+                }
+            });
+    };
+    addAndMakeVisible(loadButton);
+
+    importButton.onClick = [this] {
+        fileChooser = std::make_unique<juce::FileChooser>("Import DX7 SysEx files or folders", juce::File(), "*.syx");
+        fileChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles
+            | juce::FileBrowserComponent::canSelectDirectories | juce::FileBrowserComponent::canSelectMultipleItems,
+            [this](const juce::FileChooser& chooser) {
+                if (!chooser.getResults().isEmpty()) {
+                    importSysEx(chooser.getResults());
+                }
+            });
+    };
+    addAndMakeVisible(importButton);
+
+    previewButton.onClick = [this] {
+        fileChooser = std::make_unique<juce::FileChooser>("Folder for preset previews",
+            juce::File::getSpecialLocation(juce::File::userDocumentsDirectory));
+        fileChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectDirectories,
+            [this](const juce::FileChooser& chooser) {
+                if (chooser.getResult() != juce::File()) {
+                    renderPreviews(chooser.getResult());
+                }
+            });
+    };
+    addAndMakeVisible(previewButton);
+
+    addSnapshotButton.onClick = [this] {
+        processor.addMorphSnapshot();
+        updateMorphLabel();
+    };
+    addAndMakeVisible(addSnapshotButton);
+
+    clearSnapshotsButton.onClick = [this] {
+        processor.clearMorphSnapshots();
+        updateMorphLabel();
+    };
+    addAndMakeVisible(clearSnapshotsButton);
+
+    morphSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+    morphSlider.setRange(0.0, 1.0, 0.001);
+    morphSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 60, 20);
+    morphSlider.onValueChange = [this] {
+        processor.setMorphPosition(morphSlider.getValue());
+    };
+    addAndMakeVisible(morphSlider);
+    addAndMakeVisible(morphLabel);
+    updateMorphLabel();
+
+    multitimbralButton.setToggleState(processor.isMultitimbral(), juce::dontSendNotification);
+    multitimbralButton.onClick = [this] { processor.setMultitimbral(multitimbralButton.getToggleState()); };
+    addAndMakeVisible(multitimbralButton);
+
+    // Выбранный пресет загружается в эту партию
+    for (int part = 0; part < SynthFMAudioProcessor::numParts; ++part) {
+        partSelector.addItem("Part " + juce::String(part + 1), part + 1);
+    }
+    partSelector.setSelectedId(1, juce::dontSendNotification);
+    partSelector.onChange = [this] {
+        sendSlider.setValue(processor.getPartSend(partSelector.getSelectedId() - 1), juce::dontSendNotification);
+    };
+    addAndMakeVisible(partSelector);
+
+    sendSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+    sendSlider.setRange(0.0, 1.0, 0.01);
+    sendSlider.setTextValueSuffix(" FX send");
+    sendSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 100, 20);
+    sendSlider.setValue(processor.getPartSend(0), juce::dontSendNotification);
+    sendSlider.onValueChange = [this] {
+        processor.setPartSend(partSelector.getSelectedId() - 1, static_cast<float>(sendSlider.getValue()));
+    };
+    addAndMakeVisible(sendSlider);
+
+    similarButton.onClick = [this] { findSimilar(); };
+    addAndMakeVisible(similarButton);
+
+    list.setModel(this);
+    list.setRowHeight(22);
+    addAndMakeVisible(list);
+
+    refreshBank();
+}
+
+void PresetBrowser::resized() {
+    int width = getWidth();
+    searchBox.setBounds(10, 5, width - 630, 26);
+    categorySelector.setBounds(width - 610, 5, 180, 26);
+    previewButton.setBounds(width - 420, 5, 130, 26);
+    loadButton.setBounds(width - 280, 5, 130, 26);
+    importButton.setBounds(width - 140, 5, 130, 26);
+    list.setBounds(10, 40, width - 20, getHeight() - 112);
+
+    int partY = getHeight() - 64;
+    multitimbralButton.setBounds(10, partY, 120, 26);
+    partSelector.setBounds(140, partY, 100, 26);
+    sendSlider.setBounds(250, partY, width - 400, 26);
+    similarButton.setBounds(width - 140, partY, 130, 26);
+
+    int morphY = getHeight() - 32;
+    addSnapshotButton.setBounds(10, morphY, 120, 26);
+    clearSnapshotsButton.setBounds(140, morphY, 70, 26);
+    morphLabel.setBounds(220, morphY, 140, 26);
+    morphSlider.setBounds(370, morphY, width - 380, 26);
+}
+
+void PresetBrowser::refreshBank() {
+    PresetBank& bank = processor.getPresetBank();
+    similarityIndex.close();
+    categorySelector.clear(juce::dontSendNotification);
+    categorySelector.addItem("All", 1);
+    for (int i = 0; i < bank.getNumCategories(); ++i) {
+        categorySelector.addItem(bank.getCategoryName(i), i + 2);
+    }
+    categorySelector.setSelectedId(1, juce::dontSendNotification);
+    refreshResults();
+}
+
+void PresetBrowser::refreshResults() {
+    PresetBank& bank = processor.getPresetBank();
+    juce::StringArray words;
+    words.addTokens(searchBox.getText(), " ", "");
+    words.removeEmptyStrings();
+
+    // Слова с # - теги, остальное - начало имени
+    std::uint64_t tags = 0;
+    juce::String prefix;
+    for (const auto& word : words) {
+        if (word.startsWithChar('#')) {
+            std::uint64_t tag = bank.findTag(word.substring(1));
+            if (tag == 0) {
+                results.clear();
+                list.updateContent();
+                list.repaint();
+                return;
+            }
+            tags |= tag;
+        }
+        else {
+            prefix << (prefix.isEmpty() ? "" : " ") << word;
+        }
+    }
+
+    bank.search(prefix, tags, categorySelector.getSelectedId() - 2, results);
+    list.updateContent();
+    list.repaint();
+}
+
+void PresetBrowser::importSysEx(const juce::Array<juce::File>& sources) {
+    // Текущий банк копируется здесь, пока он открыт; разбор и запись - в фоне,
+    // а подмена файла банка - снова на потоке сообщений
+    auto existing = std::make_shared<std::vector<PresetBank::Preset>>();
+    processor.getPresetBank().getPresets(*existing);
+    juce::File bankFile = SynthFMAudioProcessor::getDefaultPresetBankFile().getSiblingFile("Import.sfmbank");
+    bankFile.getParentDirectory().createDirectory();
+
+    importButton.setEnabled(false);
+    importButton.setButtonText("Importing...");
+    juce::Component::SafePointer<PresetBrowser> safeThis(this);
+    juce::Thread::launch([safeThis, sources, existing, bankFile] {
+        auto result = DX7Importer::importFiles(sources, *existing, bankFile);
+        juce::MessageManager::callAsync([safeThis, result, bankFile] {
+            if (safeThis == nullptr) {
+                bankFile.deleteFile();
+                return;
+            }
+            if (result.numVoices > 0) {
+                safeThis->processor.installPresetBank(bankFile);
+            }
+            else {
+                bankFile.deleteFile();
+            }
+            safeThis->importButton.setEnabled(true);
+            safeThis->importButton.setButtonText("Import SysEx...");
+            safeThis->refreshBank();
+        });
+    });
+}
+
+void PresetBrowser::renderPreviews(const juce::File& outputDirectory) {
+    juce::File bankFile = processor.getPresetBank().getFile();
+    if (!bankFile.existsAsFile() || results.empty()) {
+        return;
+    }
+
+    previewButton.setEnabled(false);
+    previewButton.setButtonText("Rendering...");
+    juce::Component::SafePointer<PresetBrowser> safeThis(this);
+    juce::Thread::launch([safeThis, bankFile, indices = results, outputDirectory] {
+        auto result = PreviewRenderer::renderBank(bankFile, indices, outputDirectory, PreviewRenderer::Settings());
+        juce::MessageManager::callAsync([safeThis, result, outputDirectory] {
+            if (safeThis == nullptr) {
+                return;
+            }
+            safeThis->previewButton.setEnabled(true);
+            safeThis->previewButton.setButtonText("Render Previews...");
+            juce::String text;
+            text << result.numRendered << " previews in " << juce::String(result.seconds, 1) << " s";
+            if (result.numFailed > 0) {
+                text << ", " << result.numFailed << " failed";
+            }
+            text << "\n" << outputDirectory.getFullPathName();
+            juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::InfoIcon, "Preset Previews", text);
+        });
+    });
+}
+
+void PresetBrowser::findSimilar() {
+    int row = list.getSelectedRow();
+    if (row < 0 || row >= static_cast<int>(results.size())) {
+        return;
+    }
+    int preset = results[row];
+    PresetBank& bank = processor.getPresetBank();
+    juce::File bankFile = bank.getFile();
+    juce::File indexFile = SimilarityIndex::getIndexFile(bankFile);
+    if (similarityIndex.isOpen() || similarityIndex.open(indexFile, bank)) {
+        showSimilar(preset);
+        return;
+    }
+    if (!bankFile.existsAsFile()) {
+        return;
+    }
+
+    similarButton.setEnabled(false);
+    similarButton.setButtonText("Indexing...");
+    juce::Component::SafePointer<PresetBrowser> safeThis(this);
+    juce::Thread::launch([safeThis, bankFile, indexFile, preset] {
+        bool built = SimilarityIndex::build(bankFile, indexFile);
+        juce::MessageManager::callAsync([safeThis, built, bankFile, indexFile, preset] {
+            if (safeThis == nullptr) {
+                return;
+            }
+            safeThis->similarButton.setEnabled(true);
+            safeThis->similarButton.setButtonText("Find Similar");
+            // Пока строили, банк могли сменить - тогда индекс к нему не подойдёт
+            PresetBank& currentBank = safeThis->processor.getPresetBank();
+            if (built && currentBank.getFile() == bankFile && safeThis->similarityIndex.open(indexFile, currentBank)) {
+                safeThis->showSimilar(preset);
+            }
+        });
+    });
+}
+
+void PresetBrowser::showSimilar(int preset) {
+    std::vector<SimilarityIndex::Match> matches;
+    similarityIndex.findSimilar(preset, 50, matches);
+    results.clear();
+    results.push_back(preset);
+    for (const auto& match : matches) {
+        results.push_back(match.preset);
+    }
+    list.updateContent();
+    list.selectRow(0);
+    list.repaint();
+}
+
+void PresetBrowser::updateMorphLabel() {
+    morphLabel.setText("Morph: " + juce::String(processor.getNumMorphSnapshots()) + " snapshots", juce::dontSendNotification);
+}
+
+int PresetBrowser::getNumRows() {
+    return static_cast<int>(results.size());
+}
+
+void PresetBrowser::paintListBoxItem(int rowNumber, juce::Graphics& g, int width, int height, bool rowIsSelected) {
+    if (rowNumber < 0 || rowNumber >= static_cast<int>(results.size())) {
+        return;
+    }
+    int index = results[rowNumber];
+    PresetBank& bank = processor.getPresetBank();
+
+    if (rowIsSelected || index == processor.getCurrentProgram()) {
+        g.fillAll(juce::Colours::lightblue.withAlpha(0.3f));
+    }
+    g.setColour(juce::Colours::white);
+    g.drawText(bank.getName(index), 5, 0, width / 2, height, juce::Justification::centredLeft);
+    g.setColour(juce::Colours::lightgrey);
+    g.drawText(bank.getCategory(index), width / 2, 0, width / 4, height, juce::Justification::centredLeft);
+    g.drawText(bank.getTags(index).joinIntoString(" "), 3 * width / 4, 0, width / 4 - 5, height, juce::Justification::centredRight);
+    g.setColour(juce::Colours::grey);
+    g.drawLine(0, height - 1, width, height - 1);
+}
+
+void PresetBrowser::listBoxItemClicked(int row, const juce::MouseEvent&) {
+    if (row >= 0 && row < static_cast<int>(results.size())) {
+        int part = partSelector.getSelectedId() - 1;
+        if (part > 0) {
+            processor.setPartProgram(part, results[row]);
+        }
+        else {
+            processor.setCurrentProgram(results[row]);
+        }
+        list.repaint();
+    }
+}
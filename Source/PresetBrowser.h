@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    PresetBrowser.h
+    Created: 20 Oct 2026 5:03:51pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+#include "PluginProcessor.h"
+#include "SimilarityIndex.h"
+
+// Страница пресетов: строка поиска ("pad #warm #bright"), фильтр по категории и список.
+// Список показывает только найденные индексы, имена читаются из банка при отрисовке.
+// Внизу - партии мультитембрального режима и морфинг между снимками текущего звука (макро-ручка или CC1).
+class PresetBrowser : public juce::Component, public juce::ListBoxModel {
+public:
+    PresetBrowser(SynthFMAudioProcessor& processor);
+
+    void resized() override;
+
+    int getNumRows() override;
+    void paintListBoxItem(int rowNumber, juce::Graphics& g, int width, int height, bool rowIsSelected) override;
+    void listBoxItemClicked(int row, const juce::MouseEvent&) override;
+
+    void refreshBank();
+    void refreshResults();
+    void importSysEx(const juce::Array<juce::File>& sources);
+    // Прослушки для найденных сейчас пресетов, в фоне на всех ядрах
+    void renderPreviews(const juce::File& outputDirectory);
+    // Похожие на выбранный пресет; индекс строится в фоне при первом запросе к банку
+    void findSimilar();
+    void showSimilar(int preset);
+    void updateMorphLabel();
+
+private:
+    SynthFMAudioProcessor& processor;
+    juce::TextEditor searchBox;
+    juce::ComboBox categorySelector;
+    juce::TextButton loadButton{ "Load Bank..." };
+    juce::TextButton importButton{ "Import SysEx..." };
+    juce::TextButton previewButton{ "Render Previews..." };
+    juce::ListBox list;
+
+    juce::ToggleButton multitimbralButton{ "Multitimbral" };
+    juce::ComboBox partSelector;
+    juce::Slider sendSlider;
+    juce::TextButton similarButton{ "Find Similar" };
+    SimilarityIndex similarityIndex;
+
+    juce::TextButton addSnapshotButton{ "Add Snapshot" };
+    juce::TextButton clearSnapshotsButton{ "Clear" };
+    juce::Slider morphSlider;
+    juce::Label morphLabel;
+    std::unique_ptr<juce::FileChooser> fileChooser;
+    std::vector<int> results;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PresetBrowser)
+};
@@ -0,0 +1,199 @@
+/*
+  ==============================================================================
+
+    PreviewRenderer.cpp
+    Created: 27 Oct 2026 10:14:52am
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#include "PreviewRenderer.h"
+#include "PluginProcessor.h"
+#include "PresetBank.h"
+#include <atomic>
+#include <cmath>
+
+namespace {
+    // Фраза прослушки: повтор короткой ноты (атака), два тона и долгий аккорд (sustain и release)
+    struct PhraseNote {
+        double start;
+        double length;
+        int note;
+        float velocity;
+    };
+    const PhraseNote phrase[] = {
+        { 0.0, 0.25, 48, 0.8f },
+        { 0.5, 0.25, 48, 0.8f },
+        { 1.0, 0.4, 52, 0.6f },
+        { 1.5, 0.4, 55, 0.7f },
+        { 2.0, 1.5, 60, 0.8f },
+        { 2.0, 1.5, 64, 0.8f },
+        { 2.0, 1.5, 67, 0.8f },
+    };
+    constexpr double phraseSeconds = 3.5;
+    constexpr int effectsTimeoutMs = 10000;
+
+    struct PhraseEvent {
+        int sample;
+        juce::MidiMessage message;
+    };
+
+    std::vector<PhraseEvent> makePhraseEvents(double sampleRate) {
+        std::vector<PhraseEvent> events;
+        for (const auto& note : phrase) {
+            events.push_back({ juce::roundToInt(note.start * sampleRate), juce::MidiMessage::noteOn(1, note.note, note.velocity) });
+            events.push_back({ juce::roundToInt((note.start + note.length) * sampleRate), juce::MidiMessage::noteOff(1, note.note) });
+        }
+        std::stable_sort(events.begin(), events.end(), [](const PhraseEvent& a, const PhraseEvent& b) { return a.sample < b.sample; });
+        return events;
+    }
+
+    struct Levels {
+        float peak = 0.0f;
+        double sumOfSquares = 0.0;
+        juce::int64 numSamples = 0;
+    };
+
+    // Рендерит фразу и сразу пишет её блоками в файл; false - файл не открылся или не записался
+    bool renderPreview(SynthFMAudioProcessor& synth, const std::vector<PhraseEvent>& events,
+        const juce::File& file, const PreviewRenderer::Settings& settings, Levels& levels) {
+        file.deleteFile();
+        auto stream = std::make_unique<juce::FileOutputStream>(file);
+        if (stream->failedToOpen()) {
+            return false;
+        }
+        juce::FlacAudioFormat flac;
+        std::unique_ptr<juce::AudioFormatWriter> writer(flac.createWriterFor(stream.get(), settings.sampleRate, 2,
+            settings.bitsPerSample, {}, 0));
+        if (writer == nullptr) {
+            return false;
+        }
+        // Поток теперь принадлежит писателю
+        stream.release();
+
+        juce::AudioBuffer<float> buffer(2, settings.blockSize);
+        juce::MidiBuffer midi;
+        int totalSamples = juce::roundToInt((phraseSeconds + settings.tailSeconds) * settings.sampleRate);
+        size_t nextEvent = 0;
+        for (int blockStart = 0; blockStart < totalSamples; blockStart += settings.blockSize) {
+            int numSamples = std::min(settings.blockSize, totalSamples - blockStart);
+            midi.clear();
+            while (nextEvent < events.size() && events[nextEvent].sample < blockStart + numSamples) {
+                midi.addEvent(events[nextEvent].message, events[nextEvent].sample - blockStart);
+                ++nextEvent;
+            }
+            buffer.setSize(2, numSamples, false, false, true);
+            synth.processBlock(buffer, midi);
+
+            for (int channel = 0; channel < 2; ++channel) {
+                const float* data = buffer.getReadPointer(channel);
+                for (int i = 0; i < numSamples; ++i) {
+                    levels.peak = std::max(levels.peak, std::abs(data[i]));
+                    levels.sumOfSquares += static_cast<double>(data[i]) * data[i];
+                }
+            }
+            levels.numSamples += 2 * numSamples;
+            if (!writer->writeFromAudioSampleBuffer(buffer, 0, numSamples)) {
+                return false;
+            }
+        }
+        return writer->flush();
+    }
+
+    juce::String quoteCsv(const juce::String& text) {
+        return "\"" + text.replace("\"", "\"\"") + "\"";
+    }
+}
+
+juce::File PreviewRenderer::getPreviewFile(const juce::File& outputDirectory, int index, const juce::String& name) {
+    return outputDirectory.getChildFile(juce::String(index).paddedLeft('0', 5) + " "
+        + juce::File::createLegalFileName(name) + ".flac");
+}
+
+PreviewRenderer::Result PreviewRenderer::renderBank(const juce::File& bankFile, const std::vector<int>& indices,
+    const juce::File& outputDirectory, const Settings& settings) {
+    Result result;
+    double startTime = juce::Time::getMillisecondCounterHiRes();
+
+    // Из банка только читают, так что один отображённый файл делят все потоки
+    PresetBank bank;
+    if (!bank.open(bankFile) || !outputDirectory.createDirectory()) {
+        return result;
+    }
+    std::vector<int> presets = indices;
+    if (presets.empty()) {
+        for (int i = 0; i < bank.getNumPresets(); ++i) {
+            presets.push_back(i);
+        }
+    }
+
+    juce::FileOutputStream csv(outputDirectory.getChildFile("previews.csv"));
+    if (csv.failedToOpen()) {
+        return result;
+    }
+    csv.setPosition(0);
+    csv.truncate();
+    csv << "index,name,file,peak_db,rms_db\n";
+    juce::CriticalSection csvLock;
+
+    const std::vector<PhraseEvent> events = makePhraseEvents(settings.sampleRate);
+    std::atomic<size_t> next{ 0 };
+    std::atomic<int> numRendered{ 0 };
+    std::atomic<int> numFailed{ 0 };
+
+    int numThreads = settings.numThreads > 0 ? settings.numThreads : juce::SystemStats::getNumCpus();
+    numThreads = juce::jmax(1, std::min(numThreads, static_cast<int>(presets.size())));
+    {
+        juce::ThreadPool pool(numThreads);
+        std::atomic<int> remaining{ numThreads };
+        juce::WaitableEvent finished;
+        for (int worker = 0; worker < numThreads; ++worker) {
+            pool.addJob([&] {
+                // Свой экземпляр на поток; голосов хватает одного потока рендера, параллельность - по пресетам
+                SynthFMAudioProcessor synth;
+                synth.setNonRealtime(true);
+                synth.setNoteCacheEnabled(true);
+                for (size_t i = next++; i < presets.size(); i = next++) {
+                    int index = presets[i];
+                    Patch patch;
+                    if (!bank.getPatch(index, patch)) {
+                        ++numFailed;
+                        continue;
+                    }
+                    // prepareToPlay заново строит голоса и сбрасывает все эффекты - хвост прошлого
+                    // пресета не слышен; свёртка должна успеть собрать ИХ до первого блока
+                    synth.applyPatch(patch);
+                    synth.prepareToPlay(settings.sampleRate, settings.blockSize);
+                    synth.waitUntilEffectsReady(effectsTimeoutMs);
+
+                    juce::String name = bank.getName(index);
+                    juce::File file = getPreviewFile(outputDirectory, index, name);
+                    Levels levels;
+                    if (!renderPreview(synth, events, file, settings, levels)) {
+                        file.deleteFile();
+                        ++numFailed;
+                        continue;
+                    }
+                    float rms = levels.numSamples > 0 ? static_cast<float>(std::sqrt(levels.sumOfSquares / levels.numSamples)) : 0.0f;
+
+                    const juce::ScopedLock lock(csvLock);
+                    csv << juce::String(index) << "," << quoteCsv(name) << "," << quoteCsv(file.getFileName()) << ","
+                        << juce::String(juce::Decibels::gainToDecibels(levels.peak), 2) << ","
+                        << juce::String(juce::Decibels::gainToDecibels(rms), 2) << "\n";
+                    ++numRendered;
+                }
+                if (--remaining == 0) {
+                    finished.signal();
+                }
+            });
+        }
+        finished.wait(-1);
+    }
+    csv.flush();
+
+    result.numRendered = numRendered.load();
+    result.numFailed = numFailed.load();
+    result.seconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+    return result;
+}
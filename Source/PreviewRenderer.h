@@ -0,0 +1,40 @@
+/*
+  ==============================================================================
+
+    PreviewRenderer.h
+    Created: 27 Oct 2026 10:14:52am
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+
+// Пакетный рендер прослушек пресетов вне реального времени. Каждый пресет играет одну
+// и ту же фразу; у каждого потока свой экземпляр синтезатора, пресеты он берёт из общего
+// счётчика. Звук пишется в FLAC по блокам, пик и RMS - строкой в previews.csv,
+// так что память не растёт с числом пресетов.
+class PreviewRenderer {
+public:
+    struct Settings {
+        double sampleRate = 48000.0;
+        int blockSize = 512;
+        int bitsPerSample = 16;
+        double tailSeconds = 1.5;    // после последней ноты фразы
+        int numThreads = 0;          // 0 - по числу ядер
+    };
+
+    struct Result {
+        int numRendered = 0;
+        int numFailed = 0;
+        double seconds = 0.0;
+    };
+
+    // Банк открывается заново только для чтения, так что замена банка в плагине рендеру
+    // не мешает. Пустой indices - все пресеты банка.
+    static Result renderBank(const juce::File& bankFile, const std::vector<int>& indices,
+        const juce::File& outputDirectory, const Settings& settings);
+    static juce::File getPreviewFile(const juce::File& outputDirectory, int index, const juce::String& name);
+};
@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+
+    QualityGovernor.cpp
+    Created: 28 Oct 2026 11:36:05am
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#include "QualityGovernor.h"
+#include <cmath>
+
+void QualityGovernor::prepare(double newSampleRate) {
+    sampleRate = newSampleRate;
+    reset();
+}
+
+void QualityGovernor::reset() {
+    tier = Full;
+    load = 0.0f;
+    secondsSinceChange = 0.0;
+    secondsWithHeadroom = 0.0;
+}
+
+bool QualityGovernor::update(double elapsedSeconds, int numSamples) {
+    if (numSamples <= 0) {
+        return false;
+    }
+    double blockSeconds = numSamples / sampleRate;
+    float blockLoad = static_cast<float>(elapsedSeconds / blockSeconds);
+    float alpha = 1.0f - static_cast<float>(std::exp(-blockSeconds / smoothingSeconds));
+    load += alpha * (blockLoad - load);
+    secondsSinceChange += blockSeconds;
+    secondsWithHeadroom = load < stepUpLoad ? secondsWithHeadroom + blockSeconds : 0.0;
+
+    if ((load > stepDownLoad || blockLoad > overrunLoad) && tier + 1 < numTiers
+        && secondsSinceChange >= stepDownHoldSeconds) {
+        // Следующий шаг только после того, как сглаженная загрузка увидит эффект этого
+        tier = static_cast<Tier>(tier + 1);
+        secondsSinceChange = 0.0;
+        secondsWithHeadroom = 0.0;
+        return true;
+    }
+    if (tier > Full && secondsWithHeadroom >= stepUpHoldSeconds) {
+        tier = static_cast<Tier>(tier - 1);
+        secondsSinceChange = 0.0;
+        secondsWithHeadroom = 0.0;
+        return true;
+    }
+    return false;
+}
+
+QualityGovernor::Tier QualityGovernor::getTier() {
+    return tier;
+}
+
+float QualityGovernor::getLoad() {
+    return load;
+}
+
+juce::String QualityGovernor::getTierName(Tier tier) {
+    switch (tier) {
+    case Full:
+        return "Full";
+    case SlowModulation:
+        return "Slow modulation";
+    case ReducedEnsemble:
+        return "Reduced ensemble";
+    case DraftWaveforms:
+        return "Draft waveforms";
+    case HalfPolyphony:
+        return "32 voices";
+    case QuarterPolyphony:
+        return "16 voices";
+    default:
+        return {};
+    }
+}
@@ -0,0 +1,51 @@
+/*
+  ==============================================================================
+
+    QualityGovernor.h
+    Created: 28 Oct 2026 11:36:05am
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// Следит за временем обработки блока относительно его длительности и, когда запаса нет,
+// по одному спускает уровни качества - от неслышных к заметным. Вниз шаг делается быстро,
+// обратно вверх - только после нескольких секунд устойчивого запаса (гистерезис), чтобы
+// качество не прыгало туда-сюда на границе.
+class QualityGovernor {
+public:
+    enum Tier {
+        Full,
+        SlowModulation,      // контрольный блок модуляции вчетверо длиннее
+        ReducedEnsemble,     // у Ensemble 4 голоса вместо 8
+        DraftWaveforms,      // синус и треугольник из таблицы без интерполяции
+        HalfPolyphony,       // 32 голоса
+        QuarterPolyphony,    // 16 голосов
+        numTiers
+    };
+
+    static constexpr float stepDownLoad = 0.8f;      // сглаженная загрузка
+    static constexpr float overrunLoad = 1.0f;       // один блок не успел - сразу вниз
+    static constexpr float stepUpLoad = 0.5f;
+    static constexpr double stepDownHoldSeconds = 0.1;
+    static constexpr double stepUpHoldSeconds = 3.0;
+    static constexpr double smoothingSeconds = 0.1;
+
+    void prepare(double newSampleRate);
+    void reset();
+    // Время счёта блока из numSamples сэмплов; true - уровень сменился
+    bool update(double elapsedSeconds, int numSamples);
+    Tier getTier();
+    float getLoad();
+    static juce::String getTierName(Tier tier);
+
+private:
+    double sampleRate = 48000.0;
+    Tier tier = Full;
+    float load = 0.0f;
+    double secondsSinceChange = 0.0;
+    double secondsWithHeadroom = 0.0;
+};
@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    RenderBenchmark.cpp
+    Created: 24 Oct 2026 2:37:50pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#include "RenderBenchmark.h"
+#include "PluginProcessor.h"
+
+std::vector<RenderBenchmark::Result> RenderBenchmark::run(int numVoices, double seconds, int maxThreads) {
+    const double sampleRate = 48000.0;
+    const int blockSize = 512;
+    if (maxThreads <= 0) {
+        maxThreads = juce::SystemStats::getNumCpus();
+    }
+    maxThreads = juce::jlimit(1, static_cast<int>(RenderPool::maxWorkers), maxThreads);
+    numVoices = juce::jlimit(1, static_cast<int>(SynthFMAudioProcessor::maxVoices), numVoices);
+
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    std::vector<Result> results;
+    for (int threads : threadCounts) {
+        SynthFMAudioProcessor synth;
+        synth.setRenderThreads(threads);
+        // Меряется полный рендер: регулятор качества не должен урезать голоса и эффекты под нагрузкой.
+        // setNonRealtime не подходит - он включает кэш нот, и замер был бы не о том
+        synth.setQualityGovernorEnabled(false);
+        synth.prepareToPlay(sampleRate, blockSize);
+
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        juce::MidiBuffer midi;
+        for (int v = 0; v < numVoices; ++v) {
+            midi.addEvent(juce::MidiMessage::noteOn(1, 24 + v, 0.8f), 0);
+        }
+        // Первый блок запускает ноты и подхватывает новый пул
+        synth.processBlock(buffer, midi);
+        midi.clear();
+
+        int numBlocks = juce::jmax(1, static_cast<int>(seconds * sampleRate / blockSize));
+        double start = juce::Time::getMillisecondCounterHiRes();
+        for (int block = 0; block < numBlocks; ++block) {
+            synth.processBlock(buffer, midi);
+        }
+        double elapsed = juce::jmax(1.0e-3, (juce::Time::getMillisecondCounterHiRes() - start) / 1000.0);
+
+        Result result;
+        result.numThreads = threads;
+        result.realtimeFactor = numBlocks * blockSize / sampleRate / elapsed;
+        result.speedup = results.empty() ? 1.0 : result.realtimeFactor / results.front().realtimeFactor;
+        result.dspBytes = synth.getDspMemoryUsage();
+        results.push_back(result);
+    }
+    return results;
+}
+
+juce::String RenderBenchmark::format(const std::vector<Result>& results) {
+    juce::String text;
+    if (!results.empty()) {
+        text << "DSP state: " << juce::String(results.front().dspBytes / 1024.0, 1) << " KB\n";
+    }
+    for (const auto& result : results) {
+        text << result.numThreads << (result.numThreads == 1 ? " thread: " : " threads: ")
+            << juce::String(result.realtimeFactor, 1) << "x realtime, speedup "
+            << juce::String(result.speedup, 2) << "\n";
+    }
+    return text;
+}
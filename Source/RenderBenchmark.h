@@ -0,0 +1,29 @@
+/*
+  ==============================================================================
+
+    RenderBenchmark.h
+    Created: 24 Oct 2026 2:37:50pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+
+// Замер того, как рендер голосов масштабируется по ядрам: отдельный экземпляр синтезатора
+// держит numVoices нот и вне реального времени гоняет processBlock с разным числом потоков.
+class RenderBenchmark {
+public:
+    struct Result {
+        int numThreads;
+        double realtimeFactor;   // секунд звука за секунду счёта
+        double speedup;          // относительно одного потока
+        size_t dspBytes;         // арена состояния DSP экземпляра
+    };
+
+    // maxThreads = 0 - по числу ядер
+    static std::vector<Result> run(int numVoices = 64, double seconds = 2.0, int maxThreads = 0);
+    static juce::String format(const std::vector<Result>& results);
+};
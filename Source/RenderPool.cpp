@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+    RenderPool.cpp
+    Created: 24 Oct 2026 11:05:23am
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#include "RenderPool.h"
+#include <chrono>
+
+RenderPool::RenderPool(int workers)
+    : numWorkers(juce::jlimit(1, static_cast<int>(maxWorkers), workers)) {
+    for (int worker = 1; worker < numWorkers; ++worker) {
+        threads.push_back(std::make_unique<Worker>(*this, worker));
+        // Там, где поток реального времени не дают, берём самый высокий обычный приоритет
+        if (!threads.back()->startRealtimeThread(juce::Thread::RealtimeOptions{})) {
+            threads.back()->startThread(juce::Thread::Priority::highest);
+        }
+    }
+}
+
+RenderPool::~RenderPool() {
+    stopping.store(true);
+    for (auto& thread : threads) {
+        thread->stopThread(1000);
+    }
+}
+
+RenderPool::Worker::Worker(RenderPool& pool, int index)
+    : juce::Thread("SynthFM render " + juce::String(index)), pool(pool), index(index) {}
+
+void RenderPool::Worker::run() {
+    pool.workerLoop(index);
+}
+
+int RenderPool::getNumWorkers() {
+    return numWorkers;
+}
+
+void RenderPool::run(Task task, void* context, int numTasks) {
+    if (threads.empty() || numTasks <= 1) {
+        for (int i = 0; i < numTasks; ++i) {
+            task(context, i);
+        }
+        return;
+    }
+
+    for (int worker = 0; worker < numWorkers; ++worker) {
+        queues[worker].end = numTasks * (worker + 1) / numWorkers;
+        queues[worker].next.store(numTasks * worker / numWorkers, std::memory_order_relaxed);
+    }
+    currentTask = task;
+    currentContext = context;
+    open.store(true);
+    generation.fetch_add(1);
+
+    drain(0);
+
+    // Все задачи уже разобраны; ждём только тех, кто успел войти и ещё считает
+    open.store(false);
+    while (joined.load() != 0) {
+    }
+}
+
+void RenderPool::drain(int worker) {
+    for (int i = 0; i < numWorkers; ++i) {
+        Queue& queue = queues[(worker + i) % numWorkers];
+        for (int task = queue.next.fetch_add(1); task < queue.end; task = queue.next.fetch_add(1)) {
+            currentTask(currentContext, task);
+        }
+    }
+}
+
+void RenderPool::workerLoop(int worker) {
+    int seen = generation.load();
+    int idle = 0;
+    while (!stopping.load()) {
+        int current = generation.load();
+        if (current == seen) {
+            // Сначала чистый опрос, потом уступаем процессор, а после долгого простоя спим
+            if (++idle > 4096) {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+            else if (idle > 64) {
+                std::this_thread::yield();
+            }
+            continue;
+        }
+        seen = current;
+        idle = 0;
+
+        // Вход проверяется после отметки: либо run увидит нас в joined, либо мы увидим закрытый запуск
+        joined.fetch_add(1);
+        if (open.load()) {
+            drain(worker);
+        }
+        joined.fetch_sub(1);
+    }
+}
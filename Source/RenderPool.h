@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+
+    RenderPool.h
+    Created: 24 Oct 2026 11:05:23am
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Пул для параллельного рендера из аудиопотока. Рабочие потоки ждут в цикле опроса,
+// без мьютексов и выделений; вызывающий поток работает наравне с ними. Задачи делятся
+// между очередями рабочих поровну, освободившийся рабочий крадёт из чужих очередей.
+// Поток, проспавший запуск, в нём не участвует, так что run его не ждёт.
+// Рабочие - потоки реального времени, как у FxPipeline: run ждёт только тех, кто уже
+// взял задачу, и этот поток не должен уступать процессор менее важной работе.
+class RenderPool {
+public:
+    static constexpr int maxWorkers = 16;
+    using Task = void (*)(void* context, int task);
+
+    // numWorkers считает и вызывающий поток; 1 - всё выполняется на месте
+    explicit RenderPool(int numWorkers);
+    ~RenderPool();
+
+    int getNumWorkers();
+
+    // Выполняет задачи [0, numTasks) и возвращается, когда все готовы
+    void run(Task task, void* context, int numTasks);
+
+private:
+    struct alignas(64) Queue {
+        std::atomic<int> next{ 0 };
+        int end = 0;
+    };
+
+    class Worker : public juce::Thread {
+    public:
+        Worker(RenderPool& pool, int index);
+        void run() override;
+
+    private:
+        RenderPool& pool;
+        int index;
+    };
+
+    std::vector<std::unique_ptr<Worker>> threads;
+    Queue queues[maxWorkers];
+    int numWorkers;
+
+    Task currentTask = nullptr;
+    void* currentContext = nullptr;
+    std::atomic<int> generation{ 0 };
+    std::atomic<bool> open{ false };
+    std::atomic<int> joined{ 0 };
+    std::atomic<bool> stopping{ false };
+
+    void workerLoop(int worker);
+    void drain(int worker);
+
+    JUCE_DECLARE_NON_COPYABLE(RenderPool)
+};
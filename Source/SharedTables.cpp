@@ -0,0 +1,19 @@
+/*
+  ==============================================================================
+
+    SharedTables.cpp
+    Created: 26 Oct 2026 11:20:31am
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#include "SharedTables.h"
+
+SharedTables::SharedTables() {
+    for (int i = 0; i <= waveSize; ++i) {
+        double phase = juce::MathConstants<double>::twoPi * (i % waveSize) / waveSize;
+        sineTable[i] = static_cast<float>(std::sin(phase));
+        triangleTable[i] = static_cast<float>(2.0 * std::asin(std::sin(phase)) / juce::MathConstants<double>::pi);
+    }
+}
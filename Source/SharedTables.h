@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+
+    SharedTables.h
+    Created: 26 Oct 2026 11:20:31am
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <cmath>
+
+// Неизменяемые таблицы форм волны, общие для всех экземпляров плагина в процессе.
+// Держатся через juce::SharedResourcePointer: первый экземпляр строит их в своём
+// конструкторе (не на аудиопотоке), последний освобождает.
+class SharedTables {
+public:
+    static constexpr int waveSize = 4096;
+
+    SharedTables();
+
+    // Фаза в радианах, любого знака; линейная интерполяция между точками таблицы
+    float sine(float phase) const {
+        return lookup(sineTable.data(), phase);
+    }
+
+    float triangle(float phase) const {
+        return lookup(triangleTable.data(), phase);
+    }
+
+    // Черновое качество: ближайшая точка без интерполяции
+    float sineDraft(float phase) const {
+        return lookupNearest(sineTable.data(), phase);
+    }
+
+    float triangleDraft(float phase) const {
+        return lookupNearest(triangleTable.data(), phase);
+    }
+
+private:
+    // Последняя точка повторяет первую, чтобы интерполяция не проверяла границу
+    std::array<float, waveSize + 1> sineTable;
+    std::array<float, waveSize + 1> triangleTable;
+
+    static float lookup(const float* table, float phase) {
+        float position = phase * (waveSize / juce::MathConstants<float>::twoPi);
+        float whole = std::floor(position);
+        int index = static_cast<int>(whole) & (waveSize - 1);
+        float fraction = position - whole;
+        return table[index] + fraction * (table[index + 1] - table[index]);
+    }
+
+    static float lookupNearest(const float* table, float phase) {
+        return table[juce::roundToInt(phase * (waveSize / juce::MathConstants<float>::twoPi)) & (waveSize - 1)];
+    }
+
+    JUCE_DECLARE_NON_COPYABLE(SharedTables)
+};
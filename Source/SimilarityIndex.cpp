@@ -0,0 +1,507 @@
+/*
+  ==============================================================================
+
+    SimilarityIndex.cpp
+    Created: 27 Oct 2026 4:58:30pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#include "SimilarityIndex.h"
+#include "PluginProcessor.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+    constexpr int renderSamples = 48000;      // секунда: нота 0.6 с и отпускание
+    constexpr int noteOffSample = 28800;
+    constexpr int effectsTimeoutMs = 10000;
+    constexpr int fftOrder = 10;
+    constexpr int fftSize = 1 << fftOrder;
+    constexpr int hopSize = fftSize / 2;
+    constexpr int numBins = fftSize / 2 + 1;
+    constexpr int numBands = 24;
+    constexpr int numCoefficients = 13;
+    constexpr int numEnvelopePoints = 12;
+    constexpr float silence = 1.0e-8f;
+
+    // Раскладка признаков; группы уравниваются по весу, чтобы тринадцать коэффициентов
+    // кепстра не перевешивали центроид
+    constexpr int cepstrumStart = 0;
+    constexpr int centroidStart = cepstrumStart + numCoefficients;   // среднее и разброс центроида, плоскость
+    constexpr int envelopeStart = centroidStart + 3;
+    constexpr int attackFeature = envelopeStart + numEnvelopePoints;
+    constexpr int loudnessFeature = attackFeature + 1;
+    constexpr int numFeatures = loudnessFeature + 1;
+    static_assert(numFeatures <= SimilarityIndex::dimension, "признаки не влезают в вектор");
+
+    float getGroupWeight(int feature) {
+        if (feature < centroidStart) {
+            return 1.0f / std::sqrt(static_cast<float>(numCoefficients));
+        }
+        if (feature < envelopeStart) {
+            return 1.0f / std::sqrt(3.0f);
+        }
+        if (feature < attackFeature) {
+            return 1.0f / std::sqrt(static_cast<float>(numEnvelopePoints));
+        }
+        return feature < numFeatures ? 0.7f : 0.0f;
+    }
+
+    float toMel(float frequency) {
+        return 2595.0f * std::log10(1.0f + frequency / 700.0f);
+    }
+
+    float fromMel(float mel) {
+        return 700.0f * (std::pow(10.0f, mel / 2595.0f) - 1.0f);
+    }
+
+    // Рендер одной ноты и признаки её звука; буферы живут весь прогон, по объекту на поток
+    class FeatureExtractor {
+    public:
+        FeatureExtractor()
+            : window(fftSize), fftData(2 * fftSize), audio(renderSamples), bandWeights(numBands * numBins, 0.0f) {
+            for (int i = 0; i < fftSize; ++i) {
+                window[i] = 0.5f - 0.5f * std::cos(juce::MathConstants<float>::twoPi * i / (fftSize - 1));
+            }
+            // Треугольные мел-полосы от 40 Гц до 16 кГц
+            float lowMel = toMel(40.0f);
+            float highMel = toMel(16000.0f);
+            float binWidth = static_cast<float>(sampleRate / fftSize);
+            for (int band = 0; band < numBands; ++band) {
+                float left = fromMel(lowMel + (highMel - lowMel) * band / (numBands + 1));
+                float centre = fromMel(lowMel + (highMel - lowMel) * (band + 1) / (numBands + 1));
+                float right = fromMel(lowMel + (highMel - lowMel) * (band + 2) / (numBands + 1));
+                for (int bin = 0; bin < numBins; ++bin) {
+                    float frequency = bin * binWidth;
+                    float weight = frequency < centre ? (frequency - left) / (centre - left) : (right - frequency) / (right - centre);
+                    bandWeights[band * numBins + bin] = std::max(0.0f, weight);
+                }
+            }
+            synth.setNonRealtime(true);
+        }
+
+        void extract(const Patch& patch, float* features) {
+            render(patch);
+            std::fill(features, features + SimilarityIndex::dimension, 0.0f);
+
+            int numFrames = (renderSamples - fftSize) / hopSize + 1;
+            std::vector<float>& frameLevels = levels;
+            frameLevels.assign(numFrames, 0.0f);
+            float bandSums[numBands] = {};
+            double centroidSum = 0.0;
+            double centroidSquares = 0.0;
+            double flatnessSum = 0.0;
+            int numVoiced = 0;
+
+            for (int frame = 0; frame < numFrames; ++frame) {
+                const float* input = audio.data() + frame * hopSize;
+                double energy = 0.0;
+                for (int i = 0; i < fftSize; ++i) {
+                    energy += static_cast<double>(input[i]) * input[i];
+                }
+                frameLevels[frame] = static_cast<float>(std::sqrt(energy / fftSize));
+                if (frameLevels[frame] < 1.0e-4f) {
+                    continue;
+                }
+
+                std::fill(fftData.begin(), fftData.end(), 0.0f);
+                juce::FloatVectorOperations::multiply(fftData.data(), input, window.data(), fftSize);
+                fft.performFrequencyOnlyForwardTransform(fftData.data());
+
+                double power = 0.0;
+                double weighted = 0.0;
+                double logSum = 0.0;
+                for (int bin = 1; bin < numBins; ++bin) {
+                    double binPower = static_cast<double>(fftData[bin]) * fftData[bin] + silence;
+                    power += binPower;
+                    weighted += binPower * bin;
+                    logSum += std::log(binPower);
+                }
+                double centroid = std::log2(std::max(1.0, weighted / power) * sampleRate / fftSize);
+                centroidSum += centroid;
+                centroidSquares += centroid * centroid;
+                flatnessSum += std::exp(logSum / (numBins - 1)) / (power / (numBins - 1));
+
+                for (int band = 0; band < numBands; ++band) {
+                    const float* weights = bandWeights.data() + band * numBins;
+                    double bandPower = 0.0;
+                    for (int bin = 1; bin < numBins; ++bin) {
+                        bandPower += weights[bin] * static_cast<double>(fftData[bin]) * fftData[bin];
+                    }
+                    bandSums[band] += std::log(static_cast<float>(bandPower) + silence);
+                }
+                ++numVoiced;
+            }
+            if (numVoiced == 0) {
+                // Молчащие пресеты все в одной точке, далеко от звучащих
+                features[loudnessFeature] = -1.0f;
+                return;
+            }
+
+            // Кепстр: DCT-II средних логарифмов энергий полос
+            for (int k = 0; k < numCoefficients; ++k) {
+                float sum = 0.0f;
+                for (int band = 0; band < numBands; ++band) {
+                    sum += bandSums[band] / numVoiced * std::cos(juce::MathConstants<float>::pi * k * (band + 0.5f) / numBands);
+                }
+                features[cepstrumStart + k] = sum / numBands;
+            }
+            double centroidMean = centroidSum / numVoiced;
+            features[centroidStart] = static_cast<float>(centroidMean);
+            features[centroidStart + 1] = static_cast<float>(std::sqrt(std::max(0.0, centroidSquares / numVoiced - centroidMean * centroidMean)));
+            features[centroidStart + 2] = static_cast<float>(flatnessSum / numVoiced);
+
+            // Огибающая в дБ от пика, атака - время до 90% пика
+            float peak = *std::max_element(frameLevels.begin(), frameLevels.end());
+            for (int point = 0; point < numEnvelopePoints; ++point) {
+                int frame = std::min(numFrames - 1, (2 * point + 1) * numFrames / (2 * numEnvelopePoints));
+                features[envelopeStart + point] = std::max(-80.0f, juce::Decibels::gainToDecibels(frameLevels[frame] / peak, -80.0f)) / 80.0f;
+            }
+            int attackFrame = 0;
+            while (attackFrame < numFrames - 1 && frameLevels[attackFrame] < 0.9f * peak) {
+                ++attackFrame;
+            }
+            features[attackFeature] = std::log10(attackFrame * hopSize / static_cast<float>(sampleRate) + 1.0e-3f);
+            features[loudnessFeature] = juce::Decibels::gainToDecibels(peak, -80.0f) / 80.0f;
+        }
+
+    private:
+        SynthFMAudioProcessor synth;
+        juce::dsp::FFT fft{ fftOrder };
+        std::vector<float> window;
+        std::vector<float> fftData;
+        std::vector<float> audio;
+        std::vector<float> levels;
+        std::vector<float> bandWeights;
+
+        void render(const Patch& patch) {
+            // Как в PreviewRenderer: prepareToPlay заново строит голоса и сбрасывает эффекты и
+            // модуляцию, так что признаки не зависят ни от прошлого пресета, ни от потока
+            synth.applyPatch(patch);
+            synth.prepareToPlay(sampleRate, blockSize);
+            synth.waitUntilEffectsReady(effectsTimeoutMs);
+            juce::AudioBuffer<float> buffer(2, blockSize);
+            juce::MidiBuffer midi;
+            for (int blockStart = 0; blockStart < renderSamples; blockStart += blockSize) {
+                int numSamples = std::min(blockSize, renderSamples - blockStart);
+                midi.clear();
+                if (blockStart == 0) {
+                    midi.addEvent(juce::MidiMessage::noteOn(1, 60, 0.8f), 0);
+                }
+                if (noteOffSample >= blockStart && noteOffSample < blockStart + numSamples) {
+                    midi.addEvent(juce::MidiMessage::noteOff(1, 60), noteOffSample - blockStart);
+                }
+                buffer.setSize(2, numSamples, false, false, true);
+                synth.processBlock(buffer, midi);
+                std::memcpy(audio.data() + blockStart, buffer.getReadPointer(0), sizeof(float) * numSamples);
+            }
+        }
+    };
+
+    std::uint64_t alignTo(std::uint64_t offset, std::uint64_t alignment) {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    int findNearest(const float* vector, const std::vector<float>& centres, int numCentres) {
+        int nearest = 0;
+        float best = std::numeric_limits<float>::max();
+        for (int c = 0; c < numCentres; ++c) {
+            float d = SimilarityIndex::distance(vector, centres.data() + c * SimilarityIndex::dimension);
+            if (d < best) {
+                best = d;
+                nearest = c;
+            }
+        }
+        return nearest;
+    }
+
+    bool isCloser(const SimilarityIndex::Match& a, const SimilarityIndex::Match& b) {
+        return a.distance < b.distance;
+    }
+}
+
+float SimilarityIndex::distance(const float* a, const float* b) {
+    // Оба вектора выровнены по SIMD: в файле по 64 байта, запрос копируется в выровненный буфер
+    Vec sum = Vec::expand(0.0f);
+    for (int i = 0; i < dimension; i += numLanes) {
+        Vec difference = Vec::fromRawArray(a + i) - Vec::fromRawArray(b + i);
+        sum = Vec::multiplyAdd(sum, difference, difference);
+    }
+    return sum.sum();
+}
+
+juce::File SimilarityIndex::getIndexFile(const juce::File& bankFile) {
+    return bankFile.withFileExtension("sfmsim");
+}
+
+bool SimilarityIndex::open(const juce::File& indexFile, PresetBank& bank) {
+    close();
+    if (!bank.isOpen()) {
+        return false;
+    }
+
+    auto mapped = std::make_unique<juce::MemoryMappedFile>(indexFile, juce::MemoryMappedFile::readOnly);
+    const char* data = static_cast<const char*>(mapped->getData());
+    std::uint64_t size = mapped->getSize();
+    if (data == nullptr || size < sizeof(Header)) {
+        return false;
+    }
+
+    auto* indexHeader = reinterpret_cast<const Header*>(data);
+    std::uint64_t count = indexHeader->numVectors;
+    std::uint64_t numLists = indexHeader->numLists;
+    if (indexHeader->magic != magic || indexHeader->version > version || indexHeader->numDimensions != dimension
+        || count != static_cast<std::uint64_t>(bank.getNumPresets())
+        || indexHeader->bankSize != static_cast<std::uint64_t>(bank.getFile().getSize())
+        || numLists == 0 || indexHeader->vectorsOffset % 64 != 0 || indexHeader->centroidsOffset % 64 != 0
+        || indexHeader->presetsOffset % alignof(std::uint32_t) != 0 || indexHeader->listsOffset % alignof(std::uint32_t) != 0
+        || indexHeader->vectorsOffset + count * dimension * sizeof(float) > size
+        || indexHeader->presetsOffset + count * sizeof(std::uint32_t) > size
+        || indexHeader->listsOffset + (numLists + 1) * sizeof(std::uint32_t) > size
+        || indexHeader->centroidsOffset + numLists * dimension * sizeof(float) > size) {
+        return false;
+    }
+
+    const auto* listStarts = reinterpret_cast<const std::uint32_t*>(data + indexHeader->listsOffset);
+    const auto* vectorPresets = reinterpret_cast<const std::uint32_t*>(data + indexHeader->presetsOffset);
+    if (listStarts[0] != 0 || listStarts[numLists] != count) {
+        return false;
+    }
+    for (std::uint64_t list = 0; list < numLists; ++list) {
+        if (listStarts[list] > listStarts[list + 1]) {
+            return false;
+        }
+    }
+    rows.assign(count, -1);
+    for (std::uint64_t row = 0; row < count; ++row) {
+        if (vectorPresets[row] >= count) {
+            rows.clear();
+            return false;
+        }
+        rows[vectorPresets[row]] = static_cast<int>(row);
+    }
+
+    mappedFile = std::move(mapped);
+    header = indexHeader;
+    vectors = reinterpret_cast<const float*>(data + header->vectorsOffset);
+    presets = vectorPresets;
+    lists = listStarts;
+    centroids = reinterpret_cast<const float*>(data + header->centroidsOffset);
+    return true;
+}
+
+void SimilarityIndex::close() {
+    header = nullptr;
+    vectors = nullptr;
+    presets = nullptr;
+    lists = nullptr;
+    centroids = nullptr;
+    rows.clear();
+    mappedFile.reset();
+}
+
+bool SimilarityIndex::isOpen() {
+    return header != nullptr;
+}
+
+int SimilarityIndex::getNumPresets() {
+    return header != nullptr ? static_cast<int>(header->numVectors) : 0;
+}
+
+void SimilarityIndex::findSimilar(int preset, int numResults, std::vector<Match>& matches, int numProbes) {
+    matches.clear();
+    if (header == nullptr || preset < 0 || preset >= static_cast<int>(rows.size()) || rows[preset] < 0) {
+        return;
+    }
+    search(vectors + static_cast<size_t>(rows[preset]) * dimension, numResults, matches, numProbes, preset);
+}
+
+void SimilarityIndex::search(const float* query, int numResults, std::vector<Match>& matches, int numProbes, int excludedPreset) {
+    matches.clear();
+    if (header == nullptr || numResults <= 0) {
+        return;
+    }
+    alignas(64) float aligned[dimension];
+    std::memcpy(aligned, query, sizeof(aligned));
+
+    // Куча из numResults лучших: сверху самый дальний из них
+    matches.reserve(numResults + 1);
+    int numLists = static_cast<int>(header->numLists);
+    if (numProbes <= 0 || numProbes >= numLists) {
+        for (int list = 0; list < numLists; ++list) {
+            scanList(list, aligned, numResults, excludedPreset, matches);
+        }
+    }
+    else {
+        // Здесь в preset - номер списка
+        std::vector<Match> nearestLists(numLists);
+        for (int list = 0; list < numLists; ++list) {
+            nearestLists[list] = { list, distance(aligned, centroids + static_cast<size_t>(list) * dimension) };
+        }
+        std::partial_sort(nearestLists.begin(), nearestLists.begin() + numProbes, nearestLists.end(), isCloser);
+        for (int probe = 0; probe < numProbes; ++probe) {
+            scanList(nearestLists[probe].preset, aligned, numResults, excludedPreset, matches);
+        }
+    }
+    std::sort_heap(matches.begin(), matches.end(), isCloser);
+}
+
+void SimilarityIndex::scanList(int list, const float* query, int numResults, int excludedPreset, std::vector<Match>& heap) {
+    for (std::uint32_t row = lists[list]; row < lists[list + 1]; ++row) {
+        int preset = static_cast<int>(presets[row]);
+        if (preset == excludedPreset) {
+            continue;
+        }
+        float d = distance(query, vectors + static_cast<size_t>(row) * dimension);
+        if (static_cast<int>(heap.size()) < numResults) {
+            heap.push_back({ preset, d });
+            std::push_heap(heap.begin(), heap.end(), isCloser);
+        }
+        else if (d < heap.front().distance) {
+            std::pop_heap(heap.begin(), heap.end(), isCloser);
+            heap.back() = { preset, d };
+            std::push_heap(heap.begin(), heap.end(), isCloser);
+        }
+    }
+}
+
+bool SimilarityIndex::build(const juce::File& bankFile, const juce::File& indexFile, int numThreads) {
+    PresetBank bank;
+    if (!bank.open(bankFile) || bank.getNumPresets() == 0) {
+        return false;
+    }
+    const int count = bank.getNumPresets();
+
+    // Признаки всех пресетов держим в памяти: даже 100k - это 12 МБ
+    std::vector<float> features(static_cast<size_t>(count) * dimension, 0.0f);
+    {
+        numThreads = juce::jlimit(1, count, numThreads > 0 ? numThreads : juce::SystemStats::getNumCpus());
+        juce::ThreadPool pool(numThreads);
+        std::atomic<int> next{ 0 };
+        std::atomic<int> remaining{ numThreads };
+        juce::WaitableEvent finished;
+        for (int worker = 0; worker < numThreads; ++worker) {
+            pool.addJob([&] {
+                auto extractor = std::make_unique<FeatureExtractor>();
+                for (int preset = next++; preset < count; preset = next++) {
+                    Patch patch;
+                    if (bank.getPatch(preset, patch)) {
+                        extractor->extract(patch, features.data() + static_cast<size_t>(preset) * dimension);
+                    }
+                }
+                if (--remaining == 0) {
+                    finished.signal();
+                }
+            });
+        }
+        finished.wait(-1);
+    }
+
+    auto indexHeader = std::make_unique<Header>();
+    std::memset(indexHeader.get(), 0, sizeof(Header));
+    for (int feature = 0; feature < dimension; ++feature) {
+        double sum = 0.0;
+        double squares = 0.0;
+        for (int preset = 0; preset < count; ++preset) {
+            double value = features[static_cast<size_t>(preset) * dimension + feature];
+            sum += value;
+            squares += value * value;
+        }
+        double mean = sum / count;
+        double deviation = std::sqrt(std::max(0.0, squares / count - mean * mean));
+        indexHeader->mean[feature] = static_cast<float>(mean);
+        indexHeader->scale[feature] = deviation > 1.0e-6 ? static_cast<float>(getGroupWeight(feature) / deviation) : 0.0f;
+    }
+    for (int preset = 0; preset < count; ++preset) {
+        float* vector = features.data() + static_cast<size_t>(preset) * dimension;
+        for (int feature = 0; feature < dimension; ++feature) {
+            vector[feature] = (vector[feature] - indexHeader->mean[feature]) * indexHeader->scale[feature];
+        }
+    }
+
+    // IVF: около sqrt(N) списков, центроиды - k-средних по выборке до 16k векторов,
+    // начальные центры берутся равномерно по банку, так что сборка повторяема
+    int numLists = juce::jlimit(1, 1024, juce::roundToInt(std::sqrt(static_cast<double>(count))));
+    std::vector<float> centres(static_cast<size_t>(numLists) * dimension);
+    for (int list = 0; list < numLists; ++list) {
+        int preset = static_cast<int>(static_cast<juce::int64>(list) * count / numLists);
+        std::memcpy(centres.data() + static_cast<size_t>(list) * dimension, features.data() + static_cast<size_t>(preset) * dimension, sizeof(float) * dimension);
+    }
+    int sampleStep = std::max(1, count / 16384);
+    std::vector<double> sums(static_cast<size_t>(numLists) * dimension);
+    std::vector<int> sizes(numLists);
+    for (int iteration = 0; iteration < 8 && numLists > 1; ++iteration) {
+        std::fill(sums.begin(), sums.end(), 0.0);
+        std::fill(sizes.begin(), sizes.end(), 0);
+        for (int preset = 0; preset < count; preset += sampleStep) {
+            const float* vector = features.data() + static_cast<size_t>(preset) * dimension;
+            int list = findNearest(vector, centres, numLists);
+            for (int feature = 0; feature < dimension; ++feature) {
+                sums[static_cast<size_t>(list) * dimension + feature] += vector[feature];
+            }
+            ++sizes[list];
+        }
+        // Пустой список сохраняет прежний центр
+        for (int list = 0; list < numLists; ++list) {
+            for (int feature = 0; feature < dimension && sizes[list] > 0; ++feature) {
+                centres[static_cast<size_t>(list) * dimension + feature] = static_cast<float>(sums[static_cast<size_t>(list) * dimension + feature] / sizes[list]);
+            }
+        }
+    }
+
+    std::vector<int> assignments(count);
+    std::vector<std::uint32_t> listStarts(numLists + 1, 0);
+    for (int preset = 0; preset < count; ++preset) {
+        assignments[preset] = findNearest(features.data() + static_cast<size_t>(preset) * dimension, centres, numLists);
+        ++listStarts[assignments[preset] + 1];
+    }
+    for (int list = 0; list < numLists; ++list) {
+        listStarts[list + 1] += listStarts[list];
+    }
+    std::vector<std::uint32_t> order(count);
+    std::vector<std::uint32_t> fill(listStarts.begin(), listStarts.end() - 1);
+    for (int preset = 0; preset < count; ++preset) {
+        order[fill[assignments[preset]]++] = static_cast<std::uint32_t>(preset);
+    }
+
+    indexHeader->magic = magic;
+    indexHeader->version = version;
+    indexHeader->numDimensions = dimension;
+    indexHeader->numVectors = static_cast<std::uint32_t>(count);
+    indexHeader->numLists = static_cast<std::uint32_t>(numLists);
+    indexHeader->bankSize = static_cast<std::uint64_t>(bankFile.getSize());
+    indexHeader->vectorsOffset = alignTo(sizeof(Header), 64);
+    indexHeader->presetsOffset = indexHeader->vectorsOffset + static_cast<std::uint64_t>(count) * dimension * sizeof(float);
+    indexHeader->listsOffset = indexHeader->presetsOffset + static_cast<std::uint64_t>(count) * sizeof(std::uint32_t);
+    indexHeader->centroidsOffset = alignTo(indexHeader->listsOffset + (numLists + 1) * sizeof(std::uint32_t), 64);
+
+    juce::TemporaryFile temporaryFile(indexFile);
+    {
+        juce::FileOutputStream stream(temporaryFile.getFile());
+        if (stream.failedToOpen()) {
+            return false;
+        }
+        static const char padding[64] = {};
+        stream.write(indexHeader.get(), sizeof(Header));
+        stream.write(padding, static_cast<size_t>(indexHeader->vectorsOffset - sizeof(Header)));
+        for (std::uint32_t preset : order) {
+            stream.write(features.data() + static_cast<size_t>(preset) * dimension, sizeof(float) * dimension);
+        }
+        stream.write(order.data(), order.size() * sizeof(std::uint32_t));
+        stream.write(listStarts.data(), listStarts.size() * sizeof(std::uint32_t));
+        stream.write(padding, static_cast<size_t>(indexHeader->centroidsOffset - indexHeader->listsOffset - listStarts.size() * sizeof(std::uint32_t)));
+        stream.write(centres.data(), centres.size() * sizeof(float));
+        stream.flush();
+        if (stream.getStatus().failed()) {
+            return false;
+        }
+    }
+    return temporaryFile.overwriteTargetFileWithTemporary();
+}
@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+
+    SimilarityIndex.h
+    Created: 27 Oct 2026 4:58:30pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "PresetBank.h"
+
+// Поиск похожих звуков. Каждый пресет коротко рендерится (одна нота с отпусканием),
+// из звука берутся признаки: кепстр мел-полос, центроид и плоскость спектра, форма
+// огибающей. Векторы нормируются по всему банку и лежат в отдельном файле рядом с банком,
+// сгруппированные по спискам IVF: запрос сравнивается с центроидами списков и
+// просматривает только ближайшие. Расстояние считается в SIMD-регистрах.
+class SimilarityIndex {
+public:
+    using Vec = juce::dsp::SIMDRegister<float>;
+
+    static constexpr std::uint32_t magic = 0x534d4653;   // "SFMS"
+    static constexpr std::uint32_t version = 1;
+    static constexpr int dimension = 32;
+    static constexpr int numLanes = static_cast<int>(Vec::SIMDNumElements);
+    static constexpr int defaultProbes = 12;
+
+    struct Header {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint32_t numDimensions;
+        std::uint32_t numVectors;
+        std::uint32_t numLists;
+        std::uint32_t reserved;
+        std::uint64_t bankSize;        // по нему видно, что банк сменился и индекс устарел
+        std::uint64_t vectorsOffset;   // numVectors * dimension float, по спискам подряд
+        std::uint64_t presetsOffset;   // numVectors uint32 - номер пресета каждого вектора
+        std::uint64_t listsOffset;     // numLists + 1 uint32 - начала списков
+        std::uint64_t centroidsOffset; // numLists * dimension float
+        float mean[dimension];         // нормировка признаков: (x - mean) * scale
+        float scale[dimension];
+    };
+
+    struct Match {
+        int preset;
+        float distance;
+    };
+
+    bool open(const juce::File& indexFile, PresetBank& bank);
+    void close();
+    bool isOpen();
+    int getNumPresets();
+
+    // numProbes = 0 - полный перебор без списков
+    void findSimilar(int preset, int numResults, std::vector<Match>& matches, int numProbes = defaultProbes);
+    void search(const float* query, int numResults, std::vector<Match>& matches, int numProbes = defaultProbes, int excludedPreset = -1);
+
+    // Рендер и признаки - параллельно, по экземпляру синтезатора на поток
+    static bool build(const juce::File& bankFile, const juce::File& indexFile, int numThreads = 0);
+    static juce::File getIndexFile(const juce::File& bankFile);
+    static float distance(const float* a, const float* b);
+
+private:
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+    const Header* header = nullptr;
+    const float* vectors = nullptr;
+    const std::uint32_t* presets = nullptr;
+    const std::uint32_t* lists = nullptr;
+    const float* centroids = nullptr;
+    std::vector<int> rows;   // строка вектора по номеру пресета
+
+    void scanList(int list, const float* query, int numResults, int excludedPreset, std::vector<Match>& heap);
+};
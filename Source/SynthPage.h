@@ -0,0 +1,52 @@
+/*
+  ==============================================================================
+
+    SynthPage.h
+    Created: 22 Oct 2026 2:35:12pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+// Страница операторов: волны, октавы, огибающие, уровни и сетка модуляции 4x4.
+// Сетка и подписи статичны, поэтому рисуются один раз в картинку и потом только копируются.
+class SynthPage : public juce::Component {
+public:
+    SynthPage(SynthFMAudioProcessor& processor);
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+    void comboBoxChanged(juce::ComboBox* comboBoxThatHasChanged);
+    void refreshFromPatch(const PatchParameters& parameters);
+
+private:
+    SynthFMAudioProcessor& processor;
+    juce::ComboBox waveTypeSelector[4];
+    juce::Slider modulationDepthDials[4][4];
+    juce::ToggleButton enableModulation[4][4];
+    juce::Slider octaveDials[4];
+    juce::Slider detuneDials[4];
+    juce::Slider attackSliders[4];
+    juce::Slider decaySliders[4];
+    juce::Slider sustainSliders[4];
+    juce::Slider releaseSliders[4];
+    juce::Slider levelDials[4];
+
+    juce::Slider levelSlider;
+    juce::Label levelLabel;
+
+    juce::Label attackLabels[4];
+    juce::Label decayLabels[4];
+    juce::Label sustainLabels[4];
+    juce::Label releaseLabels[4];
+
+    juce::Image background;
+
+    void renderBackground(float scale);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SynthPage)
+};
@@ -0,0 +1,299 @@
+/*
+  ==============================================================================
+
+    Voice.cpp
+    Created: 19 Oct 2026 4:20:37pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#include "Voice.h"
+#include <cstddef>
+
+namespace {
+    constexpr int field(size_t offset) {
+        return static_cast<int>(offset / sizeof(float));
+    }
+
+    constexpr int operatorStride = field(sizeof(OperatorParameters));
+    constexpr int depthsBegin = field(offsetof(PatchParameters, modulationDepths));
+    constexpr int levelIndex = field(offsetof(PatchParameters, level));
+    constexpr int filterAttackIndex = field(offsetof(PatchParameters, filterAttack));
+    constexpr int filterDecayIndex = field(offsetof(PatchParameters, filterDecay));
+    constexpr int filterSustainIndex = field(offsetof(PatchParameters, filterSustain));
+    constexpr int filterReleaseIndex = field(offsetof(PatchParameters, filterRelease));
+}
+
+Voice::Voice()
+    : note(-1), channel(0), part(0), released(true), age(0) {
+    std::vector<Oscillator*> pointers;
+    for (auto& op : operators) {
+        pointers.push_back(&op);
+    }
+    matrix = ModulationMatrix(pointers);
+    matrix.setLevel(0.0f);
+}
+
+void Voice::start(int newNote, int newChannel, float pitch, juce::uint64 newAge) {
+    note = newNote;
+    channel = newChannel;
+    age = newAge;
+    released = false;
+    for (auto& op : operators) {
+        op.reset();
+        op.setPitch(pitch);
+        op.noteOn();
+    }
+    matrix.reset();
+    expression.reset(0.0f, 0.0f, 0.0f, 0.0f);
+    filterEnvelope.reset();
+    filterEnvelope.noteOn();
+}
+
+void Voice::release() {
+    released = true;
+    for (auto& op : operators) {
+        op.noteOff();
+    }
+    filterEnvelope.noteOff();
+}
+
+bool Voice::isActive() {
+    for (auto& op : operators) {
+        if (op.isActive()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Voice::isReleased() {
+    return released;
+}
+
+int Voice::getNote() {
+    return note;
+}
+
+int Voice::getChannel() {
+    return channel;
+}
+
+int Voice::getPart() {
+    return part;
+}
+
+void Voice::setPart(int newPart) {
+    part = newPart;
+}
+
+juce::uint64 Voice::getAge() {
+    return age;
+}
+
+void Voice::render(float* samples, float* envelopes, int stride, int startSample, int numSamples) {
+    // Рендер кусками между событиями ноты: без событий это один проход
+    int i = 0;
+    while (i < numSamples) {
+        int end = numSamples;
+        int next = expression.getNextSample();
+        if (next >= 0) {
+            if (next <= startSample + i) {
+                if (expression.apply(startSample + i)) {
+                    updatePitchBend();
+                }
+                continue;
+            }
+            end = std::min(end, next - startSample);
+        }
+        for (; i < end; ++i) {
+            samples[i * stride] = matrix.process();
+            envelopes[i * stride] = filterEnvelope.applyEnvelope(1.0f);
+        }
+    }
+}
+
+void Voice::saveSnapshot(Snapshot& snapshot) {
+    for (int i = 0; i < numOperators; ++i) {
+        snapshot.operators[i] = operators[i];
+    }
+    snapshot.matrix = matrix;
+    snapshot.filterEnvelope = filterEnvelope;
+}
+
+void Voice::restoreSnapshot(const Snapshot& snapshot) {
+    for (int i = 0; i < numOperators; ++i) {
+        operators[i] = snapshot.operators[i];
+    }
+    matrix = snapshot.matrix;
+    matrix.bind(operators);
+    filterEnvelope = snapshot.filterEnvelope;
+}
+
+void Voice::advance(int numSamples) {
+    for (int i = 0; i < numSamples; ++i) {
+        matrix.process();
+        filterEnvelope.applyEnvelope(1.0f);
+    }
+}
+
+bool Voice::isSettled() {
+    auto isSteady = [](ADSR::State state) { return state == ADSR::State::Sustain || state == ADSR::State::Idle; };
+    for (auto& op : operators) {
+        if (!isSteady(op.getEnvelopeState())) {
+            return false;
+        }
+    }
+    return isSteady(filterEnvelope.getState());
+}
+
+void Voice::setParameters(const PatchParameters& parameters) {
+    for (int i = 0; i < numOperators; ++i) {
+        const OperatorParameters& parameter = parameters.operators[i];
+        Oscillator& op = operators[i];
+        op.setWaveType(static_cast<Oscillator::WaveType>(juce::roundToInt(parameter.waveType)));
+        op.setLevel(parameter.level);
+        op.setOctave(juce::roundToInt(parameter.octave));
+        op.setDetune(parameter.detune);
+        // Скорости спада и затухания ADSR считаются от sustain, поэтому он первый
+        op.setSustainLevel(parameter.sustain);
+        op.setAttackTime(parameter.attack);
+        op.setDecayTime(parameter.decay);
+        op.setReleaseTime(parameter.release);
+    }
+    for (int modulator = 0; modulator < numOperators; ++modulator) {
+        for (int carrier = 0; carrier < numOperators; ++carrier) {
+            if (parameters.modulationEnabled[modulator][carrier] > 0.5f) {
+                matrix.setModulation(modulator, carrier, parameters.modulationDepths[modulator][carrier]);
+            }
+            else {
+                matrix.removeModulation(modulator, carrier);
+            }
+        }
+    }
+    matrix.setLevel(parameters.level);
+
+    filterEnvelope.setSustainLevel(parameters.filterSustain);
+    filterEnvelope.setAttackTime(parameters.filterAttack);
+    filterEnvelope.setDecayTime(parameters.filterDecay);
+    filterEnvelope.setReleaseTime(parameters.filterRelease);
+}
+
+void Voice::setParameter(const PatchParameters& parameters, int index) {
+    if (index < numOperators * operatorStride) {
+        int i = index / operatorStride;
+        const OperatorParameters& parameter = parameters.operators[i];
+        Oscillator& op = operators[i];
+        switch (index % operatorStride) {
+        case field(offsetof(OperatorParameters, waveType)):
+            op.setWaveType(static_cast<Oscillator::WaveType>(juce::roundToInt(parameter.waveType)));
+            break;
+        case field(offsetof(OperatorParameters, level)):
+            op.setLevel(parameter.level);
+            break;
+        case field(offsetof(OperatorParameters, octave)):
+            op.setOctave(juce::roundToInt(parameter.octave));
+            break;
+        case field(offsetof(OperatorParameters, detune)):
+            op.setDetune(parameter.detune);
+            break;
+        case field(offsetof(OperatorParameters, attack)):
+            op.setAttackTime(parameter.attack);
+            break;
+        case field(offsetof(OperatorParameters, sustain)):
+            // Спад и затухание считаются от sustain - пересчитываются вместе с ним
+            op.setSustainLevel(parameter.sustain);
+            op.setDecayTime(parameter.decay);
+            op.setReleaseTime(parameter.release);
+            break;
+        case field(offsetof(OperatorParameters, decay)):
+            op.setDecayTime(parameter.decay);
+            break;
+        case field(offsetof(OperatorParameters, release)):
+            op.setReleaseTime(parameter.release);
+            break;
+        }
+        return;
+    }
+    if (index >= depthsBegin && index < levelIndex) {
+        int cell = (index - depthsBegin) % (numOperators * numOperators);
+        int modulator = cell / numOperators;
+        int carrier = cell % numOperators;
+        if (parameters.modulationEnabled[modulator][carrier] > 0.5f) {
+            matrix.setModulation(modulator, carrier, parameters.modulationDepths[modulator][carrier]);
+        }
+        else {
+            matrix.removeModulation(modulator, carrier);
+        }
+        return;
+    }
+    switch (index) {
+    case levelIndex:
+        matrix.setLevel(parameters.level);
+        break;
+    case filterAttackIndex:
+        filterEnvelope.setAttackTime(parameters.filterAttack);
+        break;
+    case filterSustainIndex:
+        filterEnvelope.setSustainLevel(parameters.filterSustain);
+        filterEnvelope.setDecayTime(parameters.filterDecay);
+        filterEnvelope.setReleaseTime(parameters.filterRelease);
+        break;
+    case filterDecayIndex:
+        filterEnvelope.setDecayTime(parameters.filterDecay);
+        break;
+    case filterReleaseIndex:
+        filterEnvelope.setReleaseTime(parameters.filterRelease);
+        break;
+    }
+}
+
+void Voice::setExpression(float noteBend, float globalBend, float pressure, float timbre) {
+    expression.reset(noteBend, globalBend, pressure, timbre);
+    updatePitchBend();
+}
+
+void Voice::pushExpression(int sample, NoteExpression::Type type, float value) {
+    expression.push(sample, type, value);
+}
+
+void Voice::flushExpression() {
+    if (expression.flush()) {
+        updatePitchBend();
+    }
+}
+
+NoteExpression& Voice::getExpression() {
+    return expression;
+}
+
+void Voice::updatePitchBend() {
+    for (auto& op : operators) {
+        op.setPitchBend(expression.getPitchBend());
+    }
+}
+
+void Voice::setTables(const SharedTables* tables, const PitchTable* pitchTable) {
+    for (auto& op : operators) {
+        op.setTables(tables, pitchTable);
+    }
+}
+
+void Voice::setDraft(bool isDraft) {
+    for (auto& op : operators) {
+        op.setDraft(isDraft);
+    }
+}
+
+Oscillator& Voice::getOperator(int index) {
+    return operators[index];
+}
+
+ModulationMatrix& Voice::getMatrix() {
+    return matrix;
+}
+
+ADSR& Voice::getFilterEnvelope() {
+    return filterEnvelope;
+}
@@ -0,0 +1,87 @@
+/*
+  ==============================================================================
+
+    Voice.h
+    Created: 19 Oct 2026 4:20:37pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "Oscillator.h"
+#include "ModulationMatrix.h"
+#include "ADSR.h"
+#include "NoteExpression.h"
+#include "Patch.h"
+
+// Один голос полифонии: четыре оператора со своей матрицей модуляции
+// и огибающая фильтра. Сам фильтр живёт в VoiceFilterBank, по дорожке на голос.
+class Voice {
+public:
+    static constexpr int numOperators = 4;
+
+    Voice();
+
+    // pitch - высота в полутонах, как номер MIDI-ноты
+    void start(int newNote, int newChannel, float pitch, juce::uint64 newAge);
+    void release();
+    bool isActive();
+    bool isReleased();
+    int getNote();
+    int getChannel();
+    int getPart();
+    void setPart(int newPart);
+    juce::uint64 getAge();
+
+    // Пишет сэмплы и огибающую фильтра с шагом stride (раскладка VoiceFilterBank).
+    // startSample - позиция в блоке хоста, по ней применяются события выразительности.
+    void render(float* samples, float* envelopes, int stride, int startSample, int numSamples);
+
+    // Полностью переставляет операторы, матрицу и огибающую фильтра на параметры патча
+    void setParameters(const PatchParameters& parameters);
+    // Применяет одно поле плоского блока (номер - как в PatchParameters::data()).
+    // Поля фильтра, кроме огибающей, здесь не применяются: они живут в VoiceFilterBank
+    void setParameter(const PatchParameters& parameters, int index);
+    void setTables(const SharedTables* tables, const PitchTable* pitchTable);
+    void setDraft(bool isDraft);
+
+    void setExpression(float noteBend, float globalBend, float pressure, float timbre);
+    void pushExpression(int sample, NoteExpression::Type type, float value);
+    void flushExpression();
+    NoteExpression& getExpression();
+
+    // Всё, от чего зависит дальнейший звук ноты без внешних воздействий: с таким снимком
+    // голос можно вернуть в любую записанную точку (см. NoteCache)
+    struct Snapshot {
+        Oscillator operators[numOperators];
+        ModulationMatrix matrix;
+        ADSR filterEnvelope;
+    };
+    void saveSnapshot(Snapshot& snapshot);
+    void restoreSnapshot(const Snapshot& snapshot);
+    // Прокручивает голос на numSamples сэмплов без вывода и без событий выразительности
+    void advance(int numSamples);
+    // Все огибающие дошли до sustain или затихли - дальше нота звучит ровно
+    bool isSettled();
+
+    Oscillator& getOperator(int index);
+    ModulationMatrix& getMatrix();
+    ADSR& getFilterEnvelope();
+
+private:
+    Oscillator operators[numOperators];
+    ModulationMatrix matrix;
+    ADSR filterEnvelope;
+    NoteExpression expression;
+    int note;
+    int channel;
+    int part;
+    bool released;
+    juce::uint64 age;
+
+    void updatePitchBend();
+
+    JUCE_DECLARE_NON_COPYABLE(Voice)
+};
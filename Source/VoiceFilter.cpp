@@ -0,0 +1,119 @@
+/*
+  ==============================================================================
+
+    VoiceFilter.cpp
+    Created: 19 Oct 2026 3:48:10pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#include "VoiceFilter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// 2^x без вызова библиотеки: целая часть идёт прямо в экспоненту float
+static inline float fastExp2(float x) {
+    x = std::min(30.0f, std::max(-30.0f, x));
+    float whole = std::floor(x);
+    float f = x - whole;
+    float p = 1.0f + f * (0.6951786f + f * (0.2261280f + f * 0.0780724f));
+    int32_t bits = (static_cast<int32_t>(whole) + 127) << 23;
+    float scale;
+    std::memcpy(&scale, &bits, sizeof(float));
+    return p * scale;
+}
+
+// Паде [5/4] для tan на [0, 0.49 * pi], относительная ошибка меньше 0.03%
+static inline float fastTan(float x) {
+    float x2 = x * x;
+    return x * (945.0f - x2 * (105.0f - x2)) / (945.0f - x2 * (420.0f - 15.0f * x2));
+}
+
+VoiceFilterBank::VoiceFilterBank()
+    : sampleRate(48000.0f), resonances{}, envelopeAmounts{}, dampings{}, inputMixes{}, bandMixes{}, lowMixes{}, baseCutoffs{},
+    ic1eq{}, ic2eq{}, cutoffModulation{} {
+    modes.fill(Off);
+    cutoffs.fill(20000.0f);
+}
+
+void VoiceFilterBank::setSampleRate(float newSampleRate) {
+    sampleRate = newSampleRate;
+}
+
+void VoiceFilterBank::setSettings(int voice, Mode mode, float frequency, float resonance, float envelopeOctaves) {
+    modes[voice] = mode;
+    cutoffs[voice] = frequency;
+    resonances[voice] = std::min(1.0f, std::max(0.0f, resonance));
+    envelopeAmounts[voice] = envelopeOctaves;
+}
+
+void VoiceFilterBank::setCutoffModulation(int voice, float octaves) {
+    cutoffModulation[voice] = octaves;
+}
+
+void VoiceFilterBank::resetVoice(int voice) {
+    ic1eq[voice] = 0.0f;
+    ic2eq[voice] = 0.0f;
+    cutoffModulation[voice] = 0.0f;
+}
+
+void VoiceFilterBank::process(float* samples, const float* envelopes, int numSamples, int firstVoice, int lastVoice) {
+    // Все режимы - линейная комбинация входа, полосового и НЧ выходов,
+    // так что разные режимы на соседних дорожках не мешают векторизации
+    bool isFiltering = false;
+    for (int v = firstVoice; v < lastVoice; ++v) {
+        float k = 2.0f - 1.95f * resonances[v];
+        float inputMix = 0.0f, bandMix = 0.0f, lowMix = 0.0f;
+        switch (modes[v]) {
+        case LowPass:  lowMix = 1.0f; break;
+        case HighPass: inputMix = 1.0f; bandMix = -k; lowMix = -1.0f; break;
+        case BandPass: bandMix = 1.0f; break;
+        case Notch:    inputMix = 1.0f; bandMix = -k; break;
+        case Off:      inputMix = 1.0f; break;
+        }
+        dampings[v] = k;
+        inputMixes[v] = inputMix;
+        bandMixes[v] = bandMix;
+        lowMixes[v] = lowMix;
+        baseCutoffs[v] = cutoffs[v] / sampleRate;
+        isFiltering |= modes[v] != Off;
+    }
+    if (!isFiltering) {
+        return;
+    }
+
+    const float maxCutoff = 0.49f;
+    const float pi = juce::MathConstants<float>::pi;
+    float* ic1 = ic1eq.data();
+    float* ic2 = ic2eq.data();
+    const float* modulation = cutoffModulation.data();
+    const float* envelopeAmount = envelopeAmounts.data();
+    const float* damping = dampings.data();
+    const float* inputMix = inputMixes.data();
+    const float* bandMix = bandMixes.data();
+    const float* lowMix = lowMixes.data();
+    const float* baseCutoff = baseCutoffs.data();
+
+    for (int i = 0; i < numSamples; ++i) {
+        float* x = samples + i * maxVoices;
+        const float* env = envelopes + i * maxVoices;
+        for (int v = firstVoice; v < lastVoice; ++v) {
+            float normalised = std::min(maxCutoff, baseCutoff[v] * fastExp2(envelopeAmount[v] * env[v] + modulation[v]));
+            float g = fastTan(pi * normalised);
+            float a1 = 1.0f / (1.0f + g * (g + damping[v]));
+            float a2 = g * a1;
+            float a3 = g * a2;
+
+            float v3 = x[v] - ic2[v];
+            float v1 = a1 * ic1[v] + a2 * v3;
+            float v2 = ic2[v] + a2 * ic1[v] + a3 * v3;
+            ic1[v] = 2.0f * v1 - ic1[v];
+            ic2[v] = 2.0f * v2 - ic2[v];
+
+            x[v] = inputMix[v] * x[v] + bandMix[v] * v1 + lowMix[v] * v2;
+        }
+    }
+}
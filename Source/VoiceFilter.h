@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    VoiceFilter.h
+    Created: 19 Oct 2026 3:48:10pm
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+
+// Банк TPT state-variable фильтров (Zavalishin), по одному на голос.
+// Состояние хранится по дорожкам: сэмплы всех голосов лежат подряд, поэтому
+// внутренний цикл идёт по голосам и векторизуется. Срез меняется на каждом сэмпле
+// от огибающей голоса, tan берётся рациональным приближением. Режим и срез у каждой
+// дорожки свои - голоса разных партий мультитембрального режима фильтруются вместе.
+class VoiceFilterBank {
+public:
+    enum Mode {
+        Off,
+        LowPass,
+        HighPass,
+        BandPass,
+        Notch
+    };
+
+    static constexpr int maxVoices = 64;
+    static constexpr int blockSize = 32;
+
+    VoiceFilterBank();
+
+    void setSampleRate(float newSampleRate);
+    void setSettings(int voice, Mode mode, float frequency, float resonance, float envelopeOctaves);
+    void setCutoffModulation(int voice, float octaves);
+    void resetVoice(int voice);
+
+    // samples и envelopes: [sample * maxVoices + voice], обрабатываются голоса [firstVoice, lastVoice).
+    // Непересекающиеся диапазоны можно обрабатывать из разных потоков.
+    void process(float* samples, const float* envelopes, int numSamples, int firstVoice, int lastVoice);
+
+private:
+    float sampleRate;
+
+    std::array<Mode, maxVoices> modes;
+    std::array<float, maxVoices> cutoffs;
+    std::array<float, maxVoices> resonances;
+    std::array<float, maxVoices> envelopeAmounts;
+
+    // Коэффициенты дорожек, пересчитываются раз на блок. Всё, что пишется при обработке,
+    // выровнено по строке кэша, чтобы соседние диапазоны голосов не делили строки.
+    alignas(64) std::array<float, maxVoices> dampings;
+    alignas(64) std::array<float, maxVoices> inputMixes;
+    alignas(64) std::array<float, maxVoices> bandMixes;
+    alignas(64) std::array<float, maxVoices> lowMixes;
+    alignas(64) std::array<float, maxVoices> baseCutoffs;
+
+    alignas(64) std::array<float, maxVoices> ic1eq;
+    alignas(64) std::array<float, maxVoices> ic2eq;
+    std::array<float, maxVoices> cutoffModulation;
+};
@@ -0,0 +1,245 @@
+/*
+  ==============================================================================
+
+    Waveshaper.cpp
+    Created: 19 Oct 2026 11:26:54am
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#include "Waveshaper.h"
+#include <cmath>
+
+// Порог, ниже которого разделённая разность плохо обусловлена и заменяется значением в середине
+static constexpr double illConditionedTolerance = 1.0e-5;
+static constexpr double ln2 = 0.69314718055994530942;
+static constexpr double piSquared = 9.86960440108935861883;
+
+// Li2(-u) для u в [0, 1] через Li2(z) = -Li2(z / (z - 1)) - ln^2(1 - z) / 2,
+// после чего ряд сходится по степеням аргумента не больше 1/2.
+static double negativeDilogarithm(double u) {
+    double w = u / (1.0 + u);
+    double term = w;
+    double sum = 0.0;
+    for (int k = 1; k <= 40 && term > 1.0e-17; ++k) {
+        sum += term / static_cast<double>(k * k);
+        term *= w;
+    }
+    double logTerm = std::log1p(u);
+    return -sum - 0.5 * logTerm * logTerm;
+}
+
+struct TanhShape {
+    static double f(double x) { return Waveshaper::fastTanh(static_cast<float>(x)); }
+    static double F1(double x) {
+        double a = std::abs(x);
+        return a + std::log1p(std::exp(-2.0 * a)) - ln2;
+    }
+    static double F2(double x) {
+        double a = std::abs(x);
+        double value = 0.5 * a * a - ln2 * a + 0.5 * negativeDilogarithm(std::exp(-2.0 * a)) + piSquared / 24.0;
+        return x < 0.0 ? -value : value;
+    }
+};
+
+// Кубический мягкий клиппер: x - x^3 / 3 внутри [-1, 1], полка 2/3 снаружи
+struct SoftClipShape {
+    static double f(double x) {
+        if (x > 1.0) return 2.0 / 3.0;
+        if (x < -1.0) return -2.0 / 3.0;
+        return x - x * x * x / 3.0;
+    }
+    static double F1(double x) {
+        double a = std::abs(x);
+        if (a > 1.0) return 2.0 / 3.0 * a - 0.25;
+        double x2 = x * x;
+        return 0.5 * x2 - x2 * x2 / 12.0;
+    }
+    static double F2(double x) {
+        double a = std::abs(x);
+        if (a > 1.0) {
+            double value = a * a / 3.0 - 0.25 * a + 1.0 / 15.0;
+            return x < 0.0 ? -value : value;
+        }
+        double x3 = x * x * x;
+        return x3 / 6.0 - x3 * x * x / 60.0;
+    }
+};
+
+// Сдвинутый мягкий клиппер: чётные гармоники, постоянная составляющая вычитается
+struct AsymmetricShape {
+    static constexpr double bias = 0.3;
+    static double offset() { return SoftClipShape::f(bias); }
+    static double f(double x) { return SoftClipShape::f(x + bias) - offset(); }
+    static double F1(double x) { return SoftClipShape::F1(x + bias) - offset() * x; }
+    static double F2(double x) { return SoftClipShape::F2(x + bias) - 0.5 * offset() * x * x; }
+};
+
+// Синусный фолдер: при большом усилении сигнал заворачивается обратно
+struct FoldbackShape {
+    static double f(double x) { return std::sin(x); }
+    static double F1(double x) { return -std::cos(x); }
+    static double F2(double x) { return -std::sin(x); }
+};
+
+Waveshaper::Waveshaper(Curve curve, Antialiasing antialiasing)
+    : curve(curve), antialiasing(antialiasing), input{}, antiderivative{} {}
+
+void Waveshaper::setCurve(Curve newCurve) {
+    if (newCurve != curve) {
+        curve = newCurve;
+        reset();
+    }
+}
+
+void Waveshaper::setAntialiasing(Antialiasing newAntialiasing) {
+    if (newAntialiasing != antialiasing) {
+        antialiasing = newAntialiasing;
+        reset();
+    }
+}
+
+void Waveshaper::reset() {
+    states.fill(ChannelState());
+}
+
+float Waveshaper::fastTanh(float x) {
+    // Цепная дробь Ламберта 7/6; за |x| > 4.97 ошибка уже меньше ограничения до 1
+    float x2 = x * x;
+    float numerator = x * (135135.0f + x2 * (17325.0f + x2 * (378.0f + x2)));
+    float denominator = 135135.0f + x2 * (62370.0f + x2 * (3150.0f + x2 * 28.0f));
+    return juce::jlimit(-1.0f, 1.0f, numerator / denominator);
+}
+
+void Waveshaper::fastTanh(float* data, int numSamples) {
+    // Без ветвлений, чтобы компилятор векторизовал цикл
+    for (int i = 0; i < numSamples; ++i) {
+        float x = std::min(4.97f, std::max(-4.97f, data[i]));
+        float x2 = x * x;
+        float numerator = x * (135135.0f + x2 * (17325.0f + x2 * (378.0f + x2)));
+        float denominator = 135135.0f + x2 * (62370.0f + x2 * (3150.0f + x2 * 28.0f));
+        data[i] = numerator / denominator;
+    }
+}
+
+void Waveshaper::processBlock(juce::AudioBuffer<float>& buffer, float inputGain) {
+    int numChannels = std::min(buffer.getNumChannels(), maxChannels);
+    for (int channel = 0; channel < numChannels; ++channel) {
+        float* data = buffer.getWritePointer(channel);
+        for (int start = 0; start < buffer.getNumSamples(); start += maxBlockSize) {
+            int numSamples = std::min(maxBlockSize, buffer.getNumSamples() - start);
+            switch (curve) {
+            case Tanh:
+                processChannel<TanhShape>(data + start, numSamples, inputGain, states[channel]);
+                break;
+            case SoftClip:
+                processChannel<SoftClipShape>(data + start, numSamples, inputGain, states[channel]);
+                break;
+            case Asymmetric:
+                processChannel<AsymmetricShape>(data + start, numSamples, inputGain, states[channel]);
+                break;
+            case Foldback:
+                processChannel<FoldbackShape>(data + start, numSamples, inputGain, states[channel]);
+                break;
+            }
+        }
+    }
+}
+
+template <typename Shape>
+void Waveshaper::processChannel(float* data, int numSamples, float inputGain, ChannelState& state) {
+    switch (antialiasing) {
+    case None:
+        processNone<Shape>(data, numSamples, inputGain);
+        break;
+    case FirstOrder:
+        processFirstOrder<Shape>(data, numSamples, inputGain, state);
+        break;
+    case SecondOrder:
+        processSecondOrder<Shape>(data, numSamples, inputGain, state);
+        break;
+    }
+}
+
+template <typename Shape>
+void Waveshaper::processNone(float* data, int numSamples, float inputGain) {
+    juce::FloatVectorOperations::multiply(data, inputGain, numSamples);
+    if constexpr (std::is_same_v<Shape, TanhShape>) {
+        fastTanh(data, numSamples);
+    }
+    else {
+        for (int i = 0; i < numSamples; ++i) {
+            data[i] = static_cast<float>(Shape::f(data[i]));
+        }
+    }
+}
+
+template <typename Shape>
+void Waveshaper::processFirstOrder(float* data, int numSamples, float inputGain, ChannelState& state) {
+    for (int i = 0; i < numSamples; ++i) {
+        input[i] = static_cast<double>(data[i] * inputGain);
+    }
+    for (int i = 0; i < numSamples; ++i) {
+        antiderivative[i] = Shape::F1(input[i]);
+    }
+
+    double x1 = state.x1;
+    double F1x1 = state.F1x1;
+    for (int i = 0; i < numSamples; ++i) {
+        double x0 = input[i];
+        double F1x0 = antiderivative[i];
+        double dx = x0 - x1;
+        double y = std::abs(dx) < illConditionedTolerance ? Shape::f(0.5 * (x0 + x1)) : (F1x0 - F1x1) / dx;
+        data[i] = static_cast<float>(y);
+        x1 = x0;
+        F1x1 = F1x0;
+    }
+    state.x1 = x1;
+    state.F1x1 = F1x1;
+}
+
+template <typename Shape>
+void Waveshaper::processSecondOrder(float* data, int numSamples, float inputGain, ChannelState& state) {
+    for (int i = 0; i < numSamples; ++i) {
+        input[i] = static_cast<double>(data[i] * inputGain);
+    }
+    for (int i = 0; i < numSamples; ++i) {
+        antiderivative[i] = Shape::F2(input[i]);
+    }
+
+    double x1 = state.x1;
+    double x2 = state.x2;
+    double F2x1 = state.F2x1;
+    double D1 = state.D1;
+    for (int i = 0; i < numSamples; ++i) {
+        double x0 = input[i];
+        double F2x0 = antiderivative[i];
+
+        double dx = x0 - x1;
+        double D0 = std::abs(dx) < illConditionedTolerance ? Shape::F1(0.5 * (x0 + x1)) : (F2x0 - F2x1) / dx;
+
+        double y;
+        double span = x0 - x2;
+        if (std::abs(span) < illConditionedTolerance) {
+            double xBar = 0.5 * (x0 + x2);
+            double delta = xBar - x1;
+            y = std::abs(delta) < illConditionedTolerance
+                ? Shape::f(0.5 * (xBar + x1))
+                : 2.0 / delta * (Shape::F1(xBar) + (Shape::F2(x1) - Shape::F2(xBar)) / delta);
+        }
+        else {
+            y = 2.0 * (D0 - D1) / span;
+        }
+        data[i] = static_cast<float>(y);
+
+        x2 = x1;
+        x1 = x0;
+        F2x1 = F2x0;
+        D1 = D0;
+    }
+    state.x1 = x1;
+    state.x2 = x2;
+    state.F2x1 = F2x1;
+    state.D1 = D1;
+}
@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    Waveshaper.h
+    Created: 19 Oct 2026 11:26:54am
+    Author:  freulaeuxx
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+
+// Нелинейность с антиалиасингом через первообразные (ADAA). Вместо f(x[n])
+// считается разделённая разность первообразной, что подавляет алиасинг без передискретизации.
+// Первый порядок задерживает сигнал на полсэмпла, второй - на сэмпл.
+class Waveshaper {
+public:
+    enum Curve {
+        Tanh,
+        SoftClip,
+        Asymmetric,
+        Foldback
+    };
+
+    enum Antialiasing {
+        None,
+        FirstOrder,
+        SecondOrder
+    };
+
+    static constexpr int maxChannels = 2;
+    static constexpr int maxBlockSize = 64;
+
+    Waveshaper(Curve curve = Tanh, Antialiasing antialiasing = FirstOrder);
+
+    void setCurve(Curve newCurve);
+    void setAntialiasing(Antialiasing newAntialiasing);
+    void reset();
+    void processBlock(juce::AudioBuffer<float>& buffer, float inputGain);
+
+    static float fastTanh(float x);
+    static void fastTanh(float* data, int numSamples);
+
+private:
+    struct ChannelState {
+        double x1 = 0.0;
+        double x2 = 0.0;
+        double F1x1 = 0.0;
+        double F2x1 = 0.0;
+        double D1 = 0.0;
+    };
+
+    Curve curve;
+    Antialiasing antialiasing;
+    std::array<ChannelState, maxChannels> states;
+    std::array<double, maxBlockSize> input;
+    std::array<double, maxBlockSize> antiderivative;
+
+    template <typename Shape> void processNone(float* data, int numSamples, float inputGain);
+    template <typename Shape> void processFirstOrder(float* data, int numSamples, float inputGain, ChannelState& state);
+    template <typename Shape> void processSecondOrder(float* data, int numSamples, float inputGain, ChannelState& state);
+    template <typename Shape> void processChannel(float* data, int numSamples, float inputGain, ChannelState& state);
+};